@@ -1,5 +1,18 @@
+glslc src/shader/adaptive_tile.comp -o bin/shader/adaptive_tile.comp.spv
 glslc src/shader/ray_trace.comp -o bin/shader/ray_trace.comp.spv
+glslc src/shader/reconstruct.comp -o bin/shader/reconstruct.comp.spv
+glslc src/shader/wavefront_generate.comp -o bin/shader/wavefront_generate.comp.spv
+glslc src/shader/wavefront_dispatch.comp -o bin/shader/wavefront_dispatch.comp.spv
+glslc src/shader/wavefront_extend.comp -o bin/shader/wavefront_extend.comp.spv
+glslc src/shader/wavefront_sort_key.comp -o bin/shader/wavefront_sort_key.comp.spv
+glslc src/shader/wavefront_sort_scan.comp -o bin/shader/wavefront_sort_scan.comp.spv
+glslc src/shader/wavefront_sort_scatter.comp -o bin/shader/wavefront_sort_scatter.comp.spv
+glslc src/shader/wavefront_shade_ggx.comp -o bin/shader/wavefront_shade_ggx.comp.spv
+glslc src/shader/wavefront_shade_lambert.comp -o bin/shader/wavefront_shade_lambert.comp.spv
+glslc src/shader/wavefront_connect.comp -o bin/shader/wavefront_connect.comp.spv
+glslc src/shader/wavefront_finish.comp -o bin/shader/wavefront_finish.comp.spv
 glslc src/shader/sampling.vert -o bin/shader/sampling.vert.spv
 glslc src/shader/sampling.frag -o bin/shader/sampling.frag.spv
 glslc src/shader/forward_pass.vert -o bin/shader/forward_pass.vert.spv
 glslc src/shader/forward_pass.frag -o bin/shader/forward_pass.frag.spv
+glslc src/shader/visibility_pass.frag -o bin/shader/visibility_pass.frag.spv
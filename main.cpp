@@ -1,18 +1,171 @@
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #define VMA_IMPLEMENTATION
 #include "vk_mem_alloc.h"
 
 #include "src/engine/app/app.hpp"
 
+// Reads the whole of a number argument, false if it is not one
+static bool parseFloatArgument(const std::string &text, float &value) {
+    try {
+        size_t length = 0;
+        value = std::stof(text, &length);
+
+        return length == text.size();
+    } catch (const std::logic_error &) {
+        return false;
+    }
+}
+
+// std::stoul takes a minus sign and wraps, so only plain digits are accepted here
+static bool parseUintArgument(const std::string &text, uint32_t &value) {
+    if (text.empty() || !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+
+    try {
+        unsigned long number = std::stoul(text);
+        if (number > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+
+        value = static_cast<uint32_t>(number);
+        return true;
+    } catch (const std::out_of_range &) {
+        return false;
+    }
+}
+
 int main(int argc, char const *argv[])
 {
-    nugiEngine::EngineApp app{};
+    // engine [--wavefront] [--sort-rays] [--adaptive <error>] [--tiled <milliseconds>] [--checkerboard | --half-res] [--temporal <frames>] [--visibility] [--animate] [--record-per-frame] [--headless <samples> <output.ppm|output.pfm> | --benchmark <samples>]
+    std::vector<std::string> args{argv + 1, argv + argc};
+
+    auto wavefrontArg = std::find(args.begin(), args.end(), "--wavefront");
+    bool isWavefront = wavefrontArg != args.end();
+    if (isWavefront) {
+        args.erase(wavefrontArg);
+    }
+
+    // Sorting reorders the wavefront queues, so it implies --wavefront
+    auto sortRaysArg = std::find(args.begin(), args.end(), "--sort-rays");
+    bool isRaySorted = sortRaysArg != args.end();
+    if (isRaySorted) {
+        args.erase(sortRaysArg);
+    }
+
+    // Relative standard error at which a pixel stops being traced, e.g. 0.01
+    float errorThreshold = 0.0f;
+    auto adaptiveArg = std::find(args.begin(), args.end(), "--adaptive");
+    if (adaptiveArg != args.end()) {
+        if (std::next(adaptiveArg) == args.end() || !parseFloatArgument(*std::next(adaptiveArg), errorThreshold)) {
+            std::cerr << "usage: " << argv[0] << " --adaptive <error> [...]\n";
+            return EXIT_FAILURE;
+        }
+
+        args.erase(adaptiveArg, std::next(adaptiveArg, 2));
+    }
+
+    // GPU time the trace of one frame should take, only part of the image is traced per frame if needed
+    float tileFrameTime = 0.0f;
+    auto tiledArg = std::find(args.begin(), args.end(), "--tiled");
+    if (tiledArg != args.end()) {
+        if (std::next(tiledArg) == args.end() || !parseFloatArgument(*std::next(tiledArg), tileFrameTime)) {
+            std::cerr << "usage: " << argv[0] << " --tiled <milliseconds> [...]\n";
+            return EXIT_FAILURE;
+        }
+
+        args.erase(tiledArg, std::next(tiledArg, 2));
+    }
+
+    // Trace every second or every fourth pixel per sample and reconstruct the rest
+    nugiEngine::TraceMode traceMode = nugiEngine::TRACE_MODE_FULL;
+    auto checkerboardArg = std::find(args.begin(), args.end(), "--checkerboard");
+    if (checkerboardArg != args.end()) {
+        traceMode = nugiEngine::TRACE_MODE_CHECKERBOARD;
+        args.erase(checkerboardArg);
+    }
+
+    auto halfResArg = std::find(args.begin(), args.end(), "--half-res");
+    if (halfResArg != args.end()) {
+        if (traceMode != nugiEngine::TRACE_MODE_FULL) {
+            std::cerr << argv[0] << ": --checkerboard and --half-res can not be combined\n";
+            return EXIT_FAILURE;
+        }
+
+        traceMode = nugiEngine::TRACE_MODE_HALF;
+        args.erase(halfResArg);
+    }
+
+    // Samples of history a pixel may keep when the camera moves, reprojected into the new view
+    uint32_t maxHistory = 0;
+    auto temporalArg = std::find(args.begin(), args.end(), "--temporal");
+    if (temporalArg != args.end()) {
+        if (std::next(temporalArg) == args.end() || !parseUintArgument(*std::next(temporalArg), maxHistory)) {
+            std::cerr << "usage: " << argv[0] << " --temporal <frames> [...]\n";
+            return EXIT_FAILURE;
+        }
+
+        args.erase(temporalArg, std::next(temporalArg, 2));
+    }
+
+    // Rasterize primitive indices only and fetch the primary hit attributes from the scene buffers
+    auto visibilityArg = std::find(args.begin(), args.end(), "--visibility");
+    bool isVisibilityBuffer = visibilityArg != args.end();
+    if (isVisibilityBuffer) {
+        args.erase(visibilityArg);
+    }
+
+    // Spin a block in the middle of the scene, which restarts the accumulation on every frame
+    auto animateArg = std::find(args.begin(), args.end(), "--animate");
+    bool isAnimated = animateArg != args.end();
+    if (isAnimated) {
+        args.erase(animateArg);
+    }
+
+    // Record the commands of every frame again instead of reusing the ones recorded with the swap chain, to compare the two
+    auto recordPerFrameArg = std::find(args.begin(), args.end(), "--record-per-frame");
+    bool isRecordedPerFrame = recordPerFrameArg != args.end();
+    if (isRecordedPerFrame) {
+        args.erase(recordPerFrameArg);
+    }
+
+    bool isBenchmark = !args.empty() && args[0] == "--benchmark";
+    if (isBenchmark && args.size() < 2) {
+        std::cerr << "usage: " << argv[0] << " [--wavefront] [--sort-rays] --benchmark <samples>\n";
+        return EXIT_FAILURE;
+    }
+
+    bool isHeadless = !args.empty() && args[0] == "--headless";
+    if (isHeadless && args.size() < 3) {
+        std::cerr << "usage: " << argv[0] << " [--wavefront] [--sort-rays] --headless <samples> <output file>\n";
+        return EXIT_FAILURE;
+    }
+
+    // Accumulating a fixed number of samples needs a scene that holds still
+    if (isAnimated && (isHeadless || isBenchmark)) {
+        std::cerr << argv[0] << ": --animate only works in the interactive viewer\n";
+        return EXIT_FAILURE;
+    }
+
+    nugiEngine::EngineApp app{isHeadless || isBenchmark, isWavefront, isRaySorted, errorThreshold, tileFrameTime, traceMode, maxHistory, isVisibilityBuffer, 
+        isAnimated, isRecordedPerFrame};
 
     try {
-        app.run();
+        if (isBenchmark) {
+            app.runBenchmark(static_cast<uint32_t>(std::stoul(args[1])));
+        } else if (isHeadless) {
+            app.runHeadless(static_cast<uint32_t>(std::stoul(args[1])), args[2]);
+        } else {
+            app.run();
+        }
     } catch(const std::exception &e) {
         std::cerr << e.what() << "\n";
         return EXIT_FAILURE;
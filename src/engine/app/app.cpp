@@ -6,6 +6,7 @@
 #include <glm/gtc/constants.hpp>
 
 #include <stdexcept>
+#include <algorithm>
 #include <array>
 #include <string>
 #include <chrono>
@@ -15,59 +16,380 @@
 #include <thread>
 
 namespace nugiEngine {
-	EngineApp::EngineApp() {
-		this->renderer = std::make_unique<EngineHybridRenderer>(this->window, this->device);
+	EngineApp::EngineApp(bool isHeadless, bool isWavefront, bool isRaySorted, float errorThreshold, float tileFrameTime, TraceMode traceMode, uint32_t maxHistory, bool isVisibilityBuffer, 
+		bool isAnimated, bool isRecordedPerFrame) 
+		: window{isHeadless ? nullptr : std::make_unique<EngineWindow>(WIDTH, HEIGHT, APP_TITLE)}, usePrerecordedCommands{!isRecordedPerFrame}, 
+			useWavefront{isWavefront || isRaySorted}, 
+			useRaySorting{isRaySorted}, tileFrameTime{tileFrameTime}, isAnimated{isAnimated}
+	{
+		this->rayTraceUbo.errorThreshold = errorThreshold;
+		this->rayTraceUbo.traceMode = traceMode;
+		this->rayTraceUbo.maxHistory = maxHistory;
+		this->rayTraceUbo.isVisibilityBuffer = isVisibilityBuffer ? 1u : 0u;
+
+		if (isHeadless) {
+			this->renderer = std::make_unique<EngineHybridRenderer>(this->device, VkExtent2D{ WIDTH, HEIGHT });
+		} else {
+			this->renderer = std::make_unique<EngineHybridRenderer>(*this->window, this->device);
+		}
+
+		if (this->tileFrameTime > 0.0f) {
+			this->traceTimestamps = std::make_unique<EngineTimestampQuery>(this->device, EngineDevice::MAX_FRAMES_IN_FLIGHT, 
+				this->device.getAsyncComputeFamily());
+
+			if (!this->traceTimestamps->isSupported()) {
+				std::cout << "tiled rendering: no timestamps on the trace queue, the tile count per frame stays fixed" << std::endl;
+			}
+		}
+
+		this->uploader = std::make_shared<EngineBufferUploader>(this->device);
+		this->bvhTaskPool = std::make_unique<TaskPool>();
 
-		this->loadObjects();
-		this->loadQuadModels();
+		this->loadQuadModels(this->uploader);
+		this->uploader->flush();
+
+		// The scene is built and streamed in beside the render loop, which keeps presenting until it has landed
+		this->sceneLoader = std::async(std::launch::async, &EngineApp::loadObjects, this, this->uploader);
 		this->recreateSubRendererAndSubsystem();
 	}
 
 	EngineApp::~EngineApp() {}
 
+	bool EngineApp::pollSceneLoading() {
+		if (this->isSceneReady) {
+			return true;
+		}
+
+		if (!this->sceneUploaded.valid()) {
+			if (this->sceneLoader.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				return false;
+			}
+
+			this->sceneUploaded = this->sceneLoader.get();
+		}
+
+		if (this->sceneUploaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return false;
+		}
+
+		this->isSceneReady = true;
+		this->recreateSubRendererAndSubsystem();
+
+		return true;
+	}
+
 	void EngineApp::renderLoop() {
 		while (this->isRendering) {
-			if (this->renderer->acquireFrame()) {
-				uint32_t frameIndex = this->renderer->getFrameIndex();
-				uint32_t imageIndex = this->renderer->getImageIndex();
+			this->uploader->update();
+
+			if (!this->pollSceneLoading()) {
+				this->renderLoadingFrame();
+				continue;
+			}
+
+			if (this->isAnimated) {
+				this->animateObjects();
+			}
+
+			this->renderFrame();
+		}
+	}
+
+	void EngineApp::renderFrame() {
+		if (this->renderer->acquireFrame()) {
+			uint32_t frameIndex = this->renderer->getFrameIndex();
+			uint32_t imageIndex = this->renderer->getImageIndex();
+
+			this->updateCameraMotion();
+			this->updateTransforms();
+
+			if (this->tileFrameTime > 0.0f) {
+				this->updateTileRange(frameIndex);
+			}
+
+			this->rayTraceUbo.randomSeed = this->randomSeed;
+
+			// The statistics snapshot the trace reads was taken MAX_FRAMES_IN_FLIGHT frames ago
+			if (this->randomSeed == 0 || this->rayTraceUbo.isCameraMoved == 1u) {
+				this->statisticsAge = 0;
+			}
+
+			this->rayTraceUbo.isStatisticsStale = this->statisticsAge < EngineDevice::MAX_FRAMES_IN_FLIGHT ? 1u : 0u;
+			this->statisticsAge++;
+
+			this->rayTraceUniforms->writeGlobalData(frameIndex, this->rayTraceUbo);
+			this->rasterUniform->writeGlobalData(frameIndex, this->rasterUbo);
+			this->transformationModel->update(frameIndex);
+			this->objectModel->update(frameIndex);
+
+			std::shared_ptr<EngineCommandBuffer> rasterCommandBuffer, traceCommandBuffer, samplingCommandBuffer;
+
+			if (this->samplingCommandBuffers.empty()) {
+				rasterCommandBuffer = this->renderer->beginRasterCommand();
+				this->recordRasterCommand(rasterCommandBuffer, frameIndex);
+				this->renderer->endCommand(rasterCommandBuffer);
+
+				traceCommandBuffer = this->renderer->beginTraceCommand();
+				this->recordTraceCommand(traceCommandBuffer, frameIndex);
+				this->renderer->endCommand(traceCommandBuffer);
+
+				samplingCommandBuffer = this->renderer->beginCommand();
+				this->recordSamplingCommand(samplingCommandBuffer, frameIndex, imageIndex);
+				this->renderer->endCommand(samplingCommandBuffer);
+			} else {
+				uint32_t imageCount = static_cast<uint32_t>(this->renderer->getSwapChain()->imageCount());
+
+				rasterCommandBuffer = this->rasterCommandBuffers[frameIndex];
+				traceCommandBuffer = this->traceCommandBuffers[frameIndex];
+				samplingCommandBuffer = this->samplingCommandBuffers[frameIndex * imageCount + imageIndex];
+			}
+
+			this->renderer->submitFrameCommands(rasterCommandBuffer, traceCommandBuffer, samplingCommandBuffer);
+
+			if (this->traceTimestamps) {
+				this->traceTimestamps->submitted(frameIndex);
+			}
+
+			if (!this->renderer->presentFrame()) {
+				this->recreateSubRendererAndSubsystem();
+				this->randomSeed = 0;
+
+				return;
+			}
+
+			// Every frame adds one sample to the shared accumulation, whichever frame slot it ran in. 
+			// Tiled, that takes as many frames as it needs to get through all tiles once.
+			if (this->tileFrameTime > 0.0f) {
+				this->firstTile += this->rayTraceUbo.tileCount;
+				if (this->firstTile < this->tileTotal) {
+					return;
+				}
+
+				this->firstTile = 0;
+			}
+
+			this->randomSeed++;
+		}
+	}
+
+	// Queues a transform for the render thread, which applies it before its next frame
+	void EngineApp::setTransform(uint32_t transformIndex, glm::vec3 translation, glm::vec3 scale, glm::vec3 rotation) {
+		if (!this->isAnimated) {
+			throw std::runtime_error("only an animated scene can move its objects");
+		}
+
+		std::lock_guard<std::mutex> lock{this->transformMutex};
+		this->pendingTransforms.emplace_back(transformIndex, TransformComponent{ translation, scale, rotation });
+	}
+
+	// The transformation and object models are only ever touched from here, by the render thread
+	void EngineApp::updateTransforms() {
+		std::vector<std::pair<uint32_t, TransformComponent>> changedTransforms;
+
+		{
+			std::lock_guard<std::mutex> lock{this->transformMutex};
+			if (this->pendingTransforms.empty()) {
+				return;
+			}
+
+			changedTransforms.swap(this->pendingTransforms);
+		}
+
+		for (auto &&[transformIndex, transform] : changedTransforms) {
+			if (transformIndex >= this->transforms.size()) {
+				continue;
+			}
+
+			this->transforms[transformIndex]->translation = transform.translation;
+			this->transforms[transformIndex]->scale = transform.scale;
+			this->transforms[transformIndex]->rotation = transform.rotation;
+
+			this->transformationModel->markDirty(transformIndex);
+		}
+
+		// One refit for all moved objects, each frame's buffers catch up in their own update
+		this->objectModel->refit();
+
+		this->randomSeed = 0;
+		this->firstTile = 0;
+	}
+
+	// Turns the block of the animated scene about its centre, through setTransform like any other producer of transforms
+	void EngineApp::animateObjects() {
+		if (this->animationStart == std::chrono::high_resolution_clock::time_point{}) {
+			this->animationStart = std::chrono::high_resolution_clock::now();
+		}
+
+		float time = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - this->animationStart).count();
+		this->setTransform(this->animatedTransformIndex, glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.0f, time * ANIMATION_TURN_SPEED, 0.0f));
+	}
+
+	// Takes over the camera the main thread has moved since the last frame. Temporal accumulation reprojects 
+	// its history into the new view on this frame, without it the accumulation starts over.
+	void EngineApp::updateCameraMotion() {
+		this->rayTraceUbo.isCameraMoved = 0u;
+
+		{
+			std::lock_guard<std::mutex> lock{this->cameraMutex};
+			if (!this->isCameraMoved) {
+				return;
+			}
+
+			this->isCameraMoved = false;
+		}
+
+		glm::mat4 previousViewProjection = this->rasterUbo.projection * this->rasterUbo.view;
+		glm::vec3 previousOrigin = this->rayTraceUbo.origin;
+
+		this->updateCamera(this->renderer->getSwapChain()->width(), this->renderer->getSwapChain()->height());
+
+		if (this->rayTraceUbo.maxHistory > 0) {
+			this->rayTraceUbo.previousViewProjection = previousViewProjection;
+			this->rayTraceUbo.previousOrigin = previousOrigin;
+			this->rayTraceUbo.isCameraMoved = 1u;
+		} else {
+			this->randomSeed = 0;
+			this->firstTile = 0;
+		}
+	}
+
+	// Sizes the tile range of the frame from the trace time of the last frame in the same slot, 
+	// whose fence has been waited for by now
+	void EngineApp::updateTileRange(uint32_t frameIndex) {
+		float traceTime = 0.0f;
+
+		if (this->frameTileCounts[frameIndex] > 0 && this->traceTimestamps->getDuration(frameIndex, traceTime)) {
+			float tileCost = traceTime / static_cast<float>(this->frameTileCounts[frameIndex]);
+			this->tileCost = this->tileCost > 0.0f ? 0.8f * this->tileCost + 0.2f * tileCost : tileCost;
+
+			if (this->tileCost > 0.0f) {
+				float tileBudget = std::min(this->tileFrameTime / this->tileCost, static_cast<float>(this->tileTotal));
+				this->tileBudget = std::max(static_cast<uint32_t>(tileBudget), 1u);
+			}
+		}
+
+		this->rayTraceUbo.firstTile = this->firstTile;
+		this->rayTraceUbo.tileCount = std::min(this->tileBudget, this->tileTotal - this->firstTile);
+		this->frameTileCounts[frameIndex] = this->rayTraceUbo.tileCount;
+	}
+
+	// Without a dedicated compute family the trace runs on graphics queue 0 as well and the handovers are plain barriers
+	void EngineApp::recordRasterCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
+		uint32_t graphicsFamily = this->device.getFamilyIndices().graphicsFamily;
+		uint32_t computeFamily = this->device.getAsyncComputeFamily();
+
+		this->forwardPassSubRenderer->beginRenderPass(commandBuffer, frameIndex);
+		this->forwardPassRender->render(commandBuffer, this->forwardPassDescSet->getDescriptorSets(frameIndex), this->vertexModels);
+		this->forwardPassSubRenderer->endRenderPass(commandBuffer);
+
+		if (graphicsFamily != computeFamily) {
+			this->forwardPassSubRenderer->transferFrame(commandBuffer, frameIndex, graphicsFamily, computeFamily);
+		} else {
+			this->forwardPassSubRenderer->transferFrame(commandBuffer, frameIndex);
+		}
+	}
+
+	void EngineApp::recordTraceCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
+		uint32_t graphicsFamily = this->device.getFamilyIndices().graphicsFamily;
+		uint32_t computeFamily = this->device.getAsyncComputeFamily();
+
+		if (graphicsFamily != computeFamily) {
+			this->forwardPassSubRenderer->acquireFrame(commandBuffer, frameIndex, graphicsFamily, computeFamily);
+		}
+
+		if (this->traceTimestamps) {
+			this->traceTimestamps->begin(commandBuffer, frameIndex);
+		}
+
+		this->rayTraceImage->prepareFrame(commandBuffer, frameIndex);
+		this->adaptiveTileRender->render(commandBuffer, this->rayTraceDescSet->getDescriptorSets(frameIndex), 
+			this->adaptiveSampleBuffer->getActiveTileBuffer());
+
+		if (this->useWavefront) {
+			this->wavefrontRender->render(commandBuffer, this->rayTraceDescSet->getDescriptorSets(frameIndex), 
+				this->wavefrontDescSet->getDescriptorSet(), *this->wavefrontQueue);
+		} else {
+			this->traceRayRender->render(commandBuffer, this->rayTraceDescSet->getDescriptorSets(frameIndex), 
+				this->adaptiveSampleBuffer->getActiveTileBuffer());
+		}
+
+		if (this->reconstructRender) {
+			this->reconstructRender->render(commandBuffer, this->rayTraceDescSet->getDescriptorSets(frameIndex), 
+				this->adaptiveSampleBuffer->getActiveTileBuffer());
+		}
+
+		if (graphicsFamily != computeFamily) {
+			this->rayTraceImage->transferFrame(commandBuffer, frameIndex, computeFamily, graphicsFamily);
+		} else {
+			this->rayTraceImage->transferFrame(commandBuffer, frameIndex);
+		}
+
+		if (this->traceTimestamps) {
+			this->traceTimestamps->end(commandBuffer, frameIndex);
+		}
+	}
+
+	void EngineApp::recordSamplingCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, uint32_t imageIndex) {
+		uint32_t graphicsFamily = this->device.getFamilyIndices().graphicsFamily;
+		uint32_t computeFamily = this->device.getAsyncComputeFamily();
+
+		if (graphicsFamily != computeFamily) {
+			this->rayTraceImage->acquireFrame(commandBuffer, frameIndex, computeFamily, graphicsFamily);
+		}
+
+		this->accumulateImages->prepareFrame(commandBuffer);
+		this->adaptiveSampleBuffer->copyHistory(commandBuffer);
+		
+		this->swapChainSubRenderer->beginRenderPass(commandBuffer, imageIndex);
+		this->samplingRayRender->render(commandBuffer, this->samplingDescSet->getDescriptorSets(frameIndex), this->quadModels);
+		this->swapChainSubRenderer->endRenderPass(commandBuffer);
 
-				this->rayTraceUniforms->writeGlobalData(frameIndex, this->rayTraceUbo);
-				this->rasterUniform->writeGlobalData(frameIndex, this->rasterUbo);
+		this->rayTraceImage->finishFrame(commandBuffer, frameIndex);
+		this->accumulateImages->finishFrame(commandBuffer);
+		this->adaptiveSampleBuffer->finishFrame(commandBuffer, frameIndex);
+	}
 
-				auto commandBuffer = this->renderer->beginCommand();
+	void EngineApp::recordFrameCommands() {
+		uint32_t imageCount = static_cast<uint32_t>(this->renderer->getSwapChain()->imageCount());
 
-				this->forwardPassSubRenderer->beginRenderPass(commandBuffer, frameIndex);
-				this->forwardPassRender->render(commandBuffer, this->forwardPassDescSet->getDescriptorSets(frameIndex), this->vertexModels);
-				this->forwardPassSubRenderer->endRenderPass(commandBuffer);
+		this->rasterCommandBuffers = EngineCommandBuffer::createCommandBuffers(this->device, EngineDevice::MAX_FRAMES_IN_FLIGHT);
+		this->traceCommandBuffers = EngineCommandBuffer::createCommandBuffers(this->device, EngineDevice::MAX_FRAMES_IN_FLIGHT, 
+			this->device.getAsyncComputeCommandPool());
+		this->samplingCommandBuffers = EngineCommandBuffer::createCommandBuffers(this->device, EngineDevice::MAX_FRAMES_IN_FLIGHT * imageCount);
 
-				this->forwardPassSubRenderer->transferFrame(commandBuffer, frameIndex);
-				this->rayTraceImage->prepareFrame(commandBuffer, frameIndex);
+		for (uint32_t frameIndex = 0; frameIndex < EngineDevice::MAX_FRAMES_IN_FLIGHT; frameIndex++) {
+			this->rasterCommandBuffers[frameIndex]->beginReccuringCommand();
+			this->recordRasterCommand(this->rasterCommandBuffers[frameIndex], frameIndex);
+			this->rasterCommandBuffers[frameIndex]->endCommand();
 
-				this->traceRayRender->render(commandBuffer, this->rayTraceDescSet->getDescriptorSets(frameIndex), this->randomSeed);
+			this->traceCommandBuffers[frameIndex]->beginReccuringCommand();
+			this->recordTraceCommand(this->traceCommandBuffers[frameIndex], frameIndex);
+			this->traceCommandBuffers[frameIndex]->endCommand();
 
-				this->rayTraceImage->transferFrame(commandBuffer, frameIndex);
-				this->accumulateImages->prepareFrame(commandBuffer, frameIndex);
-				
-				this->swapChainSubRenderer->beginRenderPass(commandBuffer, imageIndex);
-				this->samplingRayRender->render(commandBuffer, this->samplingDescSet->getDescriptorSets(frameIndex), this->quadModels, this->randomSeed);
-				this->swapChainSubRenderer->endRenderPass(commandBuffer);
+			for (uint32_t imageIndex = 0; imageIndex < imageCount; imageIndex++) {
+				auto commandBuffer = this->samplingCommandBuffers[frameIndex * imageCount + imageIndex];
 
-				this->rayTraceImage->finishFrame(commandBuffer, frameIndex);
-				this->accumulateImages->finishFrame(commandBuffer, frameIndex);
+				commandBuffer->beginReccuringCommand();
+				this->recordSamplingCommand(commandBuffer, frameIndex, imageIndex);
+				commandBuffer->endCommand();
+			}
+		}
+	}
 
-				this->renderer->endCommand(commandBuffer);
-				this->renderer->submitRenderCommand(commandBuffer);
+	// Only clears the swapchain, nothing else exists before the scene has landed
+	void EngineApp::renderLoadingFrame() {
+		if (this->renderer->acquireFrame()) {
+			uint32_t imageIndex = this->renderer->getImageIndex();
+			auto commandBuffer = this->renderer->beginCommand();
 
-				if (!this->renderer->presentFrame()) {
-					this->recreateSubRendererAndSubsystem();
-					this->randomSeed = 0;
+			this->swapChainSubRenderer->beginRenderPass(commandBuffer, imageIndex);
+			this->swapChainSubRenderer->endRenderPass(commandBuffer);
 
-					continue;
-				}				
+			this->renderer->endCommand(commandBuffer);
+			this->renderer->submitRenderCommand(commandBuffer);
 
-				if (frameIndex + 1 == EngineDevice::MAX_FRAMES_IN_FLIGHT) {
-					this->randomSeed++;
-				}				
+			if (!this->renderer->presentFrame()) {
+				this->recreateSubRendererAndSubsystem();
 			}
 		}
 	}
@@ -79,32 +401,195 @@ namespace nugiEngine {
 		// this->rayTraceUniforms->writeGlobalData(0, this->globalUbo);
 		std::thread renderThread(&EngineApp::renderLoop, std::ref(*this));
 
-		while (!this->window.shouldClose()) {
-			this->window.pollEvents();
+		while (!this->window->shouldClose()) {
+			this->window->pollEvents();
 
-			/*auto newTime = std::chrono::high_resolution_clock::now();
+			auto newTime = std::chrono::high_resolution_clock::now();
 			float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
+			currentTime = newTime;
+
+			this->moveCamera(frameTime);
 
-			if (t == 10) {
+			/*if (t == 10) {
 				std::string appTitle = std::string(APP_TITLE) + std::string(" | FPS: ") + std::to_string((1.0f / frameTime));
 				glfwSetWindowTitle(this->window.getWindow(), appTitle.c_str());
 
 				t = 0;
 			} else {
 				t++;
-			}
-
-			currentTime = newTime;*/
+			}*/
 		}
 
 		this->isRendering = false;
 		renderThread.join();
 
+		// The render thread is gone, so this thread owns the queues now and can drain whatever is still streaming
+		if (this->sceneLoader.valid()) {
+			this->sceneLoader.get();
+		}
+
+		this->uploader->flush();
+
 		vkDeviceWaitIdle(this->device.getLogicalDevice());
 	}
 
-	void EngineApp::loadObjects() {
-		this->primitiveModel = std::make_unique<EnginePrimitiveModel>(this->device);
+	// GLFW input only works on the main thread, the render thread picks the new camera up on its next frame
+	void EngineApp::moveCamera(float deltaTime) {
+		GLFWwindow *window = this->window->getWindow();
+
+		glm::vec3 forward = glm::vec3(glm::sin(this->cameraYaw), 0.0f, glm::cos(this->cameraYaw));
+		glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+		glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+
+		// 1 or -1 while one of the two keys is held, 0 for neither or both
+		auto axis = [window] (int positiveKey, int negativeKey) {
+			return (glfwGetKey(window, positiveKey) == GLFW_PRESS ? 1.0f : 0.0f) - (glfwGetKey(window, negativeKey) == GLFW_PRESS ? 1.0f : 0.0f);
+		};
+
+		glm::vec3 move = axis(GLFW_KEY_W, GLFW_KEY_S) * forward + axis(GLFW_KEY_D, GLFW_KEY_A) * right + axis(GLFW_KEY_E, GLFW_KEY_Q) * up;
+
+		// Turning right turns forward towards right, which lowers the yaw
+		float turn = axis(GLFW_KEY_LEFT, GLFW_KEY_RIGHT);
+
+		if (move == glm::vec3(0.0f) && turn == 0.0f) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock{this->cameraMutex};
+
+		this->cameraPosition += move * CAMERA_MOVE_SPEED * deltaTime;
+		this->cameraYaw += turn * CAMERA_TURN_SPEED * deltaTime;
+		this->isCameraMoved = true;
+	}
+
+	void EngineApp::waitSceneLoading() {
+		// Nothing has to be presented meanwhile, so the scene is simply awaited on this thread
+		this->sceneUploaded = this->sceneLoader.get();
+		this->uploader->flush();
+
+		if (!this->pollSceneLoading()) {
+			throw std::runtime_error("failed to load the scene");
+		}
+	}
+
+	// Accumulates sampleCount samples from scratch and returns how long it took in seconds
+	float EngineApp::renderSamples(uint32_t sampleCount) {
+		this->recreateSubRendererAndSubsystem();
+		this->randomSeed = 0;
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		while (this->randomSeed < sampleCount) {
+			this->renderFrame();
+		}
+
+		vkDeviceWaitIdle(this->device.getLogicalDevice());
+
+		auto endTime = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count();
+	}
+
+	void EngineApp::runHeadless(uint32_t sampleCount, const std::string &outputPath) {
+		this->waitSceneLoading();
+		float renderTime = this->renderSamples(sampleCount);
+
+		uint32_t width = this->renderer->getSwapChain()->width();
+		uint32_t height = this->renderer->getSwapChain()->height();
+
+		std::cout << "headless: " << sampleCount << " samples of " << width << "x" << height << " in " << renderTime << " s, " 
+			<< (static_cast<float>(sampleCount) / renderTime) << " samples/s" << std::endl;
+
+		if (this->tileFrameTime > 0.0f) {
+			std::cout << "tiled rendering: " << this->tileBudget << " of " << this->tileTotal << " tiles per frame at " 
+				<< this->tileCost << " ms per tile" << std::endl;
+		}
+
+		// Samples actually traced against the uniform sample count per pixel, which the checkerboard and 
+		// half resolution modes divide by the share of pixels they trace
+		if (this->rayTraceUbo.errorThreshold > 0.0f) {
+			auto statistics = this->adaptiveSampleBuffer->readPixelStatistics();
+
+			VkExtent2D tileExtent = EngineAdaptiveSampleBuffer::getTileExtent(this->rayTraceUbo.traceMode);
+			uint32_t pixelsPerTrace = (tileExtent.width * tileExtent.height) / 
+				(EngineAdaptiveSampleBuffer::TILE_SIZE * EngineAdaptiveSampleBuffer::TILE_SIZE);
+			uint32_t uniformSampleCount = std::max(sampleCount / pixelsPerTrace, 1u);
+
+			uint64_t tracedSamples = 0;
+			uint32_t convergedPixels = 0;
+
+			for (auto &&pixel : statistics) {
+				tracedSamples += pixel.sampleCount;
+				convergedPixels += pixel.sampleCount < uniformSampleCount ? 1 : 0;
+			}
+
+			std::cout << "adaptive sampling: " << convergedPixels << " of " << statistics.size() << " pixels converged early, " 
+				<< (static_cast<double>(tracedSamples) / static_cast<double>(statistics.size()) / static_cast<double>(uniformSampleCount) * 100.0) 
+				<< "% of the uniform sample count traced" << std::endl;
+		}
+
+		// Runs of equal sort keys in trace order, summed over every sorted bounce of every sample
+		if (this->useRaySorting) {
+			WavefrontSortStatistics statistics = this->wavefrontQueue->readSortStatistics();
+			float rayCount = static_cast<float>(statistics.rayCount);
+
+			std::cout << "ray sorting: " << statistics.rayCount << " rays, average coherent run " 
+				<< (rayCount / static_cast<float>(std::max(statistics.unsortedRuns, 1u))) << " rays unsorted, " 
+				<< (rayCount / static_cast<float>(std::max(statistics.sortedRuns, 1u))) << " rays sorted" << std::endl;
+		}
+
+		auto pixels = this->accumulateImages->readBack();
+		writeImageFile(outputPath, pixels, width, height);
+	}
+
+	// The variance of a sampleCount-sample image is estimated from two renders with independent random streams: 
+	// for pixels a and b of both, E[(a - b)^2] / 2 is the variance of either. Efficiency is 1 / (variance * time).
+	void EngineApp::runBenchmark(uint32_t sampleCount) {
+		this->waitSceneLoading();
+
+		uint32_t maxBounce = this->rayTraceUbo.maxBounce;
+		uint32_t defaultMinBounce = this->rayTraceUbo.minBounce;
+		std::vector<uint32_t> minBounces = { maxBounce, 8, 5, 3, 1 };
+
+		this->primitiveModel->getBvhReport().print("primitive");
+		this->objectModel->getBvhReport().print("object");
+		this->lightModel->getBvhReport().print("light");
+		std::cout << "scene upload submits: " << this->uploader->getSubmitCount() << std::endl;
+
+		std::cout << "benchmark: " << sampleCount << " samples, max bounce " << maxBounce << ", commands " 
+			<< (this->usePrerecordedCommands ? "pre-recorded" : "recorded per frame") << std::endl;
+		std::cout << "min bounce\tsamples/s\tvariance\tefficiency" << std::endl;
+
+		for (auto &&minBounce : minBounces) {
+			this->rayTraceUbo.minBounce = minBounce;
+
+			this->rayTraceUbo.seedOffset = 0;
+			float renderTime = this->renderSamples(sampleCount);
+			auto firstPixels = this->accumulateImages->readBack();
+
+			// Far beyond any seed the first render used
+			this->rayTraceUbo.seedOffset = 1u << 20;
+			renderTime += this->renderSamples(sampleCount);
+			auto secondPixels = this->accumulateImages->readBack();
+
+			double squareDifference = 0.0;
+			for (size_t i = 0; i < firstPixels.size(); i++) {
+				glm::vec3 difference = glm::vec3(firstPixels[i]) - glm::vec3(secondPixels[i]);
+				squareDifference += static_cast<double>(glm::dot(difference, difference)) / 3.0;
+			}
+
+			double variance = squareDifference / static_cast<double>(firstPixels.size()) / 2.0;
+			double samplesPerSecond = 2.0 * static_cast<double>(sampleCount) / static_cast<double>(renderTime);
+
+			std::cout << (minBounce >= maxBounce ? std::string("off") : std::to_string(minBounce)) << "\t\t" << samplesPerSecond << "\t\t" 
+				<< variance << "\t" << (samplesPerSecond / static_cast<double>(sampleCount) / variance) << std::endl;
+		}
+
+		this->rayTraceUbo.minBounce = defaultMinBounce;
+		this->rayTraceUbo.seedOffset = 0;
+	}
+
+	std::shared_future<void> EngineApp::loadObjects(std::shared_ptr<EngineBufferUploader> uploader) {
+		this->primitiveModel = std::make_unique<EnginePrimitiveModel>(this->device, this->bvhTaskPool.get());
 
 		auto objects = std::make_shared<std::vector<Object>>();
 		auto materials = std::make_shared<std::vector<Material>>();
@@ -113,7 +598,6 @@ namespace nugiEngine {
 		auto vertices = std::make_shared<std::vector<Vertex>>();
 		auto indices = std::make_shared<std::vector<uint32_t>>();
 
-		std::vector<std::shared_ptr<BoundBox>> boundBoxes{};
 		std::vector<std::shared_ptr<TransformComponent>> transforms{};
 
 		// ----------------------------------------------------------------------------
@@ -134,20 +618,12 @@ namespace nugiEngine {
 		rightWallPrimitives->emplace_back(Primitive{ glm::uvec3(0u, 1u, 2u) });
 		rightWallPrimitives->emplace_back(Primitive{ glm::uvec3(2u, 3u, 0u) });
 
-		indices->emplace_back(0u);
-		indices->emplace_back(1u);
-		indices->emplace_back(2u);
-		indices->emplace_back(2u);
-		indices->emplace_back(3u);
-		indices->emplace_back(0u);
-
 		this->primitiveModel->addPrimitive(rightWallPrimitives, vertices);
 
-		boundBoxes.emplace_back(std::make_shared<ObjectBoundBox>(ObjectBoundBox{ static_cast<uint32_t>(boundBoxes.size() + 1), (*objects)[objectIndex], rightWallPrimitives, transforms[transformIndex], vertices }));
-		uint32_t boundBoxIndex = static_cast<uint32_t>(boundBoxes.size() - 1);
+		Aabb objectBox = findPrimitiveListBoundingBox(*rightWallPrimitives, *vertices);
 
-		transforms[transformIndex]->objectMaximum = boundBoxes[boundBoxIndex]->getOriginalMax();
-		transforms[transformIndex]->objectMinimum = boundBoxes[boundBoxIndex]->getOriginalMin();
+		transforms[transformIndex]->objectMaximum = objectBox.max;
+		transforms[transformIndex]->objectMinimum = objectBox.min;
 
 		// ----------------------------------------------------------------------------
 		
@@ -166,21 +642,13 @@ namespace nugiEngine {
 		auto leftWallPrimitives = std::make_shared<std::vector<Primitive>>();
 		leftWallPrimitives->emplace_back(Primitive{ glm::uvec3(4u, 5u, 6u) });
 		leftWallPrimitives->emplace_back(Primitive{ glm::uvec3(6u, 7u, 4u) });
-
-		indices->emplace_back(4u);
-		indices->emplace_back(5u);
-		indices->emplace_back(6u);
-		indices->emplace_back(6u);
-		indices->emplace_back(7u);
-		indices->emplace_back(4u);
 		
 		this->primitiveModel->addPrimitive(leftWallPrimitives, vertices);
 		
-		boundBoxes.emplace_back(std::make_shared<ObjectBoundBox>(ObjectBoundBox{ static_cast<uint32_t>(boundBoxes.size() + 1), (*objects)[objectIndex], leftWallPrimitives, transforms[transformIndex], vertices }));
-		boundBoxIndex = static_cast<uint32_t>(boundBoxes.size() - 1);
+		objectBox = findPrimitiveListBoundingBox(*leftWallPrimitives, *vertices);
 
-		transforms[transformIndex]->objectMaximum = boundBoxes[boundBoxIndex]->getOriginalMax();
-		transforms[transformIndex]->objectMinimum = boundBoxes[boundBoxIndex]->getOriginalMin();
+		transforms[transformIndex]->objectMaximum = objectBox.max;
+		transforms[transformIndex]->objectMinimum = objectBox.min;
 
 		// ----------------------------------------------------------------------------
 		
@@ -199,21 +667,13 @@ namespace nugiEngine {
 		auto bottomWallPrimitives = std::make_shared<std::vector<Primitive>>();
 		bottomWallPrimitives->emplace_back(Primitive{ glm::uvec3(8u, 9u, 10u) });
 		bottomWallPrimitives->emplace_back(Primitive{ glm::uvec3(10u, 11u, 8u) });
-
-		indices->emplace_back(8u);
-		indices->emplace_back(9u);
-		indices->emplace_back(10u);
-		indices->emplace_back(10u);
-		indices->emplace_back(11u);
-		indices->emplace_back(8u);
 		
 		this->primitiveModel->addPrimitive(bottomWallPrimitives, vertices);
 		
-		boundBoxes.emplace_back(std::make_shared<ObjectBoundBox>(ObjectBoundBox{ static_cast<uint32_t>(boundBoxes.size() + 1), (*objects)[objectIndex], bottomWallPrimitives, transforms[transformIndex], vertices }));
-		boundBoxIndex = static_cast<uint32_t>(boundBoxes.size() - 1);
+		objectBox = findPrimitiveListBoundingBox(*bottomWallPrimitives, *vertices);
 
-		transforms[transformIndex]->objectMaximum = boundBoxes[boundBoxIndex]->getOriginalMax();
-		transforms[transformIndex]->objectMinimum = boundBoxes[boundBoxIndex]->getOriginalMin();
+		transforms[transformIndex]->objectMaximum = objectBox.max;
+		transforms[transformIndex]->objectMinimum = objectBox.min;
 
 		// ----------------------------------------------------------------------------
 		
@@ -233,20 +693,12 @@ namespace nugiEngine {
 		topWallPrimitives->emplace_back(Primitive{ glm::uvec3(12u, 13u, 14u) });
 		topWallPrimitives->emplace_back(Primitive{ glm::uvec3(14u, 15u, 12u) });
 
-		indices->emplace_back(12u);
-		indices->emplace_back(13u);
-		indices->emplace_back(14u);
-		indices->emplace_back(14u);
-		indices->emplace_back(15u);
-		indices->emplace_back(12u);
-
 		this->primitiveModel->addPrimitive(topWallPrimitives, vertices);
 
-		boundBoxes.emplace_back(std::make_shared<ObjectBoundBox>(ObjectBoundBox{ static_cast<uint32_t>(boundBoxes.size() + 1), (*objects)[objectIndex], topWallPrimitives, transforms[transformIndex], vertices }));
-		boundBoxIndex = static_cast<uint32_t>(boundBoxes.size() - 1);
+		objectBox = findPrimitiveListBoundingBox(*topWallPrimitives, *vertices);
 
-		transforms[transformIndex]->objectMaximum = boundBoxes[boundBoxIndex]->getOriginalMax();
-		transforms[transformIndex]->objectMinimum = boundBoxes[boundBoxIndex]->getOriginalMin();
+		transforms[transformIndex]->objectMaximum = objectBox.max;
+		transforms[transformIndex]->objectMinimum = objectBox.min;
 
 		// ----------------------------------------------------------------------------
 		
@@ -266,20 +718,55 @@ namespace nugiEngine {
 		frontWallPrimitives->emplace_back(Primitive{ glm::uvec3(16u, 17u, 18u) });
 		frontWallPrimitives->emplace_back(Primitive{ glm::uvec3(18u, 19u, 16u) });
 
-		indices->emplace_back(16u);
-		indices->emplace_back(17u);
-		indices->emplace_back(18u);
-		indices->emplace_back(18u);
-		indices->emplace_back(19u);
-		indices->emplace_back(16u);
-
 		this->primitiveModel->addPrimitive(frontWallPrimitives, vertices);
 
-		boundBoxes.emplace_back(std::make_shared<ObjectBoundBox>(ObjectBoundBox{ static_cast<uint32_t>(boundBoxes.size() + 1), (*objects)[objectIndex], frontWallPrimitives, transforms[transformIndex], vertices }));
-		boundBoxIndex = static_cast<uint32_t>(boundBoxes.size() - 1);
+		objectBox = findPrimitiveListBoundingBox(*frontWallPrimitives, *vertices);
+
+		transforms[transformIndex]->objectMaximum = objectBox.max;
+		transforms[transformIndex]->objectMinimum = objectBox.min;
+
+		// ----------------------------------------------------------------------------
+
+		// The block an animated scene turns, one quad per face
+		if (this->isAnimated) {
+			transforms.emplace_back(std::make_shared<TransformComponent>(TransformComponent{ glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.0f) }));
+			transformIndex = static_cast<uint32_t>(transforms.size() - 1);
+			this->animatedTransformIndex = transformIndex;
+
+			objects->emplace_back(Object{ this->primitiveModel->getBvhSize(), this->primitiveModel->getPrimitiveSize(), transformIndex });
+			objectIndex = static_cast<uint32_t>(objects->size() - 1);
+
+			glm::vec3 blockCenter{277.5f, 82.5f, 277.5f};
+			glm::vec3 blockHalfSize{82.5f};
+			auto blockPrimitives = std::make_shared<std::vector<Primitive>>();
+
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				for (float side : { -1.0f, 1.0f }) {
+					glm::vec3 normal{0.0f}, u{0.0f}, v{0.0f};
+					normal[axis] = side;
+					u[(axis + 1) % 3] = blockHalfSize[(axis + 1) % 3];
+					v[(axis + 2) % 3] = blockHalfSize[(axis + 2) % 3];
+
+					glm::vec3 faceCenter = blockCenter + normal * blockHalfSize[axis];
+					std::vector<glm::vec3> corners = { faceCenter - u - v, faceCenter + u - v, faceCenter + u + v, faceCenter - u + v };
+
+					uint32_t firstVertex = static_cast<uint32_t>(vertices->size());
+					for (auto &&corner : corners) {
+						vertices->emplace_back(Vertex{ glm::vec4{corner, 1.0f}, glm::vec4{0.0f}, glm::vec4{normal, 0.0f}, 0u, transformIndex });
+					}
+
+					blockPrimitives->emplace_back(Primitive{ glm::uvec3(firstVertex, firstVertex + 1u, firstVertex + 2u) });
+					blockPrimitives->emplace_back(Primitive{ glm::uvec3(firstVertex + 2u, firstVertex + 3u, firstVertex) });
+				}
+			}
+
+			this->primitiveModel->addPrimitive(blockPrimitives, vertices);
 
-		transforms[transformIndex]->objectMaximum = boundBoxes[boundBoxIndex]->getOriginalMax();
-		transforms[transformIndex]->objectMinimum = boundBoxes[boundBoxIndex]->getOriginalMin();
+			objectBox = findPrimitiveListBoundingBox(*blockPrimitives, *vertices);
+
+			transforms[transformIndex]->objectMaximum = objectBox.max;
+			transforms[transformIndex]->objectMinimum = objectBox.min;
+		}
 
 		// ----------------------------------------------------------------------------
 
@@ -292,11 +779,10 @@ namespace nugiEngine {
 		auto flatVasePrimitives = this->primitiveModel->createPrimitivesFromFile(this->device, "models/viking_room.obj", 3u);
 		this->primitiveModel->addPrimitive(flatVasePrimitives);
 
-		boundBoxes.emplace_back(std::make_shared<ObjectBoundBox>(ObjectBoundBox{ static_cast<uint32_t>(boundBoxes.size() + 1), (*objects)[objectIndex], flatVasePrimitives, transforms[transformIndex] }));
-		boundBoxIndex = static_cast<uint32_t>(boundBoxes.size() - 1);
+		objectBox = findPrimitiveListBoundingBox(*flatVasePrimitives, *vertices);
 
-		transforms[transformIndex]->objectMaximum = boundBoxes[boundBoxIndex]->getOriginalMax();
-		transforms[transformIndex]->objectMinimum = boundBoxes[boundBoxIndex]->getOriginalMin(); */
+		transforms[transformIndex]->objectMaximum = objectBox.max;
+		transforms[transformIndex]->objectMinimum = objectBox.min; */
 
 		// ----------------------------------------------------------------------------
 
@@ -314,19 +800,29 @@ namespace nugiEngine {
 
 		// ----------------------------------------------------------------------------
 
-		this->objectModel = std::make_unique<EngineObjectModel>(this->device, objects, boundBoxes);
-		this->materialModel = std::make_unique<EngineMaterialModel>(this->device, materials);
-		this->lightModel = std::make_unique<EnginePointLightModel>(this->device, pointlights, arealights);
-		this->transformationModel = std::make_unique<EngineTransformationModel>(this->device, transforms);
-		this->vertexModels = std::make_unique<EngineVertexModel>(this->device, vertices, indices);
+		// The raster draws the primitives in buffer order, so gl_PrimitiveID is the primitive index for the visibility buffer
+		for (auto &&primitive : *this->primitiveModel->getPrimitives()) {
+			indices->emplace_back(primitive.indices.x);
+			indices->emplace_back(primitive.indices.y);
+			indices->emplace_back(primitive.indices.z);
+		}
+
+		this->objectModel = std::make_unique<EngineObjectModel>(this->device, objects, transforms, this->isAnimated, uploader, this->bvhTaskPool.get());
+		this->materialModel = std::make_unique<EngineMaterialModel>(this->device, materials, uploader);
+		this->lightModel = std::make_unique<EnginePointLightModel>(this->device, pointlights, arealights, uploader, this->bvhTaskPool.get());
+		this->transformationModel = std::make_unique<EngineTransformationModel>(this->device, transforms, this->isAnimated, uploader);
+		this->transforms = transforms;
+		this->vertexModels = std::make_unique<EngineVertexModel>(this->device, vertices, indices, uploader);
 
-		this->primitiveModel->createBuffers();
+		this->primitiveModel->createBuffers(uploader);
 
-		this->textures.emplace_back(std::make_unique<EngineTexture>(this->device, "textures/viking_room.png"));
+		this->textures.emplace_back(std::make_unique<EngineTexture>(this->device, "textures/viking_room.png", uploader));
 		this->numLights = static_cast<uint32_t>(arealights->size());
+
+		return uploader->submit();
 	}
 
-	void EngineApp::loadQuadModels() {
+	void EngineApp::loadQuadModels(std::shared_ptr<EngineBufferUploader> uploader) {
 		auto vertices = std::make_shared<std::vector<Vertex>>();
 		auto indices = std::make_shared<std::vector<uint32_t>>();
 
@@ -346,12 +842,19 @@ namespace nugiEngine {
 			0, 1, 2, 2, 3, 0
 		};
 
-		this->quadModels = std::make_shared<EngineVertexModel>(this->device, vertices, indices);
+		this->quadModels = std::make_shared<EngineVertexModel>(this->device, vertices, indices, uploader);
 	}
 
 	void EngineApp::updateCamera(uint32_t width, uint32_t height) {
-		glm::vec3 position = glm::vec3(278.0f, 278.0f, -800.0f);
-		glm::vec3 direction = glm::vec3(0.0f, 0.0f, 800.0f);
+		glm::vec3 position, direction;
+
+		{
+			std::lock_guard<std::mutex> lock{this->cameraMutex};
+
+			position = this->cameraPosition;
+			direction = glm::vec3(glm::sin(this->cameraYaw), 0.0f, glm::cos(this->cameraYaw));
+		}
+
 		glm::vec3 vup = glm::vec3(0.0f, 1.0f, 0.0f);
 
 		float near = 0.1f;
@@ -389,64 +892,127 @@ namespace nugiEngine {
     this->rasterUbo.projection[2][2] = far / (far - near);
     this->rasterUbo.projection[2][3] = 1.f;
     this->rasterUbo.projection[3][2] = -(far * near) / (far - near);
+
+		this->rayTraceUbo.inverseViewProjection = glm::inverse(this->rasterUbo.projection * this->rasterUbo.view);
 	}
 
 	void EngineApp::recreateSubRendererAndSubsystem() {
+		// Frames still in flight may use anything that gets replaced here
+		vkDeviceWaitIdle(this->device.getLogicalDevice());
+
+		// Every descriptor set is allocated again below, and the benchmark comes through here once per render
+		this->renderer->getDescriptorPool()->resetPool();
+
+		this->rasterCommandBuffers.clear();
+		this->traceCommandBuffers.clear();
+		this->samplingCommandBuffers.clear();
+
 		uint32_t width = this->renderer->getSwapChain()->width();
 		uint32_t height = this->renderer->getSwapChain()->height();
 
+		this->swapChainSubRenderer = std::make_unique<EngineSwapChainSubRenderer>(this->device, this->renderer->getSwapChain()->getswapChainImages(), 
+			this->renderer->getSwapChain()->getSwapChainImageFormat(), static_cast<int>(this->renderer->getSwapChain()->imageCount()), 
+			width, height, this->renderer->getSwapChain()->getPresentLayout());
+
+		if (!this->isSceneReady) {
+			return;
+		}
+
 		this->rayTraceUniforms = std::make_unique<EngineRayTraceUniform>(this->device);
 		this->rasterUniform = std::make_unique<EngineRasterUniform>(this->device);
 
 		this->updateCamera(width, height);
 
-		this->swapChainSubRenderer = std::make_unique<EngineSwapChainSubRenderer>(this->device, this->renderer->getSwapChain()->getswapChainImages(), 
-			this->renderer->getSwapChain()->getSwapChainImageFormat(), static_cast<int>(this->renderer->getSwapChain()->imageCount()), 
-			width, height);
-
 		this->forwardPassSubRenderer = std::make_unique<EngineForwardPassSubRenderer>(this->device, 
-			EngineDevice::MAX_FRAMES_IN_FLIGHT, width, height);
+			EngineDevice::MAX_FRAMES_IN_FLIGHT, width, height, this->rayTraceUbo.isVisibilityBuffer == 1u);
 
 		this->rayTraceImage = std::make_unique<EngineRayTraceImage>(this->device, width, height, EngineDevice::MAX_FRAMES_IN_FLIGHT);
-		this->accumulateImages = std::make_unique<EngineAccumulateImage>(this->device, width, height, EngineDevice::MAX_FRAMES_IN_FLIGHT);
+		this->accumulateImages = std::make_unique<EngineAccumulateImage>(this->device, width, height, EngineDevice::MAX_FRAMES_IN_FLIGHT, 
+			this->rayTraceUbo.maxHistory > 0);
+		this->adaptiveSampleBuffer = std::make_unique<EngineAdaptiveSampleBuffer>(this->device, width, height, this->rayTraceUbo.maxHistory > 0, 
+			this->rayTraceUbo.errorThreshold > 0.0f);
+
+		// Tiled rendering restarts from the first tile, with a sixteenth of the image until the first timings are in
+		if (this->tileFrameTime > 0.0f) {
+			VkExtent2D tileExtent = EngineAdaptiveSampleBuffer::getTileExtent(this->rayTraceUbo.traceMode);
+			this->tileTotal = ((width + tileExtent.width - 1) / tileExtent.width) * ((height + tileExtent.height - 1) / tileExtent.height);
+			this->firstTile = 0;
+			this->tileBudget = std::max(this->tileTotal / 16, 1u);
+			this->tileCost = 0.0f;
+
+			for (auto &&frameTileCount : this->frameTileCounts) {
+				frameTileCount = 0;
+			}
+		}
 
-		VkDescriptorBufferInfo rayTracebuffersInfo[9] { 
-			this->objectModel->getObjectInfo(), 
-			this->objectModel->getBvhInfo(),
+		VkDescriptorBufferInfo rayTracebuffersInfo[8] { 
 			this->primitiveModel->getPrimitiveInfo(), 
 			this->primitiveModel->getBvhInfo(),
-			this->vertexModels->getVertexInfo(),
+			this->vertexModels->getPositionInfo(),
 			this->materialModel->getMaterialInfo(),
-			this->transformationModel->getTransformationInfo(),
 			this->lightModel->getAreaLightInfo(),
-			this->lightModel->getBvhInfo()
+			this->lightModel->getBvhInfo(),
+			this->vertexModels->getAttributeInfo(),
+			this->primitiveModel->getTriangleInfo()
 		};
 
-		VkDescriptorBufferInfo forwardPassbuffersInfo[2] {
-			this->materialModel->getMaterialInfo(),
-			this->transformationModel->getTransformationInfo()
+		std::vector<VkDescriptorBufferInfo> objectBuffersInfo[2] {
+			this->objectModel->getObjectInfo(),
+			this->objectModel->getBvhInfo()
 		};
 
-		std::vector<VkDescriptorImageInfo> imagesInfo[2] {
+		std::vector<VkDescriptorImageInfo> imagesInfo[3] {
 			this->rayTraceImage->getImagesInfo(),
-			this->accumulateImages->getImagesInfo()
+			this->accumulateImages->getImagesInfo(),
+			this->accumulateImages->getHistoryImagesInfo()
 		};
 
-		std::vector<VkDescriptorImageInfo> resourcesInfo[5] = {
+		std::vector<VkDescriptorImageInfo> resourcesInfo[6] = {
 			this->forwardPassSubRenderer->getPositionInfoResources(),
 			this->forwardPassSubRenderer->getTextCoordInfoResources(),
 			this->forwardPassSubRenderer->getNormalInfoResources(),
 			this->forwardPassSubRenderer->getAlbedoColorInfoResources(),
-			this->forwardPassSubRenderer->getMaterialInfoResources()
+			this->forwardPassSubRenderer->getMaterialInfoResources(),
+			this->forwardPassSubRenderer->getVisibilityInfoResources()
+		};
+
+		std::vector<VkDescriptorBufferInfo> adaptiveBuffersInfo[3] {
+			this->adaptiveSampleBuffer->getTraceStatisticsInfo(),
+			this->adaptiveSampleBuffer->getTileMaskInfo(),
+			this->adaptiveSampleBuffer->getActiveTileInfo()
 		};
 
-		this->samplingDescSet = std::make_unique<EngineSamplingDescSet>(this->device, this->renderer->getDescriptorPool(), imagesInfo);
-		this->forwardPassDescSet = std::make_unique<EngineForwardPassDescSet>(this->device, this->renderer->getDescriptorPool(), this->rasterUniform->getBuffersInfo(), forwardPassbuffersInfo);
+		this->samplingDescSet = std::make_unique<EngineSamplingDescSet>(this->device, this->renderer->getDescriptorPool(), imagesInfo, 
+			this->rayTraceUniforms->getBuffersInfo(), this->adaptiveSampleBuffer->getPixelStatisticsInfo(), this->adaptiveSampleBuffer->getTileMaskInfo(), 
+			this->adaptiveSampleBuffer->getHistoryStatisticsInfo());
+		this->forwardPassDescSet = std::make_unique<EngineForwardPassDescSet>(this->device, this->renderer->getDescriptorPool(), this->rasterUniform->getBuffersInfo(), 
+			this->materialModel->getMaterialInfo(), this->transformationModel->getTransformationInfo());
 		this->rayTraceDescSet = std::make_unique<EngineRayTraceDescSet>(this->device, this->renderer->getDescriptorPool(), this->rayTraceUniforms->getBuffersInfo(), 
-			this->rayTraceImage->getImagesInfo(), rayTracebuffersInfo, resourcesInfo);
+			this->rayTraceImage->getImagesInfo(), rayTracebuffersInfo, objectBuffersInfo, this->transformationModel->getTransformationInfo(), resourcesInfo, 
+			adaptiveBuffersInfo);
+
+		this->adaptiveTileRender = std::make_unique<EngineAdaptiveTileRenderSystem>(this->device, this->rayTraceDescSet->getDescSetLayout(), width, height, 
+			this->rayTraceUbo.traceMode);
+
+		if (this->rayTraceUbo.traceMode != TRACE_MODE_FULL) {
+			this->reconstructRender = std::make_unique<EngineReconstructRenderSystem>(this->device, this->rayTraceDescSet->getDescSetLayout());
+		}
 
-		this->traceRayRender = std::make_unique<EngineTraceRayRenderSystem>(this->device, this->rayTraceDescSet->getDescSetLayout(), width, height, 1);
-		this->forwardPassRender = std::make_unique<EngineForwardPassRenderSystem>(this->device, this->forwardPassSubRenderer->getRenderPass(), this->forwardPassDescSet->getDescSetLayout());
+		if (this->useWavefront) {
+			this->wavefrontQueue = std::make_unique<EngineWavefrontQueue>(this->device, width, height);
+			this->wavefrontDescSet = std::make_unique<EngineWavefrontDescSet>(this->device, this->renderer->getDescriptorPool(), 
+				this->wavefrontQueue->getBuffersInfo());
+			this->wavefrontRender = std::make_unique<EngineWavefrontRenderSystem>(this->device, this->rayTraceDescSet->getDescSetLayout(), 
+				this->wavefrontDescSet->getDescSetLayout(), width, height, this->rayTraceUbo.maxBounce, this->useRaySorting);
+		} else {
+			this->traceRayRender = std::make_unique<EngineTraceRayRenderSystem>(this->device, this->rayTraceDescSet->getDescSetLayout());
+		}
+		this->forwardPassRender = std::make_unique<EngineForwardPassRenderSystem>(this->device, this->forwardPassSubRenderer->getRenderPass(), this->forwardPassDescSet->getDescSetLayout(), 
+			this->rayTraceUbo.isVisibilityBuffer == 1u);
 		this->samplingRayRender = std::make_unique<EngineSamplingRenderSystem>(this->device, this->swapChainSubRenderer->getRenderPass(), this->samplingDescSet->getDescSetLayout());
+
+		if (this->usePrerecordedCommands) {
+			this->recordFrameCommands();
+		}
 	}
 }
\ No newline at end of file
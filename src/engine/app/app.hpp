@@ -4,6 +4,8 @@
 #include "../../vulkan/device/device.hpp"
 #include "../../vulkan/texture/texture.hpp"
 #include "../../vulkan/buffer/buffer.hpp"
+#include "../../vulkan/uploader/buffer_uploader.hpp"
+#include "../../vulkan/query/timestamp_query.hpp"
 #include "../utils/camera/camera.hpp"
 #include "../data/image/accumulate_image.hpp"
 #include "../data/image/ray_trace_image.hpp"
@@ -15,17 +17,28 @@
 #include "../data/model/vertex_model.hpp"
 #include "../data/buffer/ray_trace_uniform.hpp"
 #include "../data/buffer/raster_uniform.hpp"
+#include "../data/buffer/wavefront_queue.hpp"
+#include "../data/buffer/adaptive_sample_buffer.hpp"
 #include "../data/descSet/ray_trace_desc_set.hpp"
 #include "../data/descSet/sampling_desc_set.hpp"
 #include "../data/descSet/forward_pass_desc_set.hpp"
+#include "../data/descSet/wavefront_desc_set.hpp"
 #include "../renderer/hybrid_renderer.hpp"
 #include "../renderer_sub/swapchain_sub_renderer.hpp"
 #include "../renderer_sub/forward_pass_sub_renderer.hpp"
 #include "../renderer_system/trace_ray_render_system.hpp"
 #include "../renderer_system/sampling_render_system.hpp"
 #include "../renderer_system/forward_pass_render_system.hpp"
+#include "../renderer_system/wavefront_render_system.hpp"
+#include "../renderer_system/adaptive_tile_render_system.hpp"
+#include "../renderer_system/reconstruct_render_system.hpp"
+#include "../utils/image/image_writer.hpp"
 
+#include <chrono>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #define APP_TITLE "Testing Vulkan"
@@ -37,7 +50,25 @@ namespace nugiEngine {
 			static constexpr int WIDTH = 800;
 			static constexpr int HEIGHT = 800;
 
-			EngineApp();
+			// WASD moves, Q and E go down and up, the left and right arrows turn. Units per second and radians per second.
+			static constexpr float CAMERA_MOVE_SPEED = 300.0f;
+			static constexpr float CAMERA_TURN_SPEED = 1.0f;
+
+			// Radians per second the block of an animated scene turns by
+			static constexpr float ANIMATION_TURN_SPEED = 0.5f;
+
+			// A headless app has no window and renders into offscreen images only. 
+			// The wavefront tracer replaces the single ray trace kernel by one pipeline per stage. 
+			// A non zero errorThreshold stops tracing pixels once their relative standard error falls below it. 
+			// A non zero tileFrameTime traces only as many tiles per frame as fit into that many milliseconds of GPU time. 
+			// The checkerboard and half resolution trace modes trace every second or fourth pixel and reconstruct the others. 
+			// A non zero maxHistory keeps up to that many samples per pixel through camera moves by reprojecting them. 
+			// The visibility buffer rasterizes only primitive indices and hit distances, the tracer fetches the rest from the scene buffers. 
+			// An animated scene adds a spinning block, and keeps the objects and transforms in per frame buffers so they can move. 
+			// Recording per frame records the raster, trace and sampling commands again every frame instead of reusing recorded ones.
+			EngineApp(bool isHeadless = false, bool isWavefront = false, bool isRaySorted = false, float errorThreshold = 0.0f, 
+				float tileFrameTime = 0.0f, TraceMode traceMode = TRACE_MODE_FULL, uint32_t maxHistory = 0, bool isVisibilityBuffer = false, 
+				bool isAnimated = false, bool isRecordedPerFrame = false);
 			~EngineApp();
 
 			EngineApp(const EngineApp&) = delete;
@@ -46,15 +77,41 @@ namespace nugiEngine {
 			void run();
 			void renderLoop();
 
-		private:
-			void loadObjects();
-			void loadQuadModels();
+			// Waits for the scene, accumulates the given number of samples and writes the result to outputPath
+			void runHeadless(uint32_t sampleCount, const std::string &outputPath);
+
+			// Headless as well: samples per second against image variance of the Cornell box, with and without Russian roulette
+			void runBenchmark(uint32_t sampleCount);
+
+			// Safe to call from any thread, the render thread applies it before its next frame
+			void setTransform(uint32_t transformIndex, glm::vec3 translation, glm::vec3 scale, glm::vec3 rotation);
 
+		private:
+			std::shared_future<void> loadObjects(std::shared_ptr<EngineBufferUploader> uploader);
+			void loadQuadModels(std::shared_ptr<EngineBufferUploader> uploader);
+
+			bool pollSceneLoading();
+			void renderLoadingFrame();
+			void renderFrame();
+			void updateTileRange(uint32_t frameIndex);
+
+			void waitSceneLoading();
+			float renderSamples(uint32_t sampleCount);
+
+			void recordRasterCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+			void recordTraceCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+			void recordSamplingCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, uint32_t imageIndex);
+			void recordFrameCommands();
+
+			void moveCamera(float deltaTime);
+			void updateCameraMotion();
+			void updateTransforms();
+			void animateObjects();
 			void updateCamera(uint32_t width, uint32_t height);
 			void recreateSubRendererAndSubsystem();
 
-			EngineWindow window{WIDTH, HEIGHT, APP_TITLE};
-			EngineDevice device{window};
+			std::unique_ptr<EngineWindow> window{};
+			EngineDevice device{this->window.get()};
 			
 			std::unique_ptr<EngineHybridRenderer> renderer{};
 
@@ -64,11 +121,19 @@ namespace nugiEngine {
 			std::unique_ptr<EngineTraceRayRenderSystem> traceRayRender{};
 			std::unique_ptr<EngineSamplingRenderSystem> samplingRayRender{};
 			std::unique_ptr<EngineForwardPassRenderSystem> forwardPassRender{};
+			std::unique_ptr<EngineWavefrontRenderSystem> wavefrontRender{};
+			std::unique_ptr<EngineAdaptiveTileRenderSystem> adaptiveTileRender{};
+			std::unique_ptr<EngineReconstructRenderSystem> reconstructRender{};
 
 			std::unique_ptr<EngineAccumulateImage> accumulateImages{};
 			std::unique_ptr<EngineRayTraceImage> rayTraceImage{};
 			std::unique_ptr<EngineRayTraceUniform> rayTraceUniforms{};
 			std::unique_ptr<EngineRasterUniform> rasterUniform{};
+			std::unique_ptr<EngineWavefrontQueue> wavefrontQueue{};
+			std::unique_ptr<EngineAdaptiveSampleBuffer> adaptiveSampleBuffer{};
+
+			// Shared by every Bvh build, and declared before the models so it outlives the object model's rebuilds
+			std::unique_ptr<TaskPool> bvhTaskPool{};
 
 			std::unique_ptr<EnginePrimitiveModel> primitiveModel{};
 			std::unique_ptr<EngineObjectModel> objectModel{};
@@ -81,13 +146,51 @@ namespace nugiEngine {
 			std::unique_ptr<EngineRayTraceDescSet> rayTraceDescSet{};
 			std::unique_ptr<EngineSamplingDescSet> samplingDescSet{};
 			std::unique_ptr<EngineForwardPassDescSet> forwardPassDescSet{};
+			std::unique_ptr<EngineWavefrontDescSet> wavefrontDescSet{};
 
 			std::vector<std::unique_ptr<EngineTexture>> textures{};
 
+			// Recorded once per recreate: raster and trace per frame slot, sampling per frame slot and swap chain image. 
+			// Everything that changes between frames goes through buffers instead.
+			std::vector<std::shared_ptr<EngineCommandBuffer>> rasterCommandBuffers{};
+			std::vector<std::shared_ptr<EngineCommandBuffer>> traceCommandBuffers{};
+			std::vector<std::shared_ptr<EngineCommandBuffer>> samplingCommandBuffers{};
+			bool usePrerecordedCommands = true;
+			bool useWavefront = false;
+			bool useRaySorting = false;
+
+			// Tiled rendering, the tile budget follows the measured trace time per tile
+			std::unique_ptr<EngineTimestampQuery> traceTimestamps{};
+			float tileFrameTime = 0.0f;
+			float tileCost = 0.0f;
+			uint32_t tileTotal = 0, firstTile = 0, tileBudget = 0;
+			uint32_t frameTileCounts[EngineDevice::MAX_FRAMES_IN_FLIGHT]{};
+
+			std::shared_ptr<EngineBufferUploader> uploader{};
+			std::future<std::shared_future<void>> sceneLoader{};
+			std::shared_future<void> sceneUploaded{};
+			bool isSceneReady = false;
+
 			uint32_t randomSeed = 0;
+			uint32_t statisticsAge = 0;
 			uint32_t numLights = 0;
 			bool isRendering = true;
 
+			// Moved by the main thread, picked up by the render thread at the start of its next frame
+			std::mutex cameraMutex;
+			glm::vec3 cameraPosition{278.0f, 278.0f, -800.0f};
+			float cameraYaw = 0.0f;
+			bool isCameraMoved = false;
+
+			// Queued by setTransform, applied by the render thread at the start of its next frame
+			std::mutex transformMutex;
+			std::vector<std::pair<uint32_t, TransformComponent>> pendingTransforms{};
+			std::vector<std::shared_ptr<TransformComponent>> transforms{};
+
+			bool isAnimated = false;
+			uint32_t animatedTransformIndex = 0;
+			std::chrono::high_resolution_clock::time_point animationStart{};
+
 			RayTraceUbo rayTraceUbo;
 			RasterUbo rasterUbo;
 	};
@@ -0,0 +1,202 @@
+#include "adaptive_sample_buffer.hpp"
+
+namespace nugiEngine {
+	EngineAdaptiveSampleBuffer::EngineAdaptiveSampleBuffer(EngineDevice& device, uint32_t width, uint32_t height, bool hasHistory, bool isAdaptive) 
+		: appDevice{device}, pixelCount{width * height}
+	{
+		this->createBuffers(width, height, hasHistory, isAdaptive);
+	}
+
+	VkExtent2D EngineAdaptiveSampleBuffer::getTileExtent(uint32_t traceMode) {
+		switch (traceMode) {
+			case TRACE_MODE_CHECKERBOARD: return { 2 * TILE_SIZE, TILE_SIZE };
+			case TRACE_MODE_HALF: return { 2 * TILE_SIZE, 2 * TILE_SIZE };
+			default: return { TILE_SIZE, TILE_SIZE };
+		}
+	}
+
+	std::vector<VkDescriptorBufferInfo> EngineAdaptiveSampleBuffer::getTraceStatisticsInfo() const {
+		std::vector<VkDescriptorBufferInfo> buffersInfo{};
+
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			buffersInfo.emplace_back(this->traceStatisticsBuffers.empty() ? this->pixelStatisticsBuffer->descriptorInfo() 
+				: this->traceStatisticsBuffers[i]->descriptorInfo());
+		}
+
+		return buffersInfo;
+	}
+
+	std::vector<VkDescriptorBufferInfo> EngineAdaptiveSampleBuffer::getTileMaskInfo() const {
+		std::vector<VkDescriptorBufferInfo> buffersInfo{};
+
+		for (auto &&tileMaskBuffer : this->tileMaskBuffers) {
+			buffersInfo.emplace_back(tileMaskBuffer->descriptorInfo());
+		}
+
+		return buffersInfo;
+	}
+
+	std::vector<VkDescriptorBufferInfo> EngineAdaptiveSampleBuffer::getActiveTileInfo() const {
+		return std::vector<VkDescriptorBufferInfo>(EngineDevice::MAX_FRAMES_IN_FLIGHT, this->activeTileBuffer->descriptorInfo());
+	}
+
+	VkDescriptorBufferInfo EngineAdaptiveSampleBuffer::getHistoryStatisticsInfo() const {
+		return this->historyStatisticsBuffer ? this->historyStatisticsBuffer->descriptorInfo() : this->pixelStatisticsBuffer->descriptorInfo();
+	}
+
+	void EngineAdaptiveSampleBuffer::copyHistory(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+		if (!this->historyStatisticsBuffer) {
+			return;
+		}
+
+		// The sampling of the frame before writes the statistics and reads the last copy
+		VkMemoryBarrier shaderBarrier{};
+		shaderBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		shaderBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		shaderBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+			0, 1, &shaderBarrier, 0, nullptr, 0, nullptr);
+
+		this->historyStatisticsBuffer->copyBuffer(this->pixelStatisticsBuffer->getBuffer(), sizeof(PixelStatistics) * this->pixelCount, commandBuffer);
+
+		VkMemoryBarrier copyBarrier{};
+		copyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		copyBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		copyBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
+			0, 1, &copyBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	void EngineAdaptiveSampleBuffer::finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
+		if (this->traceStatisticsBuffers.empty()) {
+			return;
+		}
+
+		VkMemoryBarrier shaderBarrier{};
+		shaderBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		shaderBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		shaderBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+			0, 1, &shaderBarrier, 0, nullptr, 0, nullptr);
+
+		this->traceStatisticsBuffers[frameIndex]->copyBuffer(this->pixelStatisticsBuffer->getBuffer(), sizeof(PixelStatistics) * this->pixelCount, commandBuffer);
+
+		// The next sampling pass writes the statistics again
+		VkMemoryBarrier copyBarrier{};
+		copyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		copyBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		copyBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
+			0, 1, &copyBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	std::vector<PixelStatistics> EngineAdaptiveSampleBuffer::readPixelStatistics() {
+		auto readBackBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(PixelStatistics),
+			this->pixelCount,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+		);
+
+		readBackBuffer->map();
+
+		auto commandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice);
+		commandBuffer->beginSingleTimeCommand();
+
+		VkMemoryBarrier shaderBarrier{};
+		shaderBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		shaderBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		shaderBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+			0, 1, &shaderBarrier, 0, nullptr, 0, nullptr);
+
+		readBackBuffer->copyBuffer(this->pixelStatisticsBuffer->getBuffer(), sizeof(PixelStatistics) * this->pixelCount, commandBuffer);
+
+		VkMemoryBarrier hostBarrier{};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 
+			0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+		commandBuffer->endCommand();
+		commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0));
+
+		readBackBuffer->invalidate();
+
+		std::vector<PixelStatistics> statistics(this->pixelCount);
+		readBackBuffer->readFromBuffer(statistics.data());
+
+		return statistics;
+	}
+
+	void EngineAdaptiveSampleBuffer::createBuffers(uint32_t width, uint32_t height, bool hasHistory, bool isAdaptive) {
+		// Sized for the smallest tiles, a partial tile at the right and bottom edge counts as a whole one
+		uint32_t tileCount = ((width + TILE_SIZE - 1) / TILE_SIZE) * ((height + TILE_SIZE - 1) / TILE_SIZE);
+
+		// Never read before the first sample of an accumulation has been written, so it needs no clearing
+		this->pixelStatisticsBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(PixelStatistics),
+			this->pixelCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+		);
+
+		this->traceStatisticsBuffers.clear();
+		this->tileMaskBuffers.clear();
+
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			// Read before any snapshot has been taken only on the first frames of an accumulation, where nothing counts as converged
+			if (isAdaptive) {
+				this->traceStatisticsBuffers.emplace_back(std::make_shared<EngineBuffer>(
+					this->appDevice,
+					sizeof(PixelStatistics),
+					this->pixelCount,
+					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VMA_MEMORY_USAGE_AUTO,
+					VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+				));
+			}
+
+			this->tileMaskBuffers.emplace_back(std::make_shared<EngineBuffer>(
+				this->appDevice,
+				sizeof(uint32_t),
+				tileCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VMA_MEMORY_USAGE_AUTO,
+				0
+			));
+		}
+
+		// Dispatch arguments, then one tile index per active tile
+		this->activeTileBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(glm::uvec4) + sizeof(uint32_t) * tileCount,
+			1,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			0
+		);
+
+		if (hasHistory) {
+			this->historyStatisticsBuffer = std::make_shared<EngineBuffer>(
+				this->appDevice,
+				sizeof(PixelStatistics),
+				this->pixelCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VMA_MEMORY_USAGE_AUTO,
+				VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+			);
+		}
+	}
+}
\ No newline at end of file
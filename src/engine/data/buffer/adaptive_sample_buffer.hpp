@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../../../vulkan/device/device.hpp"
+#include "../../../vulkan/buffer/buffer.hpp"
+#include "../../../vulkan/command/command_buffer.hpp"
+#include "../../general_struct.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace nugiEngine {
+	// Per pixel sample statistics and the tiles still being traced. The sampling passes run in order on one queue and share 
+	// the statistics, while the trace of a frame slot only reads the snapshot the last sampling of that slot took. Together 
+	// with one tile mask per slot, a trace never has to wait for the sampling of the frame before it. 
+	// With a history, the statistics are also copied as the frame before left them, for reprojection to read from.
+	class EngineAdaptiveSampleBuffer {
+		public:
+			// Traced pixels per tile along each axis, a tile covers more pixels when only some of them are traced
+			static constexpr uint32_t TILE_SIZE = 8;
+
+			EngineAdaptiveSampleBuffer(EngineDevice& device, uint32_t width, uint32_t height, bool hasHistory = false, bool isAdaptive = false);
+
+			static VkExtent2D getTileExtent(uint32_t traceMode);
+
+			VkDescriptorBufferInfo getPixelStatisticsInfo() const { return this->pixelStatisticsBuffer->descriptorInfo(); }
+
+			// One entry per frame in flight. Without adaptive sampling the trace never reads the statistics, 
+			// so every entry points at the shared ones
+			std::vector<VkDescriptorBufferInfo> getTraceStatisticsInfo() const;
+			std::vector<VkDescriptorBufferInfo> getTileMaskInfo() const;
+
+			// One entry per frame in flight, all pointing at the same buffer
+			std::vector<VkDescriptorBufferInfo> getActiveTileInfo() const;
+
+			// The statistics themselves if there is no history, they are then never read as one
+			VkDescriptorBufferInfo getHistoryStatisticsInfo() const;
+
+			// Starts with the indirect dispatch arguments over the active tiles
+			VkBuffer getActiveTileBuffer() const { return this->activeTileBuffer->getBuffer(); }
+
+			// Recorded at the start of the sampling pass, does nothing without a history
+			void copyHistory(std::shared_ptr<EngineCommandBuffer> commandBuffer);
+
+			// Recorded at the end of the sampling pass: snapshots the statistics for the next trace of this frame slot, 
+			// which only starts after the fence of this frame. Does nothing without adaptive sampling.
+			void finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+
+			// Waits for the graphics queue, only meant for reporting once rendering is done
+			std::vector<PixelStatistics> readPixelStatistics();
+
+		private:
+			EngineDevice& appDevice;
+			uint32_t pixelCount;
+
+			std::shared_ptr<EngineBuffer> pixelStatisticsBuffer;
+			std::vector<std::shared_ptr<EngineBuffer>> traceStatisticsBuffers;
+			std::vector<std::shared_ptr<EngineBuffer>> tileMaskBuffers;
+			std::shared_ptr<EngineBuffer> activeTileBuffer;
+			std::shared_ptr<EngineBuffer> historyStatisticsBuffer;
+
+			void createBuffers(uint32_t width, uint32_t height, bool hasHistory, bool isAdaptive);
+	};
+}
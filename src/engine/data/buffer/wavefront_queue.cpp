@@ -0,0 +1,131 @@
+#include "wavefront_queue.hpp"
+
+namespace nugiEngine {
+	EngineWavefrontQueue::EngineWavefrontQueue(EngineDevice& device, uint32_t width, uint32_t height) : appDevice{device} {
+		this->createBuffers(width * height);
+	}
+
+	std::vector<VkDescriptorBufferInfo> EngineWavefrontQueue::getBuffersInfo() const {
+		return {
+			this->pathBuffer->descriptorInfo(),
+			this->hitBuffer->descriptorInfo(),
+			this->extendBuffer->descriptorInfo(),
+			this->shadowBuffer->descriptorInfo(),
+			this->counterBuffer->descriptorInfo(),
+			this->sortKeyBuffer->descriptorInfo(),
+			this->sortBinBuffer->descriptorInfo()
+		};
+	}
+
+	WavefrontSortStatistics EngineWavefrontQueue::readSortStatistics() {
+		auto readBackBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(WavefrontSortStatistics),
+			1,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+		);
+
+		readBackBuffer->map();
+
+		auto commandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice);
+		commandBuffer->beginSingleTimeCommand();
+
+		VkMemoryBarrier shaderBarrier{};
+		shaderBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		shaderBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		shaderBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+			0, 1, &shaderBarrier, 0, nullptr, 0, nullptr);
+
+		readBackBuffer->copyBuffer(this->sortBinBuffer->getBuffer(), sizeof(WavefrontSortStatistics), commandBuffer);
+
+		VkMemoryBarrier hostBarrier{};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 
+			0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+		commandBuffer->endCommand();
+		commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0));
+
+		readBackBuffer->invalidate();
+
+		WavefrontSortStatistics statistics{};
+		readBackBuffer->readFromBuffer(&statistics, sizeof(WavefrontSortStatistics));
+
+		return statistics;
+	}
+
+	void EngineWavefrontQueue::createBuffers(uint32_t pixelCount) {
+		this->pathBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(WavefrontPath),
+			pixelCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+		);
+
+		// Every path has at most one hit to shade per bounce, so GGX and Lambert hits share one queue from both ends
+		this->hitBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(WavefrontHit),
+			pixelCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+		);
+
+		// Two extend queues, the rays of the next bounce are queued while the current ones are still read. 
+		// Sorted rays go into a third one behind them.
+		this->extendBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(uint32_t),
+			3 * pixelCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+		);
+
+		this->shadowBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(uint32_t),
+			pixelCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+		);
+
+		this->counterBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(WavefrontCounters),
+			1,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			0
+		);
+
+		this->sortKeyBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(uint32_t),
+			pixelCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+		);
+
+		this->sortBinBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(WavefrontSortBins),
+			1,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			0
+		);
+	}
+}
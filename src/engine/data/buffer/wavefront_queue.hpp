@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../../../vulkan/device/device.hpp"
+#include "../../../vulkan/buffer/buffer.hpp"
+#include "../../../vulkan/command/command_buffer.hpp"
+#include "../../general_struct.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace nugiEngine {
+	// GPU side path state and ray queues of the wavefront tracer, sized for one path per pixel
+	class EngineWavefrontQueue {
+		public:
+			EngineWavefrontQueue(EngineDevice& device, uint32_t width, uint32_t height);
+
+			// Paths, hits, extend queues, shadow queue, counters, sort keys and sort bins, in binding order
+			std::vector<VkDescriptorBufferInfo> getBuffersInfo() const;
+			VkBuffer getCounterBuffer() const { return this->counterBuffer->getBuffer(); }
+			VkBuffer getSortBinBuffer() const { return this->sortBinBuffer->getBuffer(); }
+
+			// Waits for the graphics queue, only meant for reporting once rendering is done
+			WavefrontSortStatistics readSortStatistics();
+
+		private:
+			EngineDevice& appDevice;
+
+			std::shared_ptr<EngineBuffer> pathBuffer;
+			std::shared_ptr<EngineBuffer> hitBuffer;
+			std::shared_ptr<EngineBuffer> extendBuffer;
+			std::shared_ptr<EngineBuffer> shadowBuffer;
+			std::shared_ptr<EngineBuffer> counterBuffer;
+			std::shared_ptr<EngineBuffer> sortKeyBuffer;
+			std::shared_ptr<EngineBuffer> sortBinBuffer;
+
+			void createBuffers(uint32_t pixelCount);
+	};
+}
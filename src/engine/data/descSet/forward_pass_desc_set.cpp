@@ -2,13 +2,13 @@
 
 namespace nugiEngine {
   EngineForwardPassDescSet::EngineForwardPassDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, 
-    std::vector<VkDescriptorBufferInfo> uniformBufferInfo, VkDescriptorBufferInfo buffersInfo[2]) 
+    std::vector<VkDescriptorBufferInfo> uniformBufferInfo, VkDescriptorBufferInfo materialBufferInfo, std::vector<VkDescriptorBufferInfo> transformationBuffersInfo) 
 	{
-		this->createDescriptor(device, descriptorPool, uniformBufferInfo, buffersInfo);
+		this->createDescriptor(device, descriptorPool, uniformBufferInfo, materialBufferInfo, transformationBuffersInfo);
   }
 
   void EngineForwardPassDescSet::createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, 
-    std::vector<VkDescriptorBufferInfo> uniformBufferInfo, VkDescriptorBufferInfo buffersInfo[2]) 
+    std::vector<VkDescriptorBufferInfo> uniformBufferInfo, VkDescriptorBufferInfo materialBufferInfo, std::vector<VkDescriptorBufferInfo> transformationBuffersInfo) 
 	{
     this->descSetLayout = 
 			EngineDescriptorSetLayout::Builder(device)
@@ -21,12 +21,16 @@ namespace nugiEngine {
 		for (int i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
 			VkDescriptorSet descSet{};
 
-			EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
+			bool isAllocated = EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
 				.writeBuffer(0, &uniformBufferInfo[i])
-				.writeBuffer(1, &buffersInfo[0])
-				.writeBuffer(2, &buffersInfo[1])
+				.writeBuffer(1, &materialBufferInfo)
+				.writeBuffer(2, &transformationBuffersInfo[i])
 				.build(&descSet);
 
+			if (!isAllocated) {
+				throw std::runtime_error("failed to allocate forward pass descriptor set");
+			}
+
 			this->descriptorSets.emplace_back(descSet);
 		}
   }
@@ -2,13 +2,15 @@
 
 namespace nugiEngine {
   EngineRayTraceDescSet::EngineRayTraceDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> uniformBufferInfo, 
-		std::vector<VkDescriptorImageInfo> rayTraceImageInfo, VkDescriptorBufferInfo buffersInfo[9], std::vector<VkDescriptorImageInfo> resourcesInfo[5]) 
+		std::vector<VkDescriptorImageInfo> rayTraceImageInfo, VkDescriptorBufferInfo buffersInfo[8], std::vector<VkDescriptorBufferInfo> objectBuffersInfo[2], 
+		std::vector<VkDescriptorBufferInfo> transformationBuffersInfo, std::vector<VkDescriptorImageInfo> resourcesInfo[6], std::vector<VkDescriptorBufferInfo> adaptiveBuffersInfo[3]) 
 	{
-		this->createDescriptor(device, descriptorPool, uniformBufferInfo, rayTraceImageInfo, buffersInfo, resourcesInfo);
+		this->createDescriptor(device, descriptorPool, uniformBufferInfo, rayTraceImageInfo, buffersInfo, objectBuffersInfo, transformationBuffersInfo, resourcesInfo, adaptiveBuffersInfo);
   }
 
   void EngineRayTraceDescSet::createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> uniformBufferInfo, 
-		std::vector<VkDescriptorImageInfo> rayTraceImageInfo, VkDescriptorBufferInfo buffersInfo[9], std::vector<VkDescriptorImageInfo> resourcesInfo[5]) 
+		std::vector<VkDescriptorImageInfo> rayTraceImageInfo, VkDescriptorBufferInfo buffersInfo[8], std::vector<VkDescriptorBufferInfo> objectBuffersInfo[2], 
+		std::vector<VkDescriptorBufferInfo> transformationBuffersInfo, std::vector<VkDescriptorImageInfo> resourcesInfo[6], std::vector<VkDescriptorBufferInfo> adaptiveBuffersInfo[3]) 
 	{
     this->descSetLayout = 
 			EngineDescriptorSetLayout::Builder(device)
@@ -28,31 +30,47 @@ namespace nugiEngine {
 				.addBinding(13, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
 				.addBinding(14, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
 				.addBinding(15, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(16, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(17, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(18, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(19, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(20, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(21, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
 				.build();
 		
 	this->descriptorSets.clear();
 		for (int i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
 			VkDescriptorSet descSet{};
 
-			EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
+			bool isAllocated = EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
 				.writeImage(0, &rayTraceImageInfo[i])
 				.writeBuffer(1, &uniformBufferInfo[i])
-				.writeBuffer(2, &buffersInfo[0])
-				.writeBuffer(3, &buffersInfo[1])
-				.writeBuffer(4, &buffersInfo[2])
-				.writeBuffer(5, &buffersInfo[3])
-				.writeBuffer(6, &buffersInfo[4])
-				.writeBuffer(7, &buffersInfo[5])
-				.writeBuffer(8, &buffersInfo[6])
-				.writeBuffer(9, &buffersInfo[7])
-				.writeBuffer(10, &buffersInfo[8])
+				.writeBuffer(2, &objectBuffersInfo[0][i])
+				.writeBuffer(3, &objectBuffersInfo[1][i])
+				.writeBuffer(4, &buffersInfo[0])
+				.writeBuffer(5, &buffersInfo[1])
+				.writeBuffer(6, &buffersInfo[2])
+				.writeBuffer(7, &buffersInfo[3])
+				.writeBuffer(8, &transformationBuffersInfo[i])
+				.writeBuffer(9, &buffersInfo[4])
+				.writeBuffer(10, &buffersInfo[5])
 				.writeImage(11, &resourcesInfo[0][i])
 				.writeImage(12, &resourcesInfo[1][i])
 				.writeImage(13, &resourcesInfo[2][i])
 				.writeImage(14, &resourcesInfo[3][i])
 				.writeImage(15, &resourcesInfo[4][i])
+				.writeBuffer(16, &adaptiveBuffersInfo[0][i])
+				.writeBuffer(17, &adaptiveBuffersInfo[1][i])
+				.writeBuffer(18, &adaptiveBuffersInfo[2][i])
+				.writeImage(19, &resourcesInfo[5][i])
+				.writeBuffer(20, &buffersInfo[6])
+				.writeBuffer(21, &buffersInfo[7])
 				.build(&descSet);
 
+			if (!isAllocated) {
+				throw std::runtime_error("failed to allocate ray trace descriptor set");
+			}
+
 			this->descriptorSets.emplace_back(descSet);
 		}
   }
@@ -10,7 +10,8 @@ namespace nugiEngine {
 	class EngineRayTraceDescSet {
 		public:
 			EngineRayTraceDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> uniformBufferInfo, 
-				std::vector<VkDescriptorImageInfo> rayTraceImageInfo, VkDescriptorBufferInfo buffersInfo[9], std::vector<VkDescriptorImageInfo> resourcesInfo[5]);
+				std::vector<VkDescriptorImageInfo> rayTraceImageInfo, VkDescriptorBufferInfo buffersInfo[8], std::vector<VkDescriptorBufferInfo> objectBuffersInfo[2], 
+				std::vector<VkDescriptorBufferInfo> transformationBuffersInfo, std::vector<VkDescriptorImageInfo> resourcesInfo[6], std::vector<VkDescriptorBufferInfo> adaptiveBuffersInfo[3]);
 
 			VkDescriptorSet getDescriptorSets(int frameIndex) { return this->descriptorSets[frameIndex]; }
 			std::shared_ptr<EngineDescriptorSetLayout> getDescSetLayout() const { return this->descSetLayout; }
@@ -20,7 +21,8 @@ namespace nugiEngine {
 			std::vector<VkDescriptorSet> descriptorSets;
 
 			void createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> uniformBufferInfo, 
-				std::vector<VkDescriptorImageInfo> rayTraceImageInfo, VkDescriptorBufferInfo buffersInfo[9], std::vector<VkDescriptorImageInfo> resourcesInfo[5]);
+				std::vector<VkDescriptorImageInfo> rayTraceImageInfo, VkDescriptorBufferInfo buffersInfo[8], std::vector<VkDescriptorBufferInfo> objectBuffersInfo[2], 
+				std::vector<VkDescriptorBufferInfo> transformationBuffersInfo, std::vector<VkDescriptorImageInfo> resourcesInfo[6], std::vector<VkDescriptorBufferInfo> adaptiveBuffersInfo[3]);
 	};
 	
 }
\ No newline at end of file
@@ -1,26 +1,46 @@
 #include "sampling_desc_set.hpp"
 
 namespace nugiEngine {
-  EngineSamplingDescSet::EngineSamplingDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorImageInfo> samplingResourcesInfo[2]) {
-		this->createDescriptor(device, descriptorPool, samplingResourcesInfo);
+  EngineSamplingDescSet::EngineSamplingDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorImageInfo> samplingResourcesInfo[3],
+		std::vector<VkDescriptorBufferInfo> uniformBufferInfo, 
+				VkDescriptorBufferInfo pixelStatisticsInfo, std::vector<VkDescriptorBufferInfo> tileMaskInfo, VkDescriptorBufferInfo historyStatisticsInfo) 
+	{
+		this->createDescriptor(device, descriptorPool, samplingResourcesInfo, uniformBufferInfo, pixelStatisticsInfo, tileMaskInfo, historyStatisticsInfo);
   }
 
-  void EngineSamplingDescSet::createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorImageInfo> samplingResourcesInfo[2]) {
+  void EngineSamplingDescSet::createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorImageInfo> samplingResourcesInfo[3],
+		std::vector<VkDescriptorBufferInfo> uniformBufferInfo, 
+				VkDescriptorBufferInfo pixelStatisticsInfo, std::vector<VkDescriptorBufferInfo> tileMaskInfo, VkDescriptorBufferInfo historyStatisticsInfo) 
+	{
     this->descSetLayout = 
 			EngineDescriptorSetLayout::Builder(device)
 				.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT)
 				.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
 				.build();
 		
 	this->descriptorSets.clear();
 	for (int i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
 			VkDescriptorSet descSet{};
 
-			EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
+			bool isAllocated = EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
 				.writeImage(0, &samplingResourcesInfo[0][i])
 				.writeImage(1, &samplingResourcesInfo[1][i])
+				.writeBuffer(2, &uniformBufferInfo[i])
+				.writeBuffer(3, &pixelStatisticsInfo)
+				.writeBuffer(4, &tileMaskInfo[i])
+				.writeImage(5, &samplingResourcesInfo[2][i])
+				.writeBuffer(6, &historyStatisticsInfo)
 				.build(&descSet);
 
+			if (!isAllocated) {
+				throw std::runtime_error("failed to allocate sampling descriptor set");
+			}
+
 			this->descriptorSets.emplace_back(descSet);
 		}
   }
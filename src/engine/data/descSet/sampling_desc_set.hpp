@@ -9,7 +9,9 @@
 namespace nugiEngine {
 	class EngineSamplingDescSet {
 		public:
-			EngineSamplingDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorImageInfo> samplingResourcesInfo[2]);
+			EngineSamplingDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorImageInfo> samplingResourcesInfo[3],
+				std::vector<VkDescriptorBufferInfo> uniformBufferInfo, 
+				VkDescriptorBufferInfo pixelStatisticsInfo, std::vector<VkDescriptorBufferInfo> tileMaskInfo, VkDescriptorBufferInfo historyStatisticsInfo);
 
 			VkDescriptorSet getDescriptorSets(int frameIndex) { return this->descriptorSets[frameIndex]; }
 			std::shared_ptr<EngineDescriptorSetLayout> getDescSetLayout() const { return this->descSetLayout; }
@@ -18,7 +20,9 @@ namespace nugiEngine {
       std::shared_ptr<EngineDescriptorSetLayout> descSetLayout;
 			std::vector<VkDescriptorSet> descriptorSets;
 
-			void createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorImageInfo> samplingResourcesInfo[2]);
+			void createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorImageInfo> samplingResourcesInfo[3],
+				std::vector<VkDescriptorBufferInfo> uniformBufferInfo, 
+				VkDescriptorBufferInfo pixelStatisticsInfo, std::vector<VkDescriptorBufferInfo> tileMaskInfo, VkDescriptorBufferInfo historyStatisticsInfo);
 	};
 	
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "wavefront_desc_set.hpp"
+
+namespace nugiEngine {
+  EngineWavefrontDescSet::EngineWavefrontDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> queueBuffersInfo) {
+		this->createDescriptor(device, descriptorPool, queueBuffersInfo);
+  }
+
+  void EngineWavefrontDescSet::createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> queueBuffersInfo) {
+    this->descSetLayout = 
+			EngineDescriptorSetLayout::Builder(device)
+				.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.build();
+
+		bool isAllocated = EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
+			.writeBuffer(0, &queueBuffersInfo[0])
+			.writeBuffer(1, &queueBuffersInfo[1])
+			.writeBuffer(2, &queueBuffersInfo[2])
+			.writeBuffer(3, &queueBuffersInfo[3])
+			.writeBuffer(4, &queueBuffersInfo[4])
+			.writeBuffer(5, &queueBuffersInfo[5])
+			.writeBuffer(6, &queueBuffersInfo[6])
+			.build(&this->descriptorSet);
+
+		if (!isAllocated) {
+			throw std::runtime_error("failed to allocate wavefront descriptor set");
+		}
+  }
+}
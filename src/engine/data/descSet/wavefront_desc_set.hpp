@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../../../vulkan/device/device.hpp"
+#include "../../../vulkan/buffer/buffer.hpp"
+#include "../../../vulkan/descriptor/descriptor.hpp"
+
+#include <memory>
+
+namespace nugiEngine {
+	// The wavefront queues are shared by every frame, traces never overlap on the queue they run on
+	class EngineWavefrontDescSet {
+		public:
+			EngineWavefrontDescSet(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> queueBuffersInfo);
+
+			VkDescriptorSet getDescriptorSet() { return this->descriptorSet; }
+			std::shared_ptr<EngineDescriptorSetLayout> getDescSetLayout() const { return this->descSetLayout; }
+
+		private:
+      std::shared_ptr<EngineDescriptorSetLayout> descSetLayout;
+			VkDescriptorSet descriptorSet;
+
+			void createDescriptor(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> queueBuffersInfo);
+	};
+	
+}
@@ -1,54 +1,154 @@
 #include "accumulate_image.hpp"
 
 namespace nugiEngine {
-  EngineAccumulateImage::EngineAccumulateImage(EngineDevice& device, uint32_t width, uint32_t height, uint32_t imageCount) {
-		this->createAccumulateImages(device, width, height, imageCount);
+  EngineAccumulateImage::EngineAccumulateImage(EngineDevice& device, uint32_t width, uint32_t height, uint32_t frameCount, bool hasHistory) 
+		: appDevice{device}, width{width}, height{height}, frameCount{frameCount}
+	{
+		this->accumulateImage = this->createAccumulateImage(device, width, height);
+
+		if (hasHistory) {
+			this->historyImage = this->createAccumulateImage(device, width, height);
+		}
   }
 
 	std::vector<VkDescriptorImageInfo> EngineAccumulateImage::getImagesInfo() const {
 		std::vector<VkDescriptorImageInfo> imagesInfo{};
 		
-		for (int i = 0; i < this->accumulateImages.size(); i++) {
-			imagesInfo.emplace_back(accumulateImages[i]->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL));
+		for (uint32_t i = 0; i < this->frameCount; i++) {
+			imagesInfo.emplace_back(this->accumulateImage->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL));
 		}
 
 		return imagesInfo;
 	}
 
-	void EngineAccumulateImage::createAccumulateImages(EngineDevice& device, uint32_t width, uint32_t height, uint32_t imageCount) {
-   	this->accumulateImages.clear();
-
-		for (uint32_t i = 0; i < imageCount; i++) {
-			auto accumulateImage = std::make_shared<EngineImage>(
-				device, width, height, 
-				1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, 
-				VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, 
-				VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
-				VK_IMAGE_ASPECT_COLOR_BIT
-			);
+	std::vector<VkDescriptorImageInfo> EngineAccumulateImage::getHistoryImagesInfo() const {
+		if (!this->historyImage) {
+			return this->getImagesInfo();
+		}
 
-			this->accumulateImages.emplace_back(accumulateImage);
+		std::vector<VkDescriptorImageInfo> imagesInfo{};
+		
+		for (uint32_t i = 0; i < this->frameCount; i++) {
+			imagesInfo.emplace_back(this->historyImage->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL));
 		}
+
+		return imagesInfo;
+	}
+
+	std::shared_ptr<EngineImage> EngineAccumulateImage::createAccumulateImage(EngineDevice& device, uint32_t width, uint32_t height) {
+		auto image = std::make_shared<EngineImage>(
+			device, width, height, 
+			1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, 
+			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, 
+			VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
+			VK_IMAGE_ASPECT_COLOR_BIT
+		);
+
+		// Start from zero in GENERAL once, instead of on whichever frame happens to run first. 
+		// The first sample ignores the old value, but it must not be NaN.
+		auto commandBuffer = std::make_shared<EngineCommandBuffer>(device);
+		commandBuffer->beginSingleTimeCommand();
+
+		image->transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+			0, VK_ACCESS_TRANSFER_WRITE_BIT, 
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
+
+		VkClearColorValue clearColor{};
+		VkImageSubresourceRange clearRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdClearColorImage(commandBuffer->getCommandBuffer(), image->getImage(), VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &clearRange);
+
+		commandBuffer->endCommand();
+		commandBuffer->submitCommand(device.getGraphicsQueue(0));
+
+		return image;
   }
 
-	void EngineAccumulateImage::prepareFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
-		if (this->accumulateImages[frameIndex]->getLayout() == VK_IMAGE_LAYOUT_UNDEFINED) {
-			this->accumulateImages[frameIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
-				0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, 
+	void EngineAccumulateImage::prepareFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+		if (this->historyImage) {
+			this->accumulateImage->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
+
+			// The frame before may still be reading the last copy
+			this->historyImage->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
+
+			this->accumulateImage->copyImageToOther(this->historyImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, commandBuffer);
+
+			this->historyImage->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
 				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
-		} else {
-			this->accumulateImages[frameIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+
+			this->accumulateImage->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 				0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
 				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
+
+			return;
 		}
+
+		// The previous frame may still be blending into the image
+		this->accumulateImage->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
 	}
 
-	void EngineAccumulateImage::finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
-		this->accumulateImages[frameIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+	void EngineAccumulateImage::finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+		this->accumulateImage->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
 			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
 			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, 0,
 			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
 	}
+
+	std::vector<glm::vec4> EngineAccumulateImage::readBack() {
+		auto readBackBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(glm::vec4),
+			this->width * this->height,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+		);
+
+		readBackBuffer->map();
+
+		auto commandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice);
+		commandBuffer->beginSingleTimeCommand();
+
+		this->accumulateImage->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
+
+		readBackBuffer->copyImageToBuffer(this->accumulateImage->getImage(), this->width, this->height, 1, commandBuffer);
+
+		this->accumulateImage->transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commandBuffer);
+
+		VkMemoryBarrier hostBarrier{};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 
+			0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+		commandBuffer->endCommand();
+		commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0));
+
+		readBackBuffer->invalidate();
+
+		std::vector<glm::vec4> pixels(this->width * this->height);
+		readBackBuffer->readFromBuffer(pixels.data());
+
+		return pixels;
+	}
 }
\ No newline at end of file
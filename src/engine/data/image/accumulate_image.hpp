@@ -5,22 +5,40 @@
 #include "../../../vulkan/descriptor/descriptor.hpp"
 #include "../../../vulkan/image/image.hpp"
 
+#include <glm/glm.hpp>
+
 #include <memory>
+#include <vector>
 
 namespace nugiEngine {
+	// A single running average shared by every frame in flight. Frames are submitted to one queue, 
+	// so the barrier in prepareFrame orders each frame after the samples of the frame before it. 
+	// With a history, prepareFrame also copies the image as the frame before left it, for reprojection to read from.
 	class EngineAccumulateImage {
 		public:
-			EngineAccumulateImage(EngineDevice& device, uint32_t width, uint32_t height, uint32_t imageCount);
+			EngineAccumulateImage(EngineDevice& device, uint32_t width, uint32_t height, uint32_t frameCount, bool hasHistory = false);
 
+			// One entry per frame in flight, all pointing at the same image
 			std::vector<VkDescriptorImageInfo> getImagesInfo() const;
 
-			void prepareFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
-			void finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+			// The accumulation itself if there is no history, it is then never read as one
+			std::vector<VkDescriptorImageInfo> getHistoryImagesInfo() const;
+
+			void prepareFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer);
+			void finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer);
+
+			// Copies the accumulated radiance back to the host, row by row from the top. 
+			// No frame may be in flight anymore.
+			std::vector<glm::vec4> readBack();
 
 		private:
-			std::vector<std::shared_ptr<EngineImage>> accumulateImages;
+			EngineDevice& appDevice;
+			uint32_t width, height, frameCount;
+
+			std::shared_ptr<EngineImage> accumulateImage;
+			std::shared_ptr<EngineImage> historyImage;
 
-			void createAccumulateImages(EngineDevice& device, uint32_t width, uint32_t height, uint32_t imageCount);
+			std::shared_ptr<EngineImage> createAccumulateImage(EngineDevice& device, uint32_t width, uint32_t height);
 	};
 	
 }
\ No newline at end of file
@@ -29,26 +29,40 @@ namespace nugiEngine {
 
 			this->rayTraceImages.emplace_back(rayTraceImage);
 		}
+
+		// Frame commands may be recorded ahead of time, so the layout must not depend on which frame runs first
+		EngineImage::transitionImageLayout(this->rayTraceImages, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_ACCESS_SHADER_WRITE_BIT, 
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, nullptr, &device);
   }
 
 	void EngineRayTraceImage::prepareFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
-		if (this->rayTraceImages[frameIndex]->getLayout() == VK_IMAGE_LAYOUT_UNDEFINED) {
-			this->rayTraceImages[frameIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				0, VK_ACCESS_SHADER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-				commandBuffer);
-		} else {
-			this->rayTraceImages[frameIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				0, VK_ACCESS_SHADER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-				commandBuffer);
-		}
+		this->rayTraceImages[frameIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, VK_ACCESS_SHADER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			commandBuffer);
+	}
+
+	void EngineRayTraceImage::transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, 
+		uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) 
+	{
+		bool isReleased = srcQueueFamilyIndex != dstQueueFamilyIndex;
+
+		this->rayTraceImages[frameIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, isReleased ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
+			VK_ACCESS_SHADER_WRITE_BIT, isReleased ? 0 : VK_ACCESS_SHADER_READ_BIT, srcQueueFamilyIndex, dstQueueFamilyIndex,
+			commandBuffer);
 	}
 
-	void EngineRayTraceImage::transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
+	// Never handed back to the compute family. Skipped tiles and untraced pixels keep no defined value there, which is fine: 
+	// the sampling pass only uses pixels that the trace of the same frame has written (traced, reconstructed, or the hit 
+	// distance the tile pass stores after a camera move), and falls back to the accumulation for the rest.
+	void EngineRayTraceImage::acquireFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, 
+		uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) 
+	{
 		this->rayTraceImages[frameIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
-			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
-			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
+			0, VK_ACCESS_SHADER_READ_BIT, srcQueueFamilyIndex, dstQueueFamilyIndex,
 			commandBuffer);
 	}
 
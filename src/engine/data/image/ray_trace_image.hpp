@@ -15,7 +15,11 @@ namespace nugiEngine {
 			std::vector<VkDescriptorImageInfo> getImagesInfo() const;
       
       void prepareFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
-			void transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+			// With different families only the release half, acquireFrame() runs on the queue of dstQueueFamilyIndex
+			void transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, 
+				uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+			void acquireFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, 
+				uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex);
 			void finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
 
 		private:
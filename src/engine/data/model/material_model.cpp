@@ -8,25 +8,17 @@
 #include <glm/gtx/hash.hpp>
 
 namespace nugiEngine {
-	EngineMaterialModel::EngineMaterialModel(EngineDevice &device, std::shared_ptr<std::vector<Material>> materials, std::shared_ptr<EngineCommandBuffer> commandBuffer) : engineDevice{device} {
-		this->createBuffers(materials, commandBuffer);
+	EngineMaterialModel::EngineMaterialModel(EngineDevice &device, std::shared_ptr<std::vector<Material>> materials, std::shared_ptr<EngineBufferUploader> uploader) : engineDevice{device} {
+		if (uploader == nullptr) {
+			uploader = std::make_shared<EngineBufferUploader>(this->engineDevice, sizeof(Material) * materials->size());
+		}
+
+		this->createBuffers(materials, uploader);
 	}
 
-	void EngineMaterialModel::createBuffers(std::shared_ptr<std::vector<Material>> materials, std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+	void EngineMaterialModel::createBuffers(std::shared_ptr<std::vector<Material>> materials, std::shared_ptr<EngineBufferUploader> uploader) {
 		auto materialBufferSize = sizeof(Material) * materials->size();
 
-		EngineBuffer materialStagingBuffer {
-			this->engineDevice,
-			static_cast<VkDeviceSize>(materialBufferSize),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
-
-		materialStagingBuffer.map();
-		materialStagingBuffer.writeToBuffer(materials->data());
-
 		this->materialBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
 			static_cast<VkDeviceSize>(materialBufferSize),
@@ -36,7 +28,7 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->materialBuffer->copyBuffer(materialStagingBuffer.getBuffer(), static_cast<VkDeviceSize>(materialBufferSize), commandBuffer);
+		uploader->upload(*this->materialBuffer, materials->data(), static_cast<VkDeviceSize>(materialBufferSize));
 	} 
 } // namespace nugiEngine
 
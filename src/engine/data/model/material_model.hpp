@@ -3,6 +3,7 @@
 #include "../../../vulkan/device/device.hpp"
 #include "../../../vulkan/buffer/buffer.hpp"
 #include "../../../vulkan/command/command_buffer.hpp"
+#include "../../../vulkan/uploader/buffer_uploader.hpp"
 #include "../../general_struct.hpp"
 
 #define GLM_FORCE_RADIANS
@@ -15,7 +16,7 @@
 namespace nugiEngine {
 	class EngineMaterialModel {
 		public:
-			EngineMaterialModel(EngineDevice &device, std::shared_ptr<std::vector<Material>> materials, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+			EngineMaterialModel(EngineDevice &device, std::shared_ptr<std::vector<Material>> materials, std::shared_ptr<EngineBufferUploader> uploader = nullptr);
 
 			EngineMaterialModel(const EngineMaterialModel&) = delete;
 			EngineMaterialModel& operator = (const EngineMaterialModel&) = delete;
@@ -26,6 +27,6 @@ namespace nugiEngine {
 			EngineDevice &engineDevice;
 			std::shared_ptr<EngineBuffer> materialBuffer;
 
-			void createBuffers(std::shared_ptr<std::vector<Material>> materials, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+			void createBuffers(std::shared_ptr<std::vector<Material>> materials, std::shared_ptr<EngineBufferUploader> uploader);
 	};
 } // namespace nugiEngine
@@ -1,32 +1,126 @@
 #include "object_model.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <stdexcept>
 #include <iostream>
 #include <unordered_map>
 
 #include <tiny_obj_loader.h>
 
 namespace nugiEngine {
-	EngineObjectModel::EngineObjectModel(EngineDevice &device, std::shared_ptr<std::vector<Object>> objects, std::vector<std::shared_ptr<BoundBox>> boundBoxes, std::shared_ptr<EngineCommandBuffer> commandBuffer) : engineDevice{device} {
-		this->createBuffers(objects, createBvh(boundBoxes), commandBuffer);
+	EngineObjectModel::EngineObjectModel(EngineDevice &device, std::shared_ptr<std::vector<Object>> objects, std::vector<std::shared_ptr<TransformComponent>> transforms, 
+		bool isDynamic, std::shared_ptr<EngineBufferUploader> uploader, TaskPool *taskPool) 
+		: engineDevice{device}, taskPool{taskPool}, isDynamic{isDynamic}, transforms{transforms} 
+	{
+		this->build(objects);
+
+		if (isDynamic) {
+			this->pendingNodes.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
+			this->isObjectPending.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT, false);
+			this->createDynamicBuffers();
+		} else {
+			if (uploader == nullptr) {
+				uploader = std::make_shared<EngineBufferUploader>(this->engineDevice, sizeof(Object) * this->objects->size() + sizeof(WideBvhNode) * this->bvhNodes->size() + 16);
+			}
+
+			this->createBuffers(uploader);
+		}
 	}
 
-	void EngineObjectModel::createBuffers(std::shared_ptr<std::vector<Object>> objects, std::shared_ptr<std::vector<BvhNode>> bvhNodes, std::shared_ptr<EngineCommandBuffer> commandBuffer) {
-		auto objectBufferSize = sizeof(Object) * objects->size();
+	std::vector<VkDescriptorBufferInfo> EngineObjectModel::getObjectInfo() const {
+		std::vector<VkDescriptorBufferInfo> buffersInfo{};
 
-		EngineBuffer objectStagingBuffer {
-			this->engineDevice,
-			static_cast<VkDeviceSize>(objectBufferSize),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			buffersInfo.emplace_back(this->objectBuffers[i % this->objectBuffers.size()]->descriptorInfo());
+		}
+
+		return buffersInfo;
+	}
+
+	std::vector<VkDescriptorBufferInfo> EngineObjectModel::getBvhInfo() const {
+		std::vector<VkDescriptorBufferInfo> buffersInfo{};
+
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			buffersInfo.emplace_back(this->bvhBuffers[i % this->bvhBuffers.size()]->descriptorInfo());
+		}
+
+		return buffersInfo;
+	}
+
+	void EngineObjectModel::build(std::shared_ptr<std::vector<Object>> objects) {
+		BvhBuildReport report{};
+		std::vector<uint32_t> objectOrder;
+		this->bvhNodes = createWideBvh(createObjectBuildInput(*objects, this->transforms), objectOrder, &report, this->taskPool);
+
+		// Bvh leaves refer to ranges of objects, so keep them in leaf order
+		auto orderedObjects = std::make_shared<std::vector<Object>>();
+		orderedObjects->reserve(objects->size());
 
-		objectStagingBuffer.map();
-		objectStagingBuffer.writeToBuffer(objects->data());
+		for (auto &&objectIndex : objectOrder) {
+			orderedObjects->emplace_back((*objects)[objectIndex - 1]);
+		}
 
-		this->objectBuffer = std::make_shared<EngineBuffer>(
+		// There is only ever one object tree, a rebuild replaces the report of the last one
+		this->objects = orderedObjects;
+		this->bvhReport = report;
+
+		// Refitting a tree that is already up to date changes nothing, it only measures its SAH cost
+		this->builtSahCost = refitWideBvh(*this->bvhNodes, createObjectBuildInput(*this->objects, this->transforms)).sahCost;
+	}
+
+	void EngineObjectModel::refit(bool allowRebuild) {
+		if (!this->isDynamic) {
+			throw std::runtime_error("only a dynamic object model can be refitted");
+		}
+
+		BvhRefitResult result = refitWideBvh(*this->bvhNodes, createObjectBuildInput(*this->objects, this->transforms));
+		bool needRebuild = allowRebuild && result.sahCost > this->builtSahCost * rebuildSahRatio;
+
+		if (needRebuild) {
+			this->build(this->objects);
+
+			std::vector<uint32_t> nodeIndices(this->bvhNodes->size());
+			for (uint32_t i = 0; i < nodeIndices.size(); i++) {
+				nodeIndices[i] = i + 1;
+			}
+
+			for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+				this->pendingNodes[i] = nodeIndices;
+				this->isObjectPending[i] = true;
+			}
+
+			return;
+		}
+
+		for (auto &&framePendingNodes : this->pendingNodes) {
+			framePendingNodes.insert(framePendingNodes.end(), result.dirtyNodes.begin(), result.dirtyNodes.end());
+		}
+	}
+
+	void EngineObjectModel::update(uint32_t frameIndex) {
+		if (!this->isDynamic) {
+			return;
+		}
+
+		// This frame's buffers are not in use by the GPU any more, so they are written in place
+		if (this->isObjectPending[frameIndex]) {
+			this->objectBuffers[frameIndex]->writeToBuffer(this->objects->data(), sizeof(Object) * this->objects->size());
+			this->objectBuffers[frameIndex]->flush(sizeof(Object) * this->objects->size());
+			this->isObjectPending[frameIndex] = false;
+		}
+
+		if (!this->pendingNodes[frameIndex].empty()) {
+			this->writeBvhNodes(*this->bvhBuffers[frameIndex], this->pendingNodes[frameIndex]);
+			this->pendingNodes[frameIndex].clear();
+		}
+	}
+
+	void EngineObjectModel::createBuffers(std::shared_ptr<EngineBufferUploader> uploader) {
+		auto objectBufferSize = sizeof(Object) * this->objects->size();
+		auto bvhBufferSize = sizeof(WideBvhNode) * this->bvhNodes->size();
+
+		auto objectBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
 			static_cast<VkDeviceSize>(objectBufferSize),
 			1,
@@ -35,25 +129,12 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->objectBuffer->copyBuffer(objectStagingBuffer.getBuffer(), static_cast<VkDeviceSize>(objectBufferSize), commandBuffer);
+		uploader->upload(*objectBuffer, this->objects->data(), static_cast<VkDeviceSize>(objectBufferSize));
+		this->objectBuffers = { objectBuffer };
 
 		// -------------------------------------------------
 
-		auto bvhBufferSize = sizeof(BvhNode) * bvhNodes->size();
-
-		EngineBuffer bvhStagingBuffer {
-			this->engineDevice,
-			static_cast<VkDeviceSize>(bvhBufferSize),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
-
-		bvhStagingBuffer.map();
-		bvhStagingBuffer.writeToBuffer(bvhNodes->data());
-
-		this->bvhBuffer = std::make_shared<EngineBuffer>(
+		auto bvhBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
 			static_cast<VkDeviceSize>(bvhBufferSize),
 			1,
@@ -62,7 +143,71 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->bvhBuffer->copyBuffer(bvhStagingBuffer.getBuffer(), static_cast<VkDeviceSize>(bvhBufferSize), commandBuffer);
-	} 
-} // namespace nugiEngine
+		uploader->upload(*bvhBuffer, this->bvhNodes->data(), static_cast<VkDeviceSize>(bvhBufferSize));
+		this->bvhBuffers = { bvhBuffer };
+	}
+
+	// Host visible buffers, one per frame in flight, that stay mapped for the lifetime of the model
+	void EngineObjectModel::createDynamicBuffers() {
+		this->objectBuffers.clear();
+		this->bvhBuffers.clear();
+
+		// Every wide node has at least two children, so a rebuild never needs more than one node per object
+		auto bvhNodeCount = std::max(this->bvhNodes->size(), this->objects->size());
+
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			auto objectBuffer = std::make_shared<EngineBuffer>(
+				this->engineDevice,
+				sizeof(Object),
+				static_cast<uint32_t>(this->objects->size()),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+				VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+			);
 
+			objectBuffer->map();
+			objectBuffer->writeToBuffer(this->objects->data(), sizeof(Object) * this->objects->size());
+			objectBuffer->flush();
+
+			this->objectBuffers.emplace_back(objectBuffer);
+
+			auto bvhBuffer = std::make_shared<EngineBuffer>(
+				this->engineDevice,
+				sizeof(WideBvhNode),
+				static_cast<uint32_t>(bvhNodeCount),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+				VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+			);
+
+			bvhBuffer->map();
+			bvhBuffer->writeToBuffer(this->bvhNodes->data(), sizeof(WideBvhNode) * this->bvhNodes->size());
+			bvhBuffer->flush();
+
+			this->bvhBuffers.emplace_back(bvhBuffer);
+		}
+	}
+
+	// Runs of neighbouring nodes are written and flushed as one range
+	void EngineObjectModel::writeBvhNodes(EngineBuffer &bvhBuffer, std::vector<uint32_t> nodeIndices) {
+		std::sort(nodeIndices.begin(), nodeIndices.end());
+		nodeIndices.erase(std::unique(nodeIndices.begin(), nodeIndices.end()), nodeIndices.end());
+
+		uint32_t i = 0;
+
+		while (i < nodeIndices.size()) {
+			uint32_t runLength = 1;
+			while (i + runLength < nodeIndices.size() && nodeIndices[i + runLength] == nodeIndices[i] + runLength) {
+				runLength++;
+			}
+
+			VkDeviceSize size = static_cast<VkDeviceSize>(sizeof(WideBvhNode) * runLength);
+			VkDeviceSize offset = static_cast<VkDeviceSize>(sizeof(WideBvhNode) * (nodeIndices[i] - 1));
+
+			bvhBuffer.writeToBuffer(&(*this->bvhNodes)[nodeIndices[i] - 1], size, offset);
+			bvhBuffer.flush(size, offset);
+
+			i += runLength;
+		}
+	}
+} // namespace nugiEngine
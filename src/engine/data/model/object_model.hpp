@@ -3,7 +3,9 @@
 #include "../../../vulkan/device/device.hpp"
 #include "../../../vulkan/buffer/buffer.hpp"
 #include "../../../vulkan/command/command_buffer.hpp"
+#include "../../../vulkan/uploader/buffer_uploader.hpp"
 #include "../../utils/bvh/bvh.hpp"
+#include "../../utils/transform/transform.hpp"
 #include "../../general_struct.hpp"
 
 #define GLM_FORCE_RADIANS
@@ -16,17 +18,46 @@
 namespace nugiEngine {
 	class EngineObjectModel {
     public:
-      EngineObjectModel(EngineDevice &device, std::shared_ptr<std::vector<Object>> objects, std::vector<std::shared_ptr<BoundBox>> boundBoxes, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+      EngineObjectModel(EngineDevice &device, std::shared_ptr<std::vector<Object>> objects, std::vector<std::shared_ptr<TransformComponent>> transforms, 
+        bool isDynamic = false, std::shared_ptr<EngineBufferUploader> uploader = nullptr, TaskPool *taskPool = nullptr);
 
-      VkDescriptorBufferInfo getObjectInfo() { return this->objectBuffer->descriptorInfo();  }
-      VkDescriptorBufferInfo getBvhInfo() { return this->bvhBuffer->descriptorInfo(); }
+      EngineObjectModel(const EngineObjectModel&) = delete;
+      EngineObjectModel& operator = (const EngineObjectModel&) = delete;
+
+      // One buffer info per frame in flight. Without dynamic mode every frame shares the same buffer
+      std::vector<VkDescriptorBufferInfo> getObjectInfo() const;
+      std::vector<VkDescriptorBufferInfo> getBvhInfo() const;
+
+      BvhBuildReport getBvhReport() const { return this->bvhReport; }
+
+      // Dynamic mode only, from the render thread like EngineTransformationModel::markDirty. Refits the Bvh to the current transforms,
+      // or with allowRebuild rebuilds a tree whose SAH cost degraded past rebuildSahRatio. The changed nodes go into the buffer 
+      // of each frame as update() comes to it, so a frame in flight never sees a half written tree.
+      void refit(bool allowRebuild = true);
+      void update(uint32_t frameIndex);
 
     private:
       EngineDevice &engineDevice;
+      TaskPool *taskPool;
       
-      std::shared_ptr<EngineBuffer> objectBuffer;
-      std::shared_ptr<EngineBuffer> bvhBuffer;
+      std::vector<std::shared_ptr<EngineBuffer>> objectBuffers;
+      std::vector<std::shared_ptr<EngineBuffer>> bvhBuffers;
+
+      bool isDynamic = false;
+      std::shared_ptr<std::vector<Object>> objects{}; // in Bvh leaf order
+      std::shared_ptr<std::vector<WideBvhNode>> bvhNodes{};
+      std::vector<std::shared_ptr<TransformComponent>> transforms;
+
+      // Per frame in flight, what its buffers are still missing
+      std::vector<std::vector<uint32_t>> pendingNodes;
+      std::vector<bool> isObjectPending;
+
+      BvhBuildReport bvhReport{};
+      float builtSahCost = 0.0f;
 
-      void createBuffers(std::shared_ptr<std::vector<Object>> objects, std::shared_ptr<std::vector<BvhNode>> bvhNodes, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+      void build(std::shared_ptr<std::vector<Object>> objects);
+      void createBuffers(std::shared_ptr<EngineBufferUploader> uploader);
+      void createDynamicBuffers();
+      void writeBvhNodes(EngineBuffer &bvhBuffer, std::vector<uint32_t> nodeIndices);
 	};
 } // namespace nugiEngine
@@ -9,22 +9,18 @@
 
 namespace nugiEngine {
 	EnginePointLightModel::EnginePointLightModel(EngineDevice &device, std::shared_ptr<std::vector<PointLight>> pointLights, 
-		std::shared_ptr<std::vector<AreaLight>> areaLights, std::shared_ptr<EngineCommandBuffer> commandBuffer) : engineDevice{device} {
-		std::vector<std::shared_ptr<BoundBox>> boundBoxes;
+		std::shared_ptr<std::vector<AreaLight>> areaLights, std::shared_ptr<EngineBufferUploader> uploader, TaskPool *taskPool) : engineDevice{device} {
+		auto bvhNodes = createBvh(createAreaLightBuildInput(*areaLights), &this->bvhReport, taskPool);
 
-		/* for (int i = 0; i < pointLights->size(); i++) {
-			boundBoxes.push_back(std::make_shared<PointLightBoundBox>(PointLightBoundBox{ i + 1, (*pointLights)[i] }));
-		} */
-
-		for (int i = 0; i < areaLights->size(); i++) {
-			boundBoxes.push_back(std::make_shared<AreaLightBoundBox>(AreaLightBoundBox{ i + 1, (*areaLights)[i] }));
+		if (uploader == nullptr) {
+			uploader = std::make_shared<EngineBufferUploader>(this->engineDevice, sizeof(AreaLight) * areaLights->size() + sizeof(BvhNode) * bvhNodes->size() + 16);
 		}
 
-		this->createBuffers(pointLights, areaLights, createBvh(boundBoxes), commandBuffer);
+		this->createBuffers(pointLights, areaLights, bvhNodes, uploader);
 	}
 
 	void EnginePointLightModel::createBuffers(std::shared_ptr<std::vector<PointLight>> pointLights, std::shared_ptr<std::vector<AreaLight>> areaLights, 
-		std::shared_ptr<std::vector<BvhNode>> bvhNodes, std::shared_ptr<EngineCommandBuffer> commandBuffer) 
+		std::shared_ptr<std::vector<BvhNode>> bvhNodes, std::shared_ptr<EngineBufferUploader> uploader) 
 	{
 		/* auto pointLightBufferSize = sizeof(PointLight) * pointLights->size();
 		
@@ -54,18 +50,6 @@ namespace nugiEngine {
 		// ---
 
 		auto areaLightBufferSize = sizeof(AreaLight) * areaLights->size();
-		
-		EngineBuffer areaLightStagingBuffer {
-			this->engineDevice,
-			static_cast<VkDeviceSize>(areaLightBufferSize),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
-
-		areaLightStagingBuffer.map();
-		areaLightStagingBuffer.writeToBuffer(areaLights->data());
 
 		this->areaLightBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
@@ -76,24 +60,12 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->areaLightBuffer->copyBuffer(areaLightStagingBuffer.getBuffer(), static_cast<VkDeviceSize>(areaLightBufferSize), commandBuffer);
+		uploader->upload(*this->areaLightBuffer, areaLights->data(), static_cast<VkDeviceSize>(areaLightBufferSize));
 
 		// -------------------------------------------------
 
 		auto bvhBufferSize = sizeof(BvhNode) * bvhNodes->size();
 
-		EngineBuffer bvhStagingBuffer {
-			this->engineDevice,
-			static_cast<VkDeviceSize>(bvhBufferSize),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
-
-		bvhStagingBuffer.map();
-		bvhStagingBuffer.writeToBuffer(bvhNodes->data());
-
 		this->bvhBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
 			static_cast<VkDeviceSize>(bvhBufferSize),
@@ -103,7 +75,7 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->bvhBuffer->copyBuffer(bvhStagingBuffer.getBuffer(), static_cast<VkDeviceSize>(bvhBufferSize), commandBuffer);
+		uploader->upload(*this->bvhBuffer, bvhNodes->data(), static_cast<VkDeviceSize>(bvhBufferSize));
 	}
     
 } // namespace nugiEngine
@@ -3,6 +3,7 @@
 #include "../../../vulkan/device/device.hpp"
 #include "../../../vulkan/buffer/buffer.hpp"
 #include "../../../vulkan/command/command_buffer.hpp"
+#include "../../../vulkan/uploader/buffer_uploader.hpp"
 #include "../../utils/bvh/bvh.hpp"
 #include "../../general_struct.hpp"
 
@@ -17,11 +18,13 @@ namespace nugiEngine {
 	class EnginePointLightModel {
     public:
       EnginePointLightModel(EngineDevice &device, std::shared_ptr<std::vector<PointLight>> pointLights, 
-        std::shared_ptr<std::vector<AreaLight>> areaLights, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+        std::shared_ptr<std::vector<AreaLight>> areaLights, std::shared_ptr<EngineBufferUploader> uploader = nullptr, TaskPool *taskPool = nullptr);
 
       VkDescriptorBufferInfo getPointLightInfo() { return this->pointLightBuffer->descriptorInfo(); }
       VkDescriptorBufferInfo getAreaLightInfo() { return this->areaLightBuffer->descriptorInfo(); }
       VkDescriptorBufferInfo getBvhInfo() { return this->bvhBuffer->descriptorInfo(); }
+
+      BvhBuildReport getBvhReport() const { return this->bvhReport; }
       
     private:
       EngineDevice &engineDevice;
@@ -30,7 +33,9 @@ namespace nugiEngine {
       std::shared_ptr<EngineBuffer> areaLightBuffer;
       std::shared_ptr<EngineBuffer> bvhBuffer;
 
+      BvhBuildReport bvhReport{};
+
       void createBuffers(std::shared_ptr<std::vector<PointLight>> pointLights, std::shared_ptr<std::vector<AreaLight>> areaLights, 
-        std::shared_ptr<std::vector<BvhNode>> bvhNodes, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+        std::shared_ptr<std::vector<BvhNode>> bvhNodes, std::shared_ptr<EngineBufferUploader> uploader);
 	};
 } // namespace nugiEngine
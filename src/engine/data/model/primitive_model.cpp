@@ -8,9 +8,10 @@
 #include <tiny_obj_loader.h>
 
 namespace nugiEngine {
-	EnginePrimitiveModel::EnginePrimitiveModel(EngineDevice &device) : engineDevice{device} {
+	EnginePrimitiveModel::EnginePrimitiveModel(EngineDevice &device, TaskPool *taskPool) : engineDevice{device}, taskPool{taskPool} {
 		this->primitives = std::make_shared<std::vector<Primitive>>();
-		this->bvhNodes = std::make_shared<std::vector<BvhNode>>();
+		this->bvhNodes = std::make_shared<std::vector<WideBvhNode>>();
+		this->triangles = std::make_shared<std::vector<Triangle>>();
 	}
 
 	void EnginePrimitiveModel::addPrimitive(std::shared_ptr<std::vector<Primitive>> curPrimitives, std::shared_ptr<std::vector<Vertex>> vertices) {
@@ -20,34 +21,52 @@ namespace nugiEngine {
 			this->bvhNodes->emplace_back((*curBvhNodes)[i]);
 		}
 
+		// The vertices are only known here, so the triangles are prepared now and uploaded by createBuffers()
 		for (int i = 0; i < curPrimitives->size(); i++) {
 			this->primitives->emplace_back((*curPrimitives)[i]);
+			this->triangles->emplace_back(this->createTriangleData((*curPrimitives)[i], *vertices));
 		}
 	}
 
-	std::shared_ptr<std::vector<BvhNode>> EnginePrimitiveModel::createBvhData(std::shared_ptr<std::vector<Primitive>> primitives, std::shared_ptr<std::vector<Vertex>> vertices) {
-		std::vector<std::shared_ptr<BoundBox>> boundBoxes;
-		for (uint32_t i = 0; i < primitives->size(); i++) {
-			boundBoxes.push_back(std::make_shared<PrimitiveBoundBox>(PrimitiveBoundBox{ i + 1, (*primitives)[i], vertices }));
+	Triangle EnginePrimitiveModel::createTriangleData(const Primitive &primitive, const std::vector<Vertex> &vertices) {
+		glm::vec3 point0 = vertices[primitive.indices.x].position;
+		glm::vec3 edge1 = glm::vec3(vertices[primitive.indices.y].position) - point0;
+		glm::vec3 edge2 = glm::vec3(vertices[primitive.indices.z].position) - point0;
+
+		// Degenerate triangles are never hit, any normal does for them
+		glm::vec3 normal = glm::cross(edge1, edge2);
+		normal = glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : glm::vec3{0.0f, 0.0f, 1.0f};
+
+		return Triangle{ glm::vec4{point0, normal.x}, glm::vec4{edge1, normal.y}, glm::vec4{edge2, normal.z} };
+	}
+
+	std::shared_ptr<std::vector<WideBvhNode>> EnginePrimitiveModel::createBvhData(std::shared_ptr<std::vector<Primitive>> primitives, std::shared_ptr<std::vector<Vertex>> vertices) {
+		BvhBuildReport report{};
+		std::vector<uint32_t> primitiveOrder;
+		auto curBvhNodes = createWideBvh(createPrimitiveBuildInput(*primitives, *vertices), primitiveOrder, &report, this->taskPool);
+
+		// Bvh leaves refer to ranges of primitives, so store them in leaf order
+		std::vector<Primitive> orderedPrimitives;
+		orderedPrimitives.reserve(primitives->size());
+
+		for (auto &&primitiveIndex : primitiveOrder) {
+			orderedPrimitives.emplace_back((*primitives)[primitiveIndex - 1]);
 		}
 
-		return createBvh(boundBoxes);
+		*primitives = orderedPrimitives;
+
+		this->bvhReport.append(report);
+		return curBvhNodes;
 	}
 
-	void EnginePrimitiveModel::createBuffers(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+	void EnginePrimitiveModel::createBuffers(std::shared_ptr<EngineBufferUploader> uploader) {
 		auto primitiveBufferSize = sizeof(Primitive) * this->primitives->size();
+		auto bvhBufferSize = sizeof(WideBvhNode) * this->bvhNodes->size();
+		auto triangleBufferSize = sizeof(Triangle) * this->triangles->size();
 
-		EngineBuffer primitiveStagingBuffer {
-			this->engineDevice,
-			static_cast<VkDeviceSize>(primitiveBufferSize),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
-
-		primitiveStagingBuffer.map();
-		primitiveStagingBuffer.writeToBuffer(this->primitives->data());
+		if (uploader == nullptr) {
+			uploader = std::make_shared<EngineBufferUploader>(this->engineDevice, primitiveBufferSize + bvhBufferSize + triangleBufferSize + 16);
+		}
 
 		this->primitiveBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
@@ -58,34 +77,33 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->primitiveBuffer->copyBuffer(primitiveStagingBuffer.getBuffer(), static_cast<VkDeviceSize>(primitiveBufferSize), commandBuffer);
+		uploader->upload(*this->primitiveBuffer, this->primitives->data(), static_cast<VkDeviceSize>(primitiveBufferSize));
 
 		// -------------------------------------------------
 
-		auto bvhBufferSize = sizeof(BvhNode) * this->bvhNodes->size();
-
-		EngineBuffer bvhStagingBuffer {
+		this->bvhBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
 			static_cast<VkDeviceSize>(bvhBufferSize),
 			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
+			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+		);
 
-		bvhStagingBuffer.map();
-		bvhStagingBuffer.writeToBuffer(this->bvhNodes->data());
+		uploader->upload(*this->bvhBuffer, this->bvhNodes->data(), static_cast<VkDeviceSize>(bvhBufferSize));
 
-		this->bvhBuffer = std::make_shared<EngineBuffer>(
+		// -------------------------------------------------
+
+		this->triangleBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
-			static_cast<VkDeviceSize>(bvhBufferSize),
+			static_cast<VkDeviceSize>(triangleBufferSize),
 			1,
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VMA_MEMORY_USAGE_AUTO,
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->bvhBuffer->copyBuffer(bvhStagingBuffer.getBuffer(), static_cast<VkDeviceSize>(bvhBufferSize), commandBuffer);
+		uploader->upload(*this->triangleBuffer, this->triangles->data(), static_cast<VkDeviceSize>(triangleBufferSize));
 	}
 
 	/* std::shared_ptr<std::vector<Primitive>> EnginePrimitiveModel::createPrimitivesFromFile(EngineDevice &device, const std::string &filePath, uint32_t materialIndex) {
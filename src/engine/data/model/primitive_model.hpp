@@ -3,6 +3,7 @@
 #include "../../../vulkan/device/device.hpp"
 #include "../../../vulkan/buffer/buffer.hpp"
 #include "../../../vulkan/command/command_buffer.hpp"
+#include "../../../vulkan/uploader/buffer_uploader.hpp"
 #include "../../utils/bvh/bvh.hpp"
 #include "../../general_struct.hpp"
 
@@ -16,28 +17,38 @@
 namespace nugiEngine {
 	class EnginePrimitiveModel {
     public:
-      EnginePrimitiveModel(EngineDevice &device);
+      EnginePrimitiveModel(EngineDevice &device, TaskPool *taskPool = nullptr);
 
       VkDescriptorBufferInfo getPrimitiveInfo() { return this->primitiveBuffer->descriptorInfo();  }
       VkDescriptorBufferInfo getBvhInfo() { return this->bvhBuffer->descriptorInfo(); }
+      VkDescriptorBufferInfo getTriangleInfo() { return this->triangleBuffer->descriptorInfo(); }
 
       uint32_t getPrimitiveSize() const { return static_cast<uint32_t>(this->primitives->size()); }
+
+      // In buffer order, which is leaf order of the bvh of each object
+      std::shared_ptr<std::vector<Primitive>> getPrimitives() const { return this->primitives; }
       uint32_t getBvhSize() const { return static_cast<uint32_t>(this->bvhNodes->size()); }
+      BvhBuildReport getBvhReport() const { return this->bvhReport; }
 
       void addPrimitive(std::shared_ptr<std::vector<Primitive>> primitives, std::shared_ptr<std::vector<Vertex>> vertices);
-      void createBuffers(std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+      void createBuffers(std::shared_ptr<EngineBufferUploader> uploader = nullptr);
 
       // static std::shared_ptr<std::vector<Primitive>> createPrimitivesFromFile(EngineDevice &device, const std::string &filePath, uint32_t materialIndex);
       
     private:
       EngineDevice &engineDevice;
+      TaskPool *taskPool;
 
       std::shared_ptr<std::vector<Primitive>> primitives{};
-      std::shared_ptr<std::vector<BvhNode>> bvhNodes{};
+      std::shared_ptr<std::vector<WideBvhNode>> bvhNodes{};
+      std::shared_ptr<std::vector<Triangle>> triangles{};
+      BvhBuildReport bvhReport{};
       
       std::shared_ptr<EngineBuffer> primitiveBuffer;
       std::shared_ptr<EngineBuffer> bvhBuffer;
+      std::shared_ptr<EngineBuffer> triangleBuffer;
       
-      std::shared_ptr<std::vector<BvhNode>> createBvhData(std::shared_ptr<std::vector<Primitive>> primitives, std::shared_ptr<std::vector<Vertex>> vertices);
+      std::shared_ptr<std::vector<WideBvhNode>> createBvhData(std::shared_ptr<std::vector<Primitive>> primitives, std::shared_ptr<std::vector<Vertex>> vertices);
+      Triangle createTriangleData(const Primitive &primitive, const std::vector<Vertex> &vertices);
 	};
 } // namespace nugiEngine
@@ -1,5 +1,6 @@
 #include "transformation_model.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <unordered_map>
@@ -8,12 +9,84 @@
 #include <glm/gtx/hash.hpp>
 
 namespace nugiEngine {
-	EngineTransformationModel::EngineTransformationModel(EngineDevice &device, std::shared_ptr<std::vector<Transformation>> transformations, std::shared_ptr<EngineCommandBuffer> commandBuffer) : engineDevice{device} {
-		this->createBuffers(transformations, commandBuffer);
+	EngineTransformationModel::EngineTransformationModel(EngineDevice &device, std::shared_ptr<std::vector<Transformation>> transformations, std::shared_ptr<EngineBufferUploader> uploader) : engineDevice{device} {
+		if (uploader == nullptr) {
+			uploader = std::make_shared<EngineBufferUploader>(this->engineDevice, sizeof(Transformation) * transformations->size());
+		}
+
+		this->createBuffers(transformations, uploader);
+	}
+
+	EngineTransformationModel::EngineTransformationModel(EngineDevice& device, std::vector<std::shared_ptr<TransformComponent>> transformationComponents, bool isDynamic, std::shared_ptr<EngineBufferUploader> uploader) 
+		: engineDevice{device}, isDynamic{isDynamic}, transformationComponents{transformationComponents} 
+	{
+		if (isDynamic) {
+			this->transformations = this->convertToMatrix(transformationComponents);
+			this->pendingFrames.resize(transformationComponents.size(), 0);
+			this->createDynamicBuffers(this->transformations);
+		} else {
+			if (uploader == nullptr) {
+				uploader = std::make_shared<EngineBufferUploader>(this->engineDevice, sizeof(Transformation) * transformationComponents.size());
+			}
+
+			this->createBuffers(this->convertToMatrix(transformationComponents), uploader);
+		}
+	}
+
+	std::vector<VkDescriptorBufferInfo> EngineTransformationModel::getTransformationInfo() const {
+		std::vector<VkDescriptorBufferInfo> buffersInfo{};
+
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			buffersInfo.emplace_back(this->transformationBuffers[i % this->transformationBuffers.size()]->descriptorInfo());
+		}
+
+		return buffersInfo;
 	}
 
-	EngineTransformationModel::EngineTransformationModel(EngineDevice& device, std::vector<std::shared_ptr<TransformComponent>> transformationComponents, std::shared_ptr<EngineCommandBuffer> commandBuffer) : engineDevice{device} {
-		this->createBuffers(this->convertToMatrix(transformationComponents), commandBuffer);
+	void EngineTransformationModel::markDirty(uint32_t transformIndex) {
+		this->dirtyIndices.emplace_back(transformIndex);
+	}
+
+	void EngineTransformationModel::update(uint32_t frameIndex) {
+		if (!this->isDynamic) {
+			return;
+		}
+
+		for (auto &&transformIndex : this->dirtyIndices) {
+			auto &&transform = this->transformationComponents[transformIndex];
+			(*this->transformations)[transformIndex] = Transformation{ transform->getPointMatrix(), transform->getPointInverseMatrix(), transform->getDirInverseMatrix(), transform->getNormalMatrix() };
+
+			if (this->pendingFrames[transformIndex] == 0) {
+				this->pendingIndices.emplace_back(transformIndex);
+			}
+
+			this->pendingFrames[transformIndex] = EngineDevice::MAX_FRAMES_IN_FLIGHT;
+		}
+
+		this->dirtyIndices.clear();
+		if (this->pendingIndices.empty()) {
+			return;
+		}
+
+		// This frame's buffer is not in use by the GPU any more, so it is written in place
+		auto &&frameBuffer = this->transformationBuffers[frameIndex];
+		uint32_t firstIndex = UINT32_MAX, lastIndex = 0;
+
+		std::vector<uint32_t> stillPendingIndices;
+		for (auto &&transformIndex : this->pendingIndices) {
+			frameBuffer->writeToIndex(&(*this->transformations)[transformIndex], transformIndex);
+
+			firstIndex = std::min(firstIndex, transformIndex);
+			lastIndex = std::max(lastIndex, transformIndex);
+
+			this->pendingFrames[transformIndex]--;
+			if (this->pendingFrames[transformIndex] > 0) {
+				stillPendingIndices.emplace_back(transformIndex);
+			}
+		}
+
+		frameBuffer->flush((lastIndex - firstIndex + 1) * sizeof(Transformation), firstIndex * sizeof(Transformation));
+		this->pendingIndices = stillPendingIndices;
 	}
 
 	std::shared_ptr<std::vector<Transformation>> EngineTransformationModel::convertToMatrix(std::vector<std::shared_ptr<TransformComponent>> transformations) {
@@ -25,22 +98,10 @@ namespace nugiEngine {
 		return newTransforms;
 	}
 
-	void EngineTransformationModel::createBuffers(std::shared_ptr<std::vector<Transformation>> transformations, std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+	void EngineTransformationModel::createBuffers(std::shared_ptr<std::vector<Transformation>> transformations, std::shared_ptr<EngineBufferUploader> uploader) {
 		auto transformationBufferSize = sizeof(Transformation) * transformations->size();
 
-		EngineBuffer transformationStagingBuffer {
-			this->engineDevice,
-			static_cast<VkDeviceSize>(transformationBufferSize),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
-
-		transformationStagingBuffer.map();
-		transformationStagingBuffer.writeToBuffer(transformations->data());
-
-		this->transformationBuffer = std::make_shared<EngineBuffer>(
+		auto transformationBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
 			static_cast<VkDeviceSize>(transformationBufferSize),
 			1,
@@ -49,7 +110,29 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->transformationBuffer->copyBuffer(transformationStagingBuffer.getBuffer(), static_cast<VkDeviceSize>(transformationBufferSize), commandBuffer);
+		uploader->upload(*transformationBuffer, transformations->data(), static_cast<VkDeviceSize>(transformationBufferSize));
+		this->transformationBuffers = { transformationBuffer };
 	} 
-} // namespace nugiEngine
 
+	// Host visible buffers, one per frame in flight, that stay mapped for the lifetime of the model
+	void EngineTransformationModel::createDynamicBuffers(std::shared_ptr<std::vector<Transformation>> transformations) {
+		this->transformationBuffers.clear();
+
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			auto transformationBuffer = std::make_shared<EngineBuffer>(
+				this->engineDevice,
+				sizeof(Transformation),
+				static_cast<uint32_t>(transformations->size()),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+				VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+			);
+
+			transformationBuffer->map();
+			transformationBuffer->writeToBuffer(transformations->data());
+			transformationBuffer->flush();
+
+			this->transformationBuffers.emplace_back(transformationBuffer);
+		}
+	}
+} // namespace nugiEngine
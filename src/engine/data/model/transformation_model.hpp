@@ -3,6 +3,7 @@
 #include "../../../vulkan/device/device.hpp"
 #include "../../../vulkan/buffer/buffer.hpp"
 #include "../../../vulkan/command/command_buffer.hpp"
+#include "../../../vulkan/uploader/buffer_uploader.hpp"
 #include "../../general_struct.hpp"
 #include "../../utils/transform/transform.hpp"
 
@@ -16,19 +17,35 @@
 namespace nugiEngine {
 	class EngineTransformationModel {
 		public:
-			EngineTransformationModel(EngineDevice &device, std::shared_ptr<std::vector<Transformation>> transformations, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
-			EngineTransformationModel(EngineDevice &device, std::vector<std::shared_ptr<TransformComponent>> transformationComponents, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+			EngineTransformationModel(EngineDevice &device, std::shared_ptr<std::vector<Transformation>> transformations, std::shared_ptr<EngineBufferUploader> uploader = nullptr);
+			EngineTransformationModel(EngineDevice &device, std::vector<std::shared_ptr<TransformComponent>> transformationComponents, bool isDynamic = false, std::shared_ptr<EngineBufferUploader> uploader = nullptr);
 
 			EngineTransformationModel(const EngineTransformationModel&) = delete;
 			EngineTransformationModel& operator = (const EngineTransformationModel&) = delete;
 
-			VkDescriptorBufferInfo getTransformationInfo() { return this->transformationBuffer->descriptorInfo();  }
+			// One buffer info per frame in flight. Without dynamic mode every frame shares the same buffer
+			std::vector<VkDescriptorBufferInfo> getTransformationInfo() const;
+
+			// Dynamic mode: marked transforms are converted again on the next update and written into
+			// every frame's buffer in turn, as each of those frames comes up. Render thread only, 
+			// EngineApp::setTransform is the way in from other threads
+			void markDirty(uint32_t transformIndex);
+			void update(uint32_t frameIndex);
 			
 		private:
 			EngineDevice &engineDevice;
-			std::shared_ptr<EngineBuffer> transformationBuffer;
+			std::vector<std::shared_ptr<EngineBuffer>> transformationBuffers;
+
+			bool isDynamic = false;
+			std::vector<std::shared_ptr<TransformComponent>> transformationComponents;
+			std::shared_ptr<std::vector<Transformation>> transformations;
+
+			std::vector<uint32_t> dirtyIndices;
+			std::vector<uint32_t> pendingIndices;
+			std::vector<uint32_t> pendingFrames; // per transform, the number of frame buffers still holding old matrices
 
 			std::shared_ptr<std::vector<Transformation>> convertToMatrix(std::vector<std::shared_ptr<TransformComponent>> transformations);
-			void createBuffers(std::shared_ptr<std::vector<Transformation>> transformations, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+			void createBuffers(std::shared_ptr<std::vector<Transformation>> transformations, std::shared_ptr<EngineBufferUploader> uploader);
+			void createDynamicBuffers(std::shared_ptr<std::vector<Transformation>> transformations);
 	};
 } // namespace nugiEngine
@@ -8,33 +8,63 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 
 namespace nugiEngine {
-	EngineVertexModel::EngineVertexModel(EngineDevice &device, std::shared_ptr<std::vector<Vertex>> vertices, std::shared_ptr<std::vector<uint32_t>> indices, std::shared_ptr<EngineCommandBuffer> commandBuffer) : engineDevice{device} {
-		this->createVertexBuffers(vertices, commandBuffer);
-		this->createIndexBuffer(indices, commandBuffer);
+	EngineVertexModel::EngineVertexModel(EngineDevice &device, std::shared_ptr<std::vector<Vertex>> vertices, std::shared_ptr<std::vector<uint32_t>> indices, std::shared_ptr<EngineBufferUploader> uploader) : engineDevice{device} {
+		if (uploader == nullptr) {
+			uploader = std::make_shared<EngineBufferUploader>(this->engineDevice, (sizeof(VertexPosition) + sizeof(VertexAttribute)) * vertices->size() 
+				+ sizeof(uint32_t) * indices->size() + 16);
+		}
+
+		this->createVertexBuffers(vertices, uploader);
+		this->createIndexBuffer(indices, uploader);
+	}
+
+	// Same folding as octahedralEncode in core/octahedral.glsl
+	static glm::vec2 octahedralEncode(glm::vec3 normal) {
+		normal /= glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+
+		if (normal.z < 0.0f) {
+			glm::vec2 signs{normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f};
+			return (1.0f - glm::abs(glm::vec2{normal.y, normal.x})) * signs;
+		}
+
+		return glm::vec2{normal.x, normal.y};
 	}
 
-	void EngineVertexModel::createVertexBuffers(std::shared_ptr<std::vector<Vertex>> vertices, std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+	void EngineVertexModel::createVertexBuffers(std::shared_ptr<std::vector<Vertex>> vertices, std::shared_ptr<EngineBufferUploader> uploader) {
 		this->vertextCount = static_cast<uint32_t>(vertices->size());
 		assert(vertextCount >= 3 && "Vertex count must be at least 3");
 
-		uint32_t vertexSize = static_cast<uint32_t>(sizeof(Vertex));
-		VkDeviceSize bufferSize = vertexSize * vertextCount;
+		std::vector<VertexPosition> positions;
+		std::vector<VertexAttribute> attributes;
 
-		EngineBuffer stagingBuffer {
-			this->engineDevice,
-			vertexSize,
-			this->vertextCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
+		positions.reserve(this->vertextCount);
+		attributes.reserve(this->vertextCount);
+
+		for (auto &&vertex : *vertices) {
+			if (vertex.materialIndex > 0xFFFF || vertex.transformIndex > 0xFFFF) {
+				throw std::runtime_error("vertex material and transform index must fit in 16 bits");
+			}
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void *) vertices->data());
+			// The quad for the sampling pass has no normal, keep it out of the division
+			glm::vec3 normal = glm::vec3(vertex.normal);
+			glm::vec2 encodedNormal = glm::dot(normal, normal) > 0.0f ? octahedralEncode(glm::normalize(normal)) : glm::vec2{0.0f};
 
-		this->vertexBuffer = std::make_unique<EngineBuffer>(
+			positions.emplace_back(VertexPosition{ glm::vec3(vertex.position) });
+			attributes.emplace_back(VertexAttribute{ glm::packHalf2x16(glm::vec2(vertex.textCoord)), glm::packSnorm2x16(encodedNormal), 
+				vertex.materialIndex | (vertex.transformIndex << 16) });
+		}
+
+		this->positionBuffer = this->createVertexBuffer(static_cast<uint32_t>(sizeof(VertexPosition)), positions.data(), uploader);
+		this->attributeBuffer = this->createVertexBuffer(static_cast<uint32_t>(sizeof(VertexAttribute)), attributes.data(), uploader);
+	}
+
+	std::unique_ptr<EngineBuffer> EngineVertexModel::createVertexBuffer(uint32_t vertexSize, const void* data, std::shared_ptr<EngineBufferUploader> uploader) {
+		VkDeviceSize bufferSize = vertexSize * this->vertextCount;
+
+		auto buffer = std::make_unique<EngineBuffer>(
 			this->engineDevice,
 			vertexSize,
 			this->vertextCount,
@@ -43,10 +73,11 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->vertexBuffer->copyBuffer(stagingBuffer.getBuffer(), bufferSize, commandBuffer);
+		uploader->upload(*buffer, data, bufferSize);
+		return buffer;
 	}
 
-	void EngineVertexModel::createIndexBuffer(std::shared_ptr<std::vector<uint32_t>> indices, std::shared_ptr<EngineCommandBuffer> commandBuffer) { 
+	void EngineVertexModel::createIndexBuffer(std::shared_ptr<std::vector<uint32_t>> indices, std::shared_ptr<EngineBufferUploader> uploader) { 
 		this->indexCount = static_cast<uint32_t>(indices->size());
 		this->hasIndexBuffer = this->indexCount > 0;
 
@@ -57,18 +88,6 @@ namespace nugiEngine {
 		uint32_t indexSize = static_cast<uint32_t>(sizeof(uint32_t));
 		VkDeviceSize bufferSize = indexSize * this->indexCount;
 
-		EngineBuffer stagingBuffer {
-			this->engineDevice,
-			indexSize,
-			this->indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
-
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void *) indices->data());
-
 		this->indexBuffer = std::make_unique<EngineBuffer>(
 			this->engineDevice,
 			indexSize,
@@ -78,13 +97,13 @@ namespace nugiEngine {
 			VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
 		);
 
-		this->indexBuffer->copyBuffer(stagingBuffer.getBuffer(), bufferSize, commandBuffer);
+		uploader->upload(*this->indexBuffer, indices->data(), bufferSize);
 	}
 
 	void EngineVertexModel::bind(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
-		VkBuffer buffers[] = {this->vertexBuffer->getBuffer()};
-		VkDeviceSize offsets[] = {0};
-		vkCmdBindVertexBuffers(commandBuffer->getCommandBuffer(), 0, 1, buffers, offsets);
+		VkBuffer buffers[] = {this->positionBuffer->getBuffer(), this->attributeBuffer->getBuffer()};
+		VkDeviceSize offsets[] = {0, 0};
+		vkCmdBindVertexBuffers(commandBuffer->getCommandBuffer(), 0, 2, buffers, offsets);
 
 		if (this->hasIndexBuffer) {
 			vkCmdBindIndexBuffer(commandBuffer->getCommandBuffer(), this->indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
@@ -3,6 +3,7 @@
 #include "../../../vulkan/device/device.hpp"
 #include "../../../vulkan/buffer/buffer.hpp"
 #include "../../../vulkan/command/command_buffer.hpp"
+#include "../../../vulkan/uploader/buffer_uploader.hpp"
 #include "../../general_struct.hpp"
 
 #define GLM_FORCE_RADIANS
@@ -15,12 +16,13 @@
 namespace nugiEngine {
 	class EngineVertexModel {
 		public:
-			EngineVertexModel(EngineDevice &device, std::shared_ptr<std::vector<Vertex>> vertices, std::shared_ptr<std::vector<uint32_t>> indices, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+			EngineVertexModel(EngineDevice &device, std::shared_ptr<std::vector<Vertex>> vertices, std::shared_ptr<std::vector<uint32_t>> indices, std::shared_ptr<EngineBufferUploader> uploader = nullptr);
 
 			EngineVertexModel(const EngineVertexModel&) = delete;
 			EngineVertexModel& operator = (const EngineVertexModel&) = delete;
 
-			VkDescriptorBufferInfo getVertexInfo() { return this->vertexBuffer->descriptorInfo(); }
+			VkDescriptorBufferInfo getPositionInfo() { return this->positionBuffer->descriptorInfo(); }
+			VkDescriptorBufferInfo getAttributeInfo() { return this->attributeBuffer->descriptorInfo(); }
 			VkDescriptorBufferInfo getIndexInfo() { return this->indexBuffer->descriptorInfo(); }
 
 			void bind(std::shared_ptr<EngineCommandBuffer> commandBuffer);
@@ -29,7 +31,8 @@ namespace nugiEngine {
 		private:
 			EngineDevice &engineDevice;
 			
-			std::unique_ptr<EngineBuffer> vertexBuffer;
+			std::unique_ptr<EngineBuffer> positionBuffer;
+			std::unique_ptr<EngineBuffer> attributeBuffer;
 			uint32_t vertextCount;
 
 			std::unique_ptr<EngineBuffer> indexBuffer;
@@ -37,7 +40,8 @@ namespace nugiEngine {
 
 			bool hasIndexBuffer = false;
 
-			void createVertexBuffers(std::shared_ptr<std::vector<Vertex>> vertices, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
-			void createIndexBuffer(std::shared_ptr<std::vector<uint32_t>> indices, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+			void createVertexBuffers(std::shared_ptr<std::vector<Vertex>> vertices, std::shared_ptr<EngineBufferUploader> uploader);
+			std::unique_ptr<EngineBuffer> createVertexBuffer(uint32_t vertexSize, const void* data, std::shared_ptr<EngineBufferUploader> uploader);
+			void createIndexBuffer(std::shared_ptr<std::vector<uint32_t>> indices, std::shared_ptr<EngineBufferUploader> uploader);
 	};
 } // namespace nugiEngine
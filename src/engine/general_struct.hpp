@@ -16,17 +16,40 @@ namespace nugiEngine {
     uint32_t materialIndex{}; // Because of hybrid rendering, Material Index also hold by Vertex
     uint32_t transformIndex{}; // Because of hybrid rendering, Transform Index also hold by Vertex
 
+    // The GPU never sees this struct: EngineVertexModel splits it into a VertexPosition stream on binding 0 
+    // and a VertexAttribute stream on binding 1, which is what these describe
     static std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions();
     static std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions();
 
     bool operator == (const Vertex &other) const;
   };
 
+  // 12 bytes, all the traversal reads of a vertex
+  struct VertexPosition {
+    glm::vec3 position{};
+  };
+
+  // 12 bytes of shading data: half float texture coordinate, octahedral normal in two snorm16, 
+  // and the material index in the low and the transform index in the high 16 bits of indices
+  struct VertexAttribute {
+    uint32_t textCoord{};
+    uint32_t normal{};
+    uint32_t indices{};
+  };
+
   struct Primitive {
     alignas(16) glm::uvec3 indices;
     uint32_t materialIndex;
   };
 
+  // A primitive in edge form for the intersection test, at the same index as in the primitive buffer.
+  // The w components hold the unit geometric normal: x in point0, y in edge1 and z in edge2.
+  struct Triangle {
+    glm::vec4 point0{};
+    glm::vec4 edge1{};
+    glm::vec4 edge2{};
+  };
+
   struct Object {
     uint32_t firstBvhIndex = 0;
     uint32_t firstPrimitiveIndex = 0;
@@ -43,6 +66,23 @@ namespace nugiEngine {
     alignas(16) glm::vec3 minimum;
   };
 
+  // 4-wide Bvh node, 64 bytes. Child boxes are quantised to 8 bits per axis relative to origin,
+  // with a power of two step per axis (biased exponent in one byte each of exponents).
+  // Byte i of every quantized component and of leafCounts belongs to children[i]. A child is a (1-based) node index, 
+  // or wideBvhLeafFlag | first object for a leaf covering leafCounts objects from there on.
+  struct WideBvhNode {
+    alignas(16) glm::vec3 origin{0.0f};
+    uint32_t exponents = 0;
+
+    alignas(16) glm::uvec4 children{0u};
+
+    alignas(16) glm::uvec3 quantizedMinimum{0u};
+    uint32_t childCount = 0;
+
+    alignas(16) glm::uvec3 quantizedMaximum{0u};
+    uint32_t leafCounts = 0;
+  };
+
   struct Material {
     alignas(16) glm::vec3 baseColor;
     float metallicness;
@@ -72,18 +112,128 @@ namespace nugiEngine {
     alignas(16) glm::vec3 color;
   };
 
+  // Share of the pixels traced per sample, the others are reconstructed from their traced neighbours. 
+  // Has to match core/trace_pattern.glsl
+  enum TraceMode : uint32_t {
+    TRACE_MODE_FULL = 0,
+    TRACE_MODE_CHECKERBOARD = 1,
+    TRACE_MODE_HALF = 2
+  };
+
   struct RayTraceUbo {
     alignas(16) glm::vec3 origin;
     alignas(16) glm::vec3 background;
     uint32_t numLights = 0;
+    uint32_t randomSeed = 0;
+
+    // Russian roulette starts at minBounce, no path goes past maxBounce
+    uint32_t minBounce = 3;
+    uint32_t maxBounce = 50;
+
+    // Shifts the random streams without touching randomSeed, which also restarts the accumulation at 0
+    uint32_t seedOffset = 0;
+
+    // Adaptive sampling: a pixel stops being traced after minSamples once the standard error of its mean luminance 
+    // is below errorThreshold of that mean. Zero traces every pixel on every frame.
+    uint32_t minSamples = 16;
+    float errorThreshold = 0.0f;
+
+    // Tiled rendering traces only the tileCount tiles from firstTile on in a frame
+    uint32_t firstTile = 0;
+    uint32_t tileCount = UINT32_MAX;
+
+    uint32_t traceMode = TRACE_MODE_FULL;
+
+    // Temporal accumulation: on the frame after a camera move (isCameraMoved), the sampling pass reprojects the 
+    // accumulation of the previous camera instead of starting over, keeping at most maxHistory samples of it. Zero starts over.
+    alignas(16) glm::mat4 inverseViewProjection{1.0f};
+    alignas(16) glm::mat4 previousViewProjection{1.0f};
+    alignas(16) glm::vec3 previousOrigin{0.0f};
+    uint32_t maxHistory = 0;
+    uint32_t isCameraMoved = 0;
+
+    // Primary hits come from the visibility buffer instead of the G-buffer
+    uint32_t isVisibilityBuffer = 0;
+
+    // The trace reads the statistics as the last sampling of its frame slot left them. Set while those predate 
+    // the last restart or camera move, nothing counts as converged then.
+    uint32_t isStatisticsStale = 0;
+  };
+
+  // Running luminance mean and squared deviation (Welford) of one pixel, kept by the sampling pass
+  struct PixelStatistics {
+    uint32_t sampleCount;
+    float mean;
+    float m2;
+  };
+
+  // Wavefront path state and queues, only ever touched by the GPU
+  struct WavefrontPath {
+    alignas(16) glm::vec3 radiance;
+    float indirectPdf;
+
+    alignas(16) glm::vec3 throughput;
+    float pendingIndirectPdf;
+
+    alignas(16) glm::vec3 pendingIndirect;
+    float pendingDirectPdf;
+
+    alignas(16) glm::vec3 pendingDirect;
+
+    alignas(16) glm::vec3 rayOrigin;
+    alignas(16) glm::vec3 rayDirection;
+    alignas(16) glm::vec3 shadowOrigin;
+    alignas(16) glm::vec3 shadowDirection;
+  };
+
+  struct WavefrontHit {
+    alignas(16) glm::vec3 point;
+    uint32_t pixelIndex;
+
+    alignas(16) glm::vec3 normal;
+    float roughness;
+
+    alignas(16) glm::vec3 rayDirection;
+    float fresnelReflect;
+
+    alignas(16) glm::vec3 baseColor;
+  };
+
+  struct WavefrontCounters {
+    uint32_t extendCounts[2];
+    uint32_t ggxCount;
+    uint32_t lambertCount;
+    uint32_t shadowCount;
+
+    alignas(16) glm::uvec4 extendArgs;
+    alignas(16) glm::uvec4 ggxArgs;
+    alignas(16) glm::uvec4 lambertArgs;
+    alignas(16) glm::uvec4 connectArgs;
+  };
+
+  // Runs of rays with equal sort keys in trace order, over all bounces of the last frame
+  struct WavefrontSortStatistics {
+    uint32_t unsortedRuns;
+    uint32_t sortedRuns;
+    uint32_t rayCount;
+  };
+
+  struct WavefrontSortBins {
+    static constexpr uint32_t BIN_COUNT = 4096;
+
+    WavefrontSortStatistics statistics;
+    uint32_t binCounts[BIN_COUNT];
+    uint32_t binOffsets[BIN_COUNT];
+  };
+
+  struct WavefrontPushConstant {
+    uint32_t bounce;
+    uint32_t stage;
+    uint32_t isSorted;
   };
 
   struct RasterUbo {
     glm::mat4 projection{1.0f};
 	  glm::mat4 view{1.0f};
   };
-
-  struct RayTracePushConstant {
-    uint32_t randomSeed;
-  };
 }
\ No newline at end of file
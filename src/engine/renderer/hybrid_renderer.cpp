@@ -5,28 +5,51 @@
 #include <string>
 
 namespace nugiEngine {
-	EngineHybridRenderer::EngineHybridRenderer(EngineWindow& window, EngineDevice& device) : appDevice{device}, appWindow{window} {
+	EngineHybridRenderer::EngineHybridRenderer(EngineWindow& window, EngineDevice& device) : appDevice{device}, appWindow{&window} {
+		this->init();
+	}
+
+	EngineHybridRenderer::EngineHybridRenderer(EngineDevice& device, VkExtent2D extent) : appDevice{device}, appWindow{nullptr}, offscreenExtent{extent} {
+		this->init();
+	}
+
+	void EngineHybridRenderer::init() {
+		this->createSyncObjects();
 		this->recreateSwapChain();
-		this->createSyncObjects(static_cast<uint32_t>(this->swapChain->imageCount()));
 
-		this->commandBuffers = EngineCommandBuffer::createCommandBuffers(device, EngineDevice::MAX_FRAMES_IN_FLIGHT);
+		this->commandBuffers = EngineCommandBuffer::createCommandBuffers(this->appDevice, EngineDevice::MAX_FRAMES_IN_FLIGHT);
+		this->rasterCommandBuffers = EngineCommandBuffer::createCommandBuffers(this->appDevice, EngineDevice::MAX_FRAMES_IN_FLIGHT);
+		this->traceCommandBuffers = EngineCommandBuffer::createCommandBuffers(this->appDevice, EngineDevice::MAX_FRAMES_IN_FLIGHT,
+			this->appDevice.getAsyncComputeCommandPool());
+
 		this->createDescriptorPool();
 	}
 
 	EngineHybridRenderer::~EngineHybridRenderer() {
 		this->descriptorPool->resetPool();
 		
+		this->destroyImageSyncObjects();
+		
     for (size_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
-			vkDestroySemaphore(this->appDevice.getLogicalDevice(), this->renderFinishedSemaphores[i], nullptr);
 			vkDestroySemaphore(this->appDevice.getLogicalDevice(), this->imageAvailableSemaphores[i], nullptr);
+			vkDestroySemaphore(this->appDevice.getLogicalDevice(), this->rasterFinishedSemaphores[i], nullptr);
+			vkDestroySemaphore(this->appDevice.getLogicalDevice(), this->traceFinishedSemaphores[i], nullptr);
 			vkDestroyFence(this->appDevice.getLogicalDevice(), this->inFlightFences[i], nullptr);
 		}
 	}
 
 	void EngineHybridRenderer::recreateSwapChain() {
-		auto extent = this->appWindow.getExtent();
+		if (this->appWindow == nullptr) {
+			this->swapChain = std::make_shared<EngineSwapChain>(this->appDevice, this->offscreenExtent, 
+				static_cast<uint32_t>(EngineDevice::MAX_FRAMES_IN_FLIGHT));
+
+			this->createImageSyncObjects(static_cast<uint32_t>(this->swapChain->imageCount()));
+			return;
+		}
+
+		auto extent = this->appWindow->getExtent();
 		while(extent.width == 0 || extent.height == 0) {
-			extent = this->appWindow.getExtent();
+			extent = this->appWindow->getExtent();
 			glfwWaitEvents();
 		}
 
@@ -42,6 +65,8 @@ namespace nugiEngine {
 				throw std::runtime_error("Swap chain image has changed");
 			}
 		}
+
+		this->createImageSyncObjects(static_cast<uint32_t>(this->swapChain->imageCount()));
 	}
 
 	void EngineHybridRenderer::createDescriptorPool() {
@@ -57,9 +82,10 @@ namespace nugiEngine {
 				.build();
 	}
 
-	void EngineHybridRenderer::createSyncObjects(uint32_t imageCount) {
+	void EngineHybridRenderer::createSyncObjects() {
 		imageAvailableSemaphores.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
-		renderFinishedSemaphores.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
+		rasterFinishedSemaphores.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
+		traceFinishedSemaphores.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
 		inFlightFences.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
 
 		VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -71,7 +97,8 @@ namespace nugiEngine {
 
 		for (size_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
 		  if (vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->imageAvailableSemaphores[i]) != VK_SUCCESS ||
-				vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->renderFinishedSemaphores[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->rasterFinishedSemaphores[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->traceFinishedSemaphores[i]) != VK_SUCCESS ||
 				vkCreateFence(this->appDevice.getLogicalDevice(), &fenceInfo, nullptr, &this->inFlightFences[i]) != VK_SUCCESS) 
 			{
 				throw std::runtime_error("failed to create synchronization objects for a frame!");
@@ -79,6 +106,31 @@ namespace nugiEngine {
 		}
 	}
 
+	void EngineHybridRenderer::createImageSyncObjects(uint32_t imageCount) {
+		this->destroyImageSyncObjects();
+
+		renderFinishedSemaphores.resize(imageCount);
+		imagesInFlight.assign(imageCount, VK_NULL_HANDLE);
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (uint32_t i = 0; i < imageCount; i++) {
+			if (vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->renderFinishedSemaphores[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create synchronization objects for a swap chain image!");
+			}
+		}
+	}
+
+	void EngineHybridRenderer::destroyImageSyncObjects() {
+		for (auto &&semaphore : this->renderFinishedSemaphores) {
+			vkDestroySemaphore(this->appDevice.getLogicalDevice(), semaphore, nullptr);
+		}
+
+		this->renderFinishedSemaphores.clear();
+		this->imagesInFlight.clear();
+	}
+
 	bool EngineHybridRenderer::acquireFrame() {
 		assert(!this->isFrameStarted && "can't acquire frame while frame still in progress");
 
@@ -94,6 +146,13 @@ namespace nugiEngine {
 			throw std::runtime_error("failed to acquire swap chain image");
 		}
 
+		// The image can come back before the frame that rendered into it has finished on the GPU
+		if (this->imagesInFlight[this->currentImageIndex] != VK_NULL_HANDLE) {
+			vkWaitForFences(this->appDevice.getLogicalDevice(), 1, &this->imagesInFlight[this->currentImageIndex], VK_TRUE, UINT64_MAX);
+		}
+
+		this->imagesInFlight[this->currentImageIndex] = this->inFlightFences[this->currentFrameIndex];
+
 		this->isFrameStarted = true;
 		return true;
 	}
@@ -105,6 +164,20 @@ namespace nugiEngine {
 		return this->commandBuffers[this->currentFrameIndex];
 	}
 
+	std::shared_ptr<EngineCommandBuffer> EngineHybridRenderer::beginRasterCommand() {
+		assert(this->isFrameStarted && "can't start command while frame still in progress");
+
+		this->rasterCommandBuffers[this->currentFrameIndex]->beginReccuringCommand();
+		return this->rasterCommandBuffers[this->currentFrameIndex];
+	}
+
+	std::shared_ptr<EngineCommandBuffer> EngineHybridRenderer::beginTraceCommand() {
+		assert(this->isFrameStarted && "can't start command while frame still in progress");
+
+		this->traceCommandBuffers[this->currentFrameIndex]->beginReccuringCommand();
+		return this->traceCommandBuffers[this->currentFrameIndex];
+	}
+
 	void EngineHybridRenderer::endCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
 		assert(this->isFrameStarted && "can't start command while frame still in progress");
 		commandBuffer->endCommand();
@@ -115,10 +188,17 @@ namespace nugiEngine {
 		vkResetFences(this->appDevice.getLogicalDevice(), 1, &this->inFlightFences[this->currentFrameIndex]);
 
 		std::vector<VkSemaphore> waitSemaphores = { this->imageAvailableSemaphores[this->currentFrameIndex] };
-		std::vector<VkSemaphore> signalSemaphores = { this->renderFinishedSemaphores[this->currentFrameIndex] };
+		std::vector<VkSemaphore> signalSemaphores = { this->renderFinishedSemaphores[this->currentImageIndex] };
 		std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
-		EngineCommandBuffer::submitCommands(commandBuffers, this->appDevice.getGraphicsQueue(this->currentFrameIndex), waitSemaphores, waitStages, signalSemaphores, this->inFlightFences[this->currentFrameIndex]);
+		// Offscreen images are neither acquired nor presented, so nothing would ever signal or wait on the semaphores
+		if (this->swapChain->isOffscreen()) {
+			waitSemaphores.clear();
+			signalSemaphores.clear();
+			waitStages.clear();
+		}
+
+		EngineCommandBuffer::submitCommands(commandBuffers, this->appDevice.getGraphicsQueue(0), waitSemaphores, waitStages, signalSemaphores, this->inFlightFences[this->currentFrameIndex]);
 	}
 
 	void EngineHybridRenderer::submitRenderCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
@@ -126,25 +206,87 @@ namespace nugiEngine {
 		vkResetFences(this->appDevice.getLogicalDevice(), 1, &this->inFlightFences[this->currentFrameIndex]);
 
 		std::vector<VkSemaphore> waitSemaphores = { this->imageAvailableSemaphores[this->currentFrameIndex] };
-		std::vector<VkSemaphore> signalSemaphores = { this->renderFinishedSemaphores[this->currentFrameIndex] };
+		std::vector<VkSemaphore> signalSemaphores = { this->renderFinishedSemaphores[this->currentImageIndex] };
 		std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
-		commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(this->currentFrameIndex), waitSemaphores, waitStages, signalSemaphores, this->inFlightFences[this->currentFrameIndex]);
+		if (this->swapChain->isOffscreen()) {
+			waitSemaphores.clear();
+			signalSemaphores.clear();
+			waitStages.clear();
+		}
+
+		commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0), waitSemaphores, waitStages, signalSemaphores, this->inFlightFences[this->currentFrameIndex]);
+	}
+
+	void EngineHybridRenderer::submitFrameCommands(std::shared_ptr<EngineCommandBuffer> rasterCommandBuffer, std::shared_ptr<EngineCommandBuffer> traceCommandBuffer,
+		std::shared_ptr<EngineCommandBuffer> samplingCommandBuffer) 
+	{
+		assert(this->isFrameStarted && "can't submit command if frame is not in progress");
+		vkResetFences(this->appDevice.getLogicalDevice(), 1, &this->inFlightFences[this->currentFrameIndex]);
+
+		VkSemaphore rasterFinished = this->rasterFinishedSemaphores[this->currentFrameIndex];
+		VkSemaphore traceFinished = this->traceFinishedSemaphores[this->currentFrameIndex];
+
+		// A semaphore signal covers all earlier work on its queue, so on queue 0 the raster would wait for the last sampling pass. 
+		// With a single graphics queue it falls back to queue 0 and does.
+		this->submitQueue(this->appDevice.getGraphicsQueue(1), rasterCommandBuffer, {}, {}, { rasterFinished }, VK_NULL_HANDLE);
+
+		// Everything the trace shares with a sampling pass is kept per frame slot, and the last sampling of this slot 
+		// is behind the fence acquireFrame waited for. So the trace can run beside the sampling of the frame before.
+		this->submitQueue(this->appDevice.getAsyncComputeQueue(), traceCommandBuffer, { rasterFinished }, { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT }, 
+			{ traceFinished }, VK_NULL_HANDLE);
+
+		std::vector<VkSemaphore> waitSemaphores = { this->imageAvailableSemaphores[this->currentFrameIndex], traceFinished };
+		std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+		std::vector<VkSemaphore> signalSemaphores = { this->renderFinishedSemaphores[this->currentImageIndex] };
+
+		if (this->swapChain->isOffscreen()) {
+			waitSemaphores = { traceFinished };
+			waitStages = { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+			signalSemaphores.clear();
+		}
+
+		this->submitQueue(this->appDevice.getGraphicsQueue(0), samplingCommandBuffer, waitSemaphores, waitStages, 
+			signalSemaphores, this->inFlightFences[this->currentFrameIndex]);
+	}
+
+	// Unlike EngineCommandBuffer::submitCommand, never waits for the queue when there is no fence
+	void EngineHybridRenderer::submitQueue(VkQueue queue, std::shared_ptr<EngineCommandBuffer> commandBuffer, std::vector<VkSemaphore> waitSemaphores, 
+		std::vector<VkPipelineStageFlags> waitStages, std::vector<VkSemaphore> signalSemaphores, VkFence fence) 
+	{
+		VkCommandBuffer submittedCommandBuffer = commandBuffer->getCommandBuffer();
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &submittedCommandBuffer;
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+		submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+		if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit frame command buffer!");
+		}
 	}
 
 	bool EngineHybridRenderer::presentFrame() {
 		assert(this->isFrameStarted && "can't present frame if frame is not in progress");
 
-		std::vector<VkSemaphore> waitSemaphores = {this->renderFinishedSemaphores[this->currentFrameIndex]};
-		auto result = this->swapChain->presentRenders(this->appDevice.getPresentQueue(this->currentFrameIndex), &this->currentImageIndex, waitSemaphores);
+		std::vector<VkSemaphore> waitSemaphores = {this->renderFinishedSemaphores[this->currentImageIndex]};
+		auto result = this->swapChain->presentRenders(this->appDevice.getPresentQueue(0), &this->currentImageIndex, waitSemaphores);
 
 		this->currentFrameIndex = (this->currentFrameIndex + 1) % EngineDevice::MAX_FRAMES_IN_FLIGHT;
 		this->isFrameStarted = false;
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || this->appWindow.wasResized()) {
-			this->appWindow.resetResizedFlag();
+		if (this->appWindow == nullptr) {
+			return true;
+		}
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || this->appWindow->wasResized()) {
+			this->appWindow->resetResizedFlag();
 			this->recreateSwapChain();
-			this->descriptorPool->resetPool();
 
 			return false;
 		} else if (result != VK_SUCCESS) {
@@ -17,6 +17,9 @@ namespace nugiEngine {
 	{
 		public:
 			EngineHybridRenderer(EngineWindow& window, EngineDevice& device);
+
+			// Headless renderer drawing into an offscreen swap chain of the given extent
+			EngineHybridRenderer(EngineDevice& device, VkExtent2D extent);
 			~EngineHybridRenderer();
 
 			EngineHybridRenderer(const EngineHybridRenderer&) = delete;
@@ -42,30 +45,55 @@ namespace nugiEngine {
 			}
 
 			std::shared_ptr<EngineCommandBuffer> beginCommand();
+			std::shared_ptr<EngineCommandBuffer> beginRasterCommand();
+			std::shared_ptr<EngineCommandBuffer> beginTraceCommand();
 			void endCommand(std::shared_ptr<EngineCommandBuffer>);
 
 			void submitRenderCommands(std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffer);
 			void submitRenderCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer);
 
+			// Raster on graphics queue 1, trace on the async compute queue and sampling on graphics queue 0, chained by semaphores. 
+			// The raster of the next frame is not queued behind the sampling of this one, and its trace waits for nothing 
+			// but its own raster, so the next frame rasters and traces while this one resolves.
+			void submitFrameCommands(std::shared_ptr<EngineCommandBuffer> rasterCommandBuffer, std::shared_ptr<EngineCommandBuffer> traceCommandBuffer,
+				std::shared_ptr<EngineCommandBuffer> samplingCommandBuffer);
+
 			bool acquireFrame();
 			bool presentFrame();
 
 		private:
+			void init();
 			void recreateSwapChain();
-			void createSyncObjects(uint32_t imageCount);
+			void createSyncObjects();
+			void createImageSyncObjects(uint32_t imageCount);
+			void destroyImageSyncObjects();
 			void createDescriptorPool();
+			void submitQueue(VkQueue queue, std::shared_ptr<EngineCommandBuffer> commandBuffer, std::vector<VkSemaphore> waitSemaphores, 
+				std::vector<VkPipelineStageFlags> waitStages, std::vector<VkSemaphore> signalSemaphores, VkFence fence);
 
-			EngineWindow& appWindow;
+			EngineWindow* appWindow;
 			EngineDevice& appDevice;
 
 			std::shared_ptr<EngineSwapChain> swapChain;
 			std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffers;
+			std::vector<std::shared_ptr<EngineCommandBuffer>> rasterCommandBuffers;
+			std::vector<std::shared_ptr<EngineCommandBuffer>> traceCommandBuffers;
 
 			std::shared_ptr<EngineDescriptorPool> descriptorPool;
 
-			std::vector<VkSemaphore> imageAvailableSemaphores, renderFinishedSemaphores;
+			VkExtent2D offscreenExtent{};
+
+			// Per frame in flight
+			std::vector<VkSemaphore> imageAvailableSemaphores;
+			std::vector<VkSemaphore> rasterFinishedSemaphores;
+			std::vector<VkSemaphore> traceFinishedSemaphores;
 			std::vector<VkFence> inFlightFences;
 
+			// Per swap chain image: the present of an image may still wait on its semaphore when the next frame starts, 
+			// and the fence of the frame that last rendered into it
+			std::vector<VkSemaphore> renderFinishedSemaphores;
+			std::vector<VkFence> imagesInFlight;
+
 			uint32_t currentImageIndex = 0, currentFrameIndex = 0;
 			bool isFrameStarted = false, isLoadResouce = false;
 	};
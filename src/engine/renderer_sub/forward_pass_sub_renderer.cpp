@@ -4,17 +4,22 @@
 #include <array>
 
 namespace nugiEngine {
-  EngineForwardPassSubRenderer::EngineForwardPassSubRenderer(EngineDevice &device, int imageCount, int width, int height) 
-    : device{device}, width{width}, height{height}
+  EngineForwardPassSubRenderer::EngineForwardPassSubRenderer(EngineDevice &device, int imageCount, int width, int height, bool isVisibilityBuffer) 
+    : device{device}, width{width}, height{height}, isVisibilityBuffer{isVisibilityBuffer}
   {
     this->createPositionResources(imageCount);
     this->createTextCoordResources(imageCount);
     this->createNormalResources(imageCount);
     this->createAlbedoColorResources(imageCount);
     this->createMaterialResources(imageCount);
+    this->createVisibilityResources(imageCount);
     this->createDepthResources(imageCount);
 
-    this->createRenderPass(imageCount);
+    if (this->isVisibilityBuffer) {
+      this->createVisibilityRenderPass(imageCount);
+    } else {
+      this->createRenderPass(imageCount);
+    }
   }
 
   std::vector<VkDescriptorImageInfo> EngineForwardPassSubRenderer::getPositionInfoResources() {
@@ -62,18 +67,47 @@ namespace nugiEngine {
       return descInfos;
   }
 
+  std::vector<VkDescriptorImageInfo> EngineForwardPassSubRenderer::getVisibilityInfoResources() {
+    std::vector<VkDescriptorImageInfo> descInfos{};
+    for (auto &&visibilityInfo : this->visibilityResources) {
+      descInfos.emplace_back(visibilityInfo->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL));
+    }
+
+    return descInfos;
+  }
+
+  // Images the other kind of pass would draw into are only kept as 1x1 stand-ins for the descriptor sets. 
+  // They are never read, but are moved to GENERAL once to match their descriptors.
+  std::shared_ptr<EngineImage> EngineForwardPassSubRenderer::createResourceImage(VkFormat format, bool isDrawn) {
+    auto image = std::make_shared<EngineImage>(
+      this->device, isDrawn ? this->width : 1, isDrawn ? this->height : 1, 1, VK_SAMPLE_COUNT_1_BIT, format,
+      VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+      VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
+      VK_IMAGE_ASPECT_COLOR_BIT
+    );
+
+    if (!isDrawn) {
+      image->transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0);
+    }
+
+    return image;
+  }
+
+  std::vector<std::shared_ptr<EngineImage>> EngineForwardPassSubRenderer::getDrawnResources(uint32_t imageIndex) {
+    if (this->isVisibilityBuffer) {
+      return { this->visibilityResources[imageIndex] };
+    }
+
+    return { this->positionResources[imageIndex], this->textCoordResources[imageIndex],
+      this->normalResources[imageIndex], this->albedoColorResources[imageIndex], this->materialResources[imageIndex] };
+  }
+
   void EngineForwardPassSubRenderer::createPositionResources(int imageCount) {
     this->positionResources.clear();
 
     for (int i = 0; i < imageCount; i++) {
-      auto positionResource = std::make_shared<EngineImage>(
-        this->device, this->width, this->height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT,
-        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
-        VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
-        VK_IMAGE_ASPECT_COLOR_BIT
-      );
-
-      this->positionResources.push_back(positionResource);
+      this->positionResources.push_back(this->createResourceImage(POSITION_FORMAT, !this->isVisibilityBuffer));
     }
   }
 
@@ -81,14 +115,7 @@ namespace nugiEngine {
     this->textCoordResources.clear();
 
     for (int i = 0; i < imageCount; i++) {
-      auto textCoordResource = std::make_shared<EngineImage>(
-        this->device, this->width, this->height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT,
-        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
-        VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
-        VK_IMAGE_ASPECT_COLOR_BIT
-      );
-
-      this->textCoordResources.push_back(textCoordResource);
+      this->textCoordResources.push_back(this->createResourceImage(TEXT_COORD_FORMAT, !this->isVisibilityBuffer));
     }
   }
 
@@ -96,14 +123,7 @@ namespace nugiEngine {
     this->normalResources.clear();
 
     for (int i = 0; i < imageCount; i++) {
-      auto normalResource = std::make_shared<EngineImage>(
-        this->device, this->width, this->height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT,
-        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
-        VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
-        VK_IMAGE_ASPECT_COLOR_BIT
-      );
-
-      this->normalResources.push_back(normalResource);
+      this->normalResources.push_back(this->createResourceImage(NORMAL_FORMAT, !this->isVisibilityBuffer));
     }
   }
 
@@ -111,14 +131,7 @@ namespace nugiEngine {
     this->albedoColorResources.clear();
 
     for (int i = 0; i < imageCount; i++) {
-      auto colorImage = std::make_shared<EngineImage>(
-        this->device, this->width, this->height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT,
-        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
-        VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
-        VK_IMAGE_ASPECT_COLOR_BIT
-      );
-
-      this->albedoColorResources.push_back(colorImage);
+      this->albedoColorResources.push_back(this->createResourceImage(ALBEDO_COLOR_FORMAT, !this->isVisibilityBuffer));
     }
   }
 
@@ -126,14 +139,15 @@ namespace nugiEngine {
     this->materialResources.clear();
 
     for (int i = 0; i < imageCount; i++) {
-      auto materialResource = std::make_shared<EngineImage>(
-        this->device, this->width, this->height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT,
-        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
-        VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
-        VK_IMAGE_ASPECT_COLOR_BIT
-      );
+      this->materialResources.push_back(this->createResourceImage(MATERIAL_FORMAT, !this->isVisibilityBuffer));
+    }
+  }
+
+  void EngineForwardPassSubRenderer::createVisibilityResources(int imageCount) {
+    this->visibilityResources.clear();
 
-      this->materialResources.push_back(materialResource);
+    for (int i = 0; i < imageCount; i++) {
+      this->visibilityResources.push_back(this->createResourceImage(VISIBILITY_FORMAT, this->isVisibilityBuffer));
     }
   }
 
@@ -156,7 +170,7 @@ namespace nugiEngine {
 
   void EngineForwardPassSubRenderer::createRenderPass(int imageCount) {
     VkAttachmentDescription positionAttachment{};
-    positionAttachment.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    positionAttachment.format = POSITION_FORMAT;
     positionAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     positionAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     positionAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -174,7 +188,7 @@ namespace nugiEngine {
     positionColorBlendAttachment.blendEnable = VK_FALSE;
 
     VkAttachmentDescription textCoordAttachment{};
-    textCoordAttachment.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    textCoordAttachment.format = TEXT_COORD_FORMAT;
     textCoordAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     textCoordAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     textCoordAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -192,7 +206,7 @@ namespace nugiEngine {
     textCoordColorBlendAttachment.blendEnable = VK_FALSE;
 
     VkAttachmentDescription normalAttachment{};
-    normalAttachment.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    normalAttachment.format = NORMAL_FORMAT;
     normalAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     normalAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     normalAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -210,7 +224,7 @@ namespace nugiEngine {
     normalColorBlendAttachment.blendEnable = VK_FALSE;
 
     VkAttachmentDescription albedoColorAttachment{};
-    albedoColorAttachment.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    albedoColorAttachment.format = ALBEDO_COLOR_FORMAT;
     albedoColorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     albedoColorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     albedoColorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -228,7 +242,7 @@ namespace nugiEngine {
     albedoColorColorBlendAttachment.blendEnable = VK_FALSE;
 
     VkAttachmentDescription materialAttachment{};
-    materialAttachment.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    materialAttachment.format = MATERIAL_FORMAT;
     materialAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     materialAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     materialAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -314,6 +328,79 @@ namespace nugiEngine {
 		this->renderPass = renderPassBuilder.build();
   }
 
+  void EngineForwardPassSubRenderer::createVisibilityRenderPass(int imageCount) {
+    VkAttachmentDescription visibilityAttachment{};
+    visibilityAttachment.format = VISIBILITY_FORMAT;
+    visibilityAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    visibilityAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    visibilityAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    visibilityAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    visibilityAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    visibilityAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    visibilityAttachment.finalLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkAttachmentReference visibilityAttachmentRef = {};
+    visibilityAttachmentRef.attachment = 0;
+    visibilityAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkPipelineColorBlendAttachmentState visibilityColorBlendAttachment{};
+    visibilityColorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT;
+    visibilityColorBlendAttachment.blendEnable = VK_FALSE;
+
+    VkAttachmentDescription depthAttachment{};
+    depthAttachment.format = this->findDepthFormat();
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthAttachmentRef{};
+    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &visibilityAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+    VkSubpassDependency colorDependency{};
+    colorDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    colorDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    colorDependency.srcAccessMask = 0;
+    colorDependency.dstSubpass = 0;
+    colorDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    colorDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    VkSubpassDependency depthDependency{};
+    depthDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    depthDependency.srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    depthDependency.srcAccessMask = 0;
+    depthDependency.dstSubpass = 0;
+    depthDependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    depthDependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    EngineRenderPass::Builder renderPassBuilder = EngineRenderPass::Builder(this->device, this->width, this->height)
+      .addAttachments(visibilityAttachment)
+      .addAttachments(depthAttachment)
+      .addColorBlendAttachments(visibilityColorBlendAttachment)
+      .addSubpass(subpass)
+      .addDependency(colorDependency)
+      .addDependency(depthDependency);
+
+    for (int i = 0; i < imageCount; i++) {
+      renderPassBuilder.addViewImages({
+        this->visibilityResources[i]->getImageView(),
+        this->depthImages[i]->getImageView(),
+      });
+    }
+
+    this->renderPass = renderPassBuilder.build();
+  }
+
   VkFormat EngineForwardPassSubRenderer::findDepthFormat() {
     return this->device.findSupportedFormat(
       {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
@@ -330,13 +417,9 @@ namespace nugiEngine {
 		renderBeginInfo.renderArea.offset = { 0, 0 };
 		renderBeginInfo.renderArea.extent = { static_cast<uint32_t>(this->width), static_cast<uint32_t>(this->height) };
 
-		std::array<VkClearValue, 6> clearValues{};
-		clearValues[0].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-    clearValues[1].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-    clearValues[2].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-    clearValues[3].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-    clearValues[4].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-		clearValues[5].depthStencil = { 1.0f, 0 };
+		// Zero for every color attachment, then the depth
+		std::vector<VkClearValue> clearValues(this->isVisibilityBuffer ? 2 : 6);
+		clearValues.back().depthStencil = { 1.0f, 0 };
 
 		renderBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderBeginInfo.pClearValues = clearValues.data();
@@ -360,35 +443,27 @@ namespace nugiEngine {
 		vkCmdEndRenderPass(commandBuffer->getCommandBuffer());
 	}
 
-  void EngineForwardPassSubRenderer::transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t imageIndex) {
-    this->positionResources[imageIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, 
-      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-      commandBuffer);
-
-    this->textCoordResources[imageIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, 
-      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-      commandBuffer);
-
-    this->normalResources[imageIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, 
-      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-      commandBuffer);
-
-    this->albedoColorResources[imageIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, 
-      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-      commandBuffer);
-
-    this->materialResources[imageIndex]->transitionImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, 
-      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-      commandBuffer);
+  void EngineForwardPassSubRenderer::transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t imageIndex, 
+    uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) 
+  {
+    std::vector<std::shared_ptr<EngineImage>> images = this->getDrawnResources(imageIndex);
+
+    bool isReleased = srcQueueFamilyIndex != dstQueueFamilyIndex;
+
+    EngineImage::transitionImageLayout(images, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, isReleased ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, isReleased ? 0 : VK_ACCESS_SHADER_READ_BIT, 
+      srcQueueFamilyIndex, dstQueueFamilyIndex, commandBuffer);
+  }
+
+  // The render pass starts from an undefined layout, so the G-buffer never has to be handed back
+  void EngineForwardPassSubRenderer::acquireFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t imageIndex, 
+    uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) 
+  {
+    std::vector<std::shared_ptr<EngineImage>> images = this->getDrawnResources(imageIndex);
+
+    EngineImage::transitionImageLayout(images, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_ACCESS_SHADER_READ_BIT, 
+      srcQueueFamilyIndex, dstQueueFamilyIndex, commandBuffer);
   }
 } // namespace nugiEngine
\ No newline at end of file
@@ -10,7 +10,20 @@
 namespace nugiEngine {
   class EngineForwardPassSubRenderer {
     public:
-      EngineForwardPassSubRenderer(EngineDevice &device, int imageCount, int width, int height);
+      // 20 bytes per pixel instead of five RGBA32F images. The position is kept as its distance from the camera, 
+      // the normal as two octahedral snorm16 and the texture coordinates as two halves, each packed into one uint.
+      static constexpr VkFormat POSITION_FORMAT = VK_FORMAT_R32_SFLOAT;
+      static constexpr VkFormat TEXT_COORD_FORMAT = VK_FORMAT_R32_UINT;
+      static constexpr VkFormat NORMAL_FORMAT = VK_FORMAT_R32_UINT;
+      static constexpr VkFormat ALBEDO_COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+      static constexpr VkFormat MATERIAL_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+      // Primitive index plus one (zero where nothing was drawn) and the primary hit distance
+      static constexpr VkFormat VISIBILITY_FORMAT = VK_FORMAT_R32G32_UINT;
+
+      // A visibility buffer pass only writes the visibility image, the G-buffer images shrink to 1x1 and the other way round. 
+      // Both stay in the descriptor sets, the tracer picks the one that was drawn.
+      EngineForwardPassSubRenderer(EngineDevice &device, int imageCount, int width, int height, bool isVisibilityBuffer = false);
       std::shared_ptr<EngineRenderPass> getRenderPass() const { return this->renderPass; }
       
       std::vector<VkDescriptorImageInfo> getPositionInfoResources();
@@ -18,14 +31,21 @@ namespace nugiEngine {
       std::vector<VkDescriptorImageInfo> getNormalInfoResources();
       std::vector<VkDescriptorImageInfo> getAlbedoColorInfoResources();
       std::vector<VkDescriptorImageInfo> getMaterialInfoResources();
+      std::vector<VkDescriptorImageInfo> getVisibilityInfoResources();
 
       void beginRenderPass(std::shared_ptr<EngineCommandBuffer> commandBuffer, int currentImageIndex);
 			void endRenderPass(std::shared_ptr<EngineCommandBuffer> commandBuffer);
 
-      void transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t imageIndex);
+      // Hands the G-buffer over to the trace pass. With different families this is only the release half, 
+      // acquireFrame() has to run on the queue of dstQueueFamilyIndex.
+      void transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t imageIndex, 
+        uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+      void acquireFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t imageIndex, 
+        uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex);
       
     private:
       int width, height;
+      bool isVisibilityBuffer;
       EngineDevice &device;
 
       std::vector<std::shared_ptr<EngineImage>> positionResources;
@@ -33,20 +53,25 @@ namespace nugiEngine {
       std::vector<std::shared_ptr<EngineImage>> normalResources;
       std::vector<std::shared_ptr<EngineImage>> albedoColorResources;
       std::vector<std::shared_ptr<EngineImage>> materialResources;
+      std::vector<std::shared_ptr<EngineImage>> visibilityResources;
       std::vector<std::shared_ptr<EngineImage>> depthImages;
 
       std::shared_ptr<EngineRenderPass> renderPass;
 
       VkFormat findDepthFormat();
+      std::shared_ptr<EngineImage> createResourceImage(VkFormat format, bool isDrawn);
+      std::vector<std::shared_ptr<EngineImage>> getDrawnResources(uint32_t imageIndex);
       
       void createPositionResources(int imageCount);
       void createTextCoordResources(int imageCount);
       void createNormalResources(int imageCount);
       void createAlbedoColorResources(int imageCount);
       void createMaterialResources(int imageCount);
+      void createVisibilityResources(int imageCount);
       void createDepthResources(int imageCount);
       
       void createRenderPass(int imageCount);
+      void createVisibilityRenderPass(int imageCount);
   };
   
 } // namespace nugiEngine
\ No newline at end of file
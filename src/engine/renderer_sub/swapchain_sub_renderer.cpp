@@ -4,12 +4,13 @@
 #include <array>
 
 namespace nugiEngine {
-  EngineSwapChainSubRenderer::EngineSwapChainSubRenderer(EngineDevice &device, std::vector<std::shared_ptr<EngineImage>> swapChainImages, VkFormat swapChainImageFormat, int imageCount, int width, int height) 
+  EngineSwapChainSubRenderer::EngineSwapChainSubRenderer(EngineDevice &device, std::vector<std::shared_ptr<EngineImage>> swapChainImages, VkFormat swapChainImageFormat, int imageCount, int width, int height,
+    VkImageLayout finalLayout) 
     : device{device}, swapChainImages{swapChainImages}, width{width}, height{height}
   {
     this->createColorResources(swapChainImageFormat, imageCount);
     this->createDepthResources(imageCount);
-    this->createRenderPass(swapChainImageFormat, imageCount);
+    this->createRenderPass(swapChainImageFormat, imageCount, finalLayout);
   }
 
   void EngineSwapChainSubRenderer::createColorResources(VkFormat swapChainImageFormat, int imageCount) {
@@ -48,7 +49,7 @@ namespace nugiEngine {
     }
   }
 
-  void EngineSwapChainSubRenderer::createRenderPass(VkFormat swapChainImageFormat, int imageCount) {
+  void EngineSwapChainSubRenderer::createRenderPass(VkFormat swapChainImageFormat, int imageCount, VkImageLayout finalLayout) {
     auto msaaSamples = this->device.getMSAASamples();
 
     VkAttachmentDescription depthAttachment{};
@@ -91,7 +92,7 @@ namespace nugiEngine {
     colorResolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorResolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorResolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorResolveAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorResolveAttachment.finalLayout = finalLayout;
 
     VkAttachmentReference colorResolveAttachmentRef{};
     colorResolveAttachmentRef.attachment = 2;
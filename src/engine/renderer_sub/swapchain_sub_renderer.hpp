@@ -10,7 +10,8 @@
 namespace nugiEngine {
   class EngineSwapChainSubRenderer {
     public:
-      EngineSwapChainSubRenderer(EngineDevice &device, std::vector<std::shared_ptr<EngineImage>> swapChainImages, VkFormat swapChainImageFormat, int imageCount, int width, int height);
+      EngineSwapChainSubRenderer(EngineDevice &device, std::vector<std::shared_ptr<EngineImage>> swapChainImages, VkFormat swapChainImageFormat, int imageCount, int width, int height,
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
       std::shared_ptr<EngineRenderPass> getRenderPass() const { return this->renderPass; }
 
       void beginRenderPass(std::shared_ptr<EngineCommandBuffer> commandBuffer, int currentImageIndex);
@@ -30,7 +31,7 @@ namespace nugiEngine {
 
       void createColorResources(VkFormat swapChainImageFormat, int imageCount);
       void createDepthResources(int imageCount);
-      void createRenderPass(VkFormat swapChainImageFormat, int imageCount);
+      void createRenderPass(VkFormat swapChainImageFormat, int imageCount, VkImageLayout finalLayout);
   };
   
 } // namespace nugiEngine
@@ -0,0 +1,79 @@
+#include "adaptive_tile_render_system.hpp"
+
+#include <stdexcept>
+#include <array>
+#include <string>
+
+namespace nugiEngine {
+	EngineAdaptiveTileRenderSystem::EngineAdaptiveTileRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts, 
+		uint32_t width, uint32_t height, uint32_t traceMode) : appDevice{device}, width{width}, height{height}, 
+		tileExtent{EngineAdaptiveSampleBuffer::getTileExtent(traceMode)}
+	{
+		this->createPipelineLayout(descriptorSetLayouts->getDescriptorSetLayout());
+		this->createPipeline();
+	}
+
+	EngineAdaptiveTileRenderSystem::~EngineAdaptiveTileRenderSystem() {
+		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
+	}
+
+	void EngineAdaptiveTileRenderSystem::createPipelineLayout(VkDescriptorSetLayout descriptorSetLayouts) {
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayouts;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+	}
+
+	void EngineAdaptiveTileRenderSystem::createPipeline() {
+		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+		this->pipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/adaptive_tile.comp.spv")
+			.build();
+	}
+
+	void EngineAdaptiveTileRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, VkBuffer activeTileBuffer) {
+		VkCommandBuffer vkCommandBuffer = commandBuffer->getCommandBuffer();
+
+		// The previous trace on this queue may still read the tiles. The list starts empty, as a dispatch of 0 x 1 x 1 groups.
+		this->tileBarrier(commandBuffer);
+		vkCmdFillBuffer(vkCommandBuffer, activeTileBuffer, 0, sizeof(uint32_t), 0);
+		vkCmdFillBuffer(vkCommandBuffer, activeTileBuffer, sizeof(uint32_t), 2 * sizeof(uint32_t), 1);
+		this->tileBarrier(commandBuffer);
+
+		this->pipeline->bind(vkCommandBuffer);
+
+		vkCmdBindDescriptorSets(
+			vkCommandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			this->pipelineLayout,
+			0,
+			1,
+			&descriptorSets,
+			0,
+			nullptr
+		);
+
+		this->pipeline->dispatch(vkCommandBuffer, (this->width + this->tileExtent.width - 1) / this->tileExtent.width, 
+			(this->height + this->tileExtent.height - 1) / this->tileExtent.height, 1);
+		this->tileBarrier(commandBuffer);
+	}
+
+	void EngineAdaptiveTileRenderSystem::tileBarrier(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), 
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../../vulkan/command/command_buffer.hpp"
+#include "../../vulkan/device/device.hpp"
+#include "../../vulkan/pipeline/compute_pipeline.hpp"
+#include "../../vulkan/buffer/buffer.hpp"
+#include "../../vulkan/descriptor/descriptor.hpp"
+#include "../data/buffer/adaptive_sample_buffer.hpp"
+#include "../general_struct.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace nugiEngine {
+	// Marks the tiles whose pixels have not all converged and lists them as the indirect dispatch of the trace
+	class EngineAdaptiveTileRenderSystem {
+		public:
+			EngineAdaptiveTileRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts, uint32_t width, uint32_t height, 
+				uint32_t traceMode = TRACE_MODE_FULL);
+			~EngineAdaptiveTileRenderSystem();
+
+			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, VkBuffer activeTileBuffer);
+
+		private:
+			void createPipelineLayout(VkDescriptorSetLayout descriptorSetLayouts);
+			void createPipeline();
+
+			void tileBarrier(std::shared_ptr<EngineCommandBuffer> commandBuffer);
+
+			EngineDevice& appDevice;
+			
+			VkPipelineLayout pipelineLayout;
+			std::unique_ptr<EngineComputePipeline> pipeline;
+
+			uint32_t width, height;
+			VkExtent2D tileExtent;
+	};
+}
@@ -10,11 +10,12 @@
 #include <string>
 
 namespace nugiEngine {
-	EngineForwardPassRenderSystem::EngineForwardPassRenderSystem(EngineDevice& device, std::shared_ptr<EngineRenderPass> renderPass, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts)
+	EngineForwardPassRenderSystem::EngineForwardPassRenderSystem(EngineDevice& device, std::shared_ptr<EngineRenderPass> renderPass, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts, 
+		bool isVisibilityBuffer)
 		: appDevice{device}
 	{
 		this->createPipelineLayout(descriptorSetLayouts->getDescriptorSetLayout());
-		this->createPipeline(renderPass);
+		this->createPipeline(renderPass, isVisibilityBuffer);
 	}
 
 	EngineForwardPassRenderSystem::~EngineForwardPassRenderSystem() {
@@ -34,7 +35,7 @@ namespace nugiEngine {
 		}
 	}
 
-	void EngineForwardPassRenderSystem::createPipeline(std::shared_ptr<EngineRenderPass> renderPass) {
+	void EngineForwardPassRenderSystem::createPipeline(std::shared_ptr<EngineRenderPass> renderPass, bool isVisibilityBuffer) {
 		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
 		VkPipelineMultisampleStateCreateInfo multisampleInfo{};
@@ -43,7 +44,7 @@ namespace nugiEngine {
 		multisampleInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
 		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, renderPass, this->pipelineLayout)
-			.setDefault("shader/forward_pass.vert.spv", "shader/forward_pass.frag.spv")
+			.setDefault("shader/forward_pass.vert.spv", isVisibilityBuffer ? "shader/visibility_pass.frag.spv" : "shader/forward_pass.frag.spv")
 			.setMultisampleInfo(multisampleInfo)
 			.build();
 	}
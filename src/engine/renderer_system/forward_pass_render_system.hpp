@@ -16,14 +16,16 @@
 namespace nugiEngine {
 	class EngineForwardPassRenderSystem {
 		public:
-			EngineForwardPassRenderSystem(EngineDevice& device, std::shared_ptr<EngineRenderPass> renderPass, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts);
+			// The visibility buffer pass shares the vertex shader, only its fragment shader writes a single target
+			EngineForwardPassRenderSystem(EngineDevice& device, std::shared_ptr<EngineRenderPass> renderPass, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts, 
+				bool isVisibilityBuffer = false);
 			~EngineForwardPassRenderSystem();
 
 			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, std::shared_ptr<EngineVertexModel> model);
 		
 		private:
 			void createPipelineLayout(VkDescriptorSetLayout descriptorSetLayouts);
-			void createPipeline(std::shared_ptr<EngineRenderPass> renderPass);
+			void createPipeline(std::shared_ptr<EngineRenderPass> renderPass, bool isVisibilityBuffer);
 
 			EngineDevice& appDevice;
 			
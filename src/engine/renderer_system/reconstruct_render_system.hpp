@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../../vulkan/command/command_buffer.hpp"
+#include "../../vulkan/device/device.hpp"
+#include "../../vulkan/pipeline/compute_pipeline.hpp"
+#include "../../vulkan/buffer/buffer.hpp"
+#include "../../vulkan/descriptor/descriptor.hpp"
+#include "../general_struct.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace nugiEngine {
+	// Fills the pixels the checkerboard and half resolution modes leave out, guided by the G-buffer
+	class EngineReconstructRenderSystem {
+		public:
+			EngineReconstructRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts);
+			~EngineReconstructRenderSystem();
+
+			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, VkBuffer activeTileBuffer);
+
+		private:
+			void createPipelineLayout(VkDescriptorSetLayout descriptorSetLayouts);
+			void createPipeline();
+
+			EngineDevice& appDevice;
+			
+			VkPipelineLayout pipelineLayout;
+			std::unique_ptr<EngineComputePipeline> pipeline;
+	};
+}
@@ -22,17 +22,12 @@ namespace nugiEngine {
 	}
 
 	void EngineSamplingRenderSystem::createPipelineLayout(VkDescriptorSetLayout descriptorSetLayouts) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(RayTracePushConstant);
-
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = 1;
 		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayouts;
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create pipeline layout!");
@@ -47,7 +42,7 @@ namespace nugiEngine {
 			.build();
 	}
 
-	void EngineSamplingRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, std::shared_ptr<EngineVertexModel> model, uint32_t randomSeed) {
+	void EngineSamplingRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, std::shared_ptr<EngineVertexModel> model) {
 		this->pipeline->bind(commandBuffer->getCommandBuffer());
 
 		vkCmdBindDescriptorSets(
@@ -61,18 +56,6 @@ namespace nugiEngine {
 			nullptr
 		);
 
-		RayTracePushConstant pushConstant{};
-		pushConstant.randomSeed = randomSeed;
-
-		vkCmdPushConstants(
-			commandBuffer->getCommandBuffer(), 
-			this->pipelineLayout, 
-			VK_SHADER_STAGE_FRAGMENT_BIT,
-			0,
-			sizeof(RayTracePushConstant),
-			&pushConstant
-		);
-
 		model->bind(commandBuffer);
 		model->draw(commandBuffer);
 	}
@@ -10,7 +10,7 @@
 #include <string>
 
 namespace nugiEngine {
-	EngineTraceRayRenderSystem::EngineTraceRayRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts, uint32_t width, uint32_t height, uint32_t nSample) : appDevice{device}, width{width}, height{height}, nSample{nSample}
+	EngineTraceRayRenderSystem::EngineTraceRayRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts) : appDevice{device}
 	{
 		this->createPipelineLayout(descriptorSetLayouts->getDescriptorSetLayout());
 		this->createPipeline();
@@ -21,17 +21,12 @@ namespace nugiEngine {
 	}
 
 	void EngineTraceRayRenderSystem::createPipelineLayout(VkDescriptorSetLayout descriptorSetLayouts) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(RayTracePushConstant);
-
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = 1;
 		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayouts;
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create pipeline layout!");
@@ -46,7 +41,7 @@ namespace nugiEngine {
 			.build();
 	}
 
-	void EngineTraceRayRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, uint32_t randomSeed) {
+	void EngineTraceRayRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, VkBuffer activeTileBuffer) {
 		this->pipeline->bind(commandBuffer->getCommandBuffer());
 
 		vkCmdBindDescriptorSets(
@@ -60,18 +55,6 @@ namespace nugiEngine {
 			nullptr
 		);
 
-		RayTracePushConstant pushConstant{};
-		pushConstant.randomSeed = randomSeed;
-
-		vkCmdPushConstants(
-			commandBuffer->getCommandBuffer(), 
-			this->pipelineLayout, 
-			VK_SHADER_STAGE_COMPUTE_BIT,
-			0,
-			sizeof(RayTracePushConstant),
-			&pushConstant
-		);
-
-		this->pipeline->dispatch(commandBuffer->getCommandBuffer(), this->width / 8, this->height / 8, this->nSample / 1);
+		this->pipeline->dispatchIndirect(commandBuffer->getCommandBuffer(), activeTileBuffer, 0);
 	}
 }
\ No newline at end of file
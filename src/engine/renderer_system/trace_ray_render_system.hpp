@@ -13,12 +13,13 @@
 #include <vector>
 
 namespace nugiEngine {
+	// Runs one workgroup per tile listed by the adaptive tile pass
 	class EngineTraceRayRenderSystem {
 		public:
-			EngineTraceRayRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts, uint32_t width, uint32_t height, uint32_t nSample);
+			EngineTraceRayRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> descriptorSetLayouts);
 			~EngineTraceRayRenderSystem();
 
-			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, uint32_t randomSeed = 1);
+			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet descriptorSets, VkBuffer activeTileBuffer);
 
 		private:
 			void createPipelineLayout(VkDescriptorSetLayout descriptorSetLayouts);
@@ -28,7 +29,5 @@ namespace nugiEngine {
 			
 			VkPipelineLayout pipelineLayout;
 			std::unique_ptr<EngineComputePipeline> pipeline;
-
-			uint32_t width, height, nSample;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "wavefront_render_system.hpp"
+
+#include <stdexcept>
+#include <array>
+#include <string>
+#include <cstddef>
+
+namespace nugiEngine {
+	// Has to match the stages of wavefront_dispatch.comp
+	enum WavefrontStage : uint32_t {
+		WAVEFRONT_STAGE_EXTEND = 0,
+		WAVEFRONT_STAGE_SHADE = 1,
+		WAVEFRONT_STAGE_CONNECT = 2
+	};
+
+	EngineWavefrontRenderSystem::EngineWavefrontRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> rayTraceDescSetLayout, 
+		std::shared_ptr<EngineDescriptorSetLayout> wavefrontDescSetLayout, uint32_t width, uint32_t height, uint32_t maxBounce, bool isSorted) 
+		: appDevice{device}, width{width}, height{height}, maxBounce{maxBounce}, isSorted{isSorted}
+	{
+		this->createPipelineLayout(rayTraceDescSetLayout->getDescriptorSetLayout(), wavefrontDescSetLayout->getDescriptorSetLayout());
+		this->createPipeline();
+	}
+
+	EngineWavefrontRenderSystem::~EngineWavefrontRenderSystem() {
+		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
+	}
+
+	void EngineWavefrontRenderSystem::createPipelineLayout(VkDescriptorSetLayout rayTraceDescSetLayout, VkDescriptorSetLayout wavefrontDescSetLayout) {
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(WavefrontPushConstant);
+
+		VkDescriptorSetLayout descriptorSetLayouts[2] = { rayTraceDescSetLayout, wavefrontDescSetLayout };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 2;
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+	}
+
+	void EngineWavefrontRenderSystem::createPipeline() {
+		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+		this->generatePipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_generate.comp.spv")
+			.build();
+
+		this->dispatchPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_dispatch.comp.spv")
+			.build();
+
+		this->extendPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_extend.comp.spv")
+			.build();
+
+		this->shadeGgxPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_shade_ggx.comp.spv")
+			.build();
+
+		this->shadeLambertPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_shade_lambert.comp.spv")
+			.build();
+
+		this->connectPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_connect.comp.spv")
+			.build();
+
+		this->finishPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_finish.comp.spv")
+			.build();
+
+		if (!this->isSorted) {
+			return;
+		}
+
+		this->sortKeyPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_sort_key.comp.spv")
+			.build();
+
+		this->sortScanPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_sort_scan.comp.spv")
+			.build();
+
+		this->sortScatterPipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+			.setDefault("shader/wavefront_sort_scatter.comp.spv")
+			.build();
+	}
+
+	void EngineWavefrontRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet rayTraceDescSet, VkDescriptorSet wavefrontDescSet, 
+		const EngineWavefrontQueue &wavefrontQueue) 
+	{
+		VkCommandBuffer vkCommandBuffer = commandBuffer->getCommandBuffer();
+		VkDescriptorSet descriptorSets[2] = { rayTraceDescSet, wavefrontDescSet };
+		VkBuffer counterBuffer = wavefrontQueue.getCounterBuffer();
+
+		// The previous trace on this queue may still read the queues, and the counters start empty
+		this->stageBarrier(commandBuffer);
+		vkCmdFillBuffer(vkCommandBuffer, counterBuffer, 0, offsetof(WavefrontCounters, extendArgs), 0);
+
+		if (this->isSorted) {
+			vkCmdFillBuffer(vkCommandBuffer, wavefrontQueue.getSortBinBuffer(), 0, sizeof(WavefrontSortStatistics), 0);
+		}
+
+		this->stageBarrier(commandBuffer);
+
+		vkCmdBindDescriptorSets(
+			vkCommandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			this->pipelineLayout,
+			0,
+			2,
+			descriptorSets,
+			0,
+			nullptr
+		);
+
+		this->pushStage(commandBuffer, 0, WAVEFRONT_STAGE_SHADE);
+		this->generatePipeline->bind(vkCommandBuffer);
+		this->generatePipeline->dispatch(vkCommandBuffer, (this->width + 7) / 8, (this->height + 7) / 8, 1);
+		this->stageBarrier(commandBuffer);
+
+		for (uint32_t bounce = 0; bounce < this->maxBounce; bounce++) {
+			// Bounce 0 starts from the G-buffer, which the generate kernel already turned into hits
+			if (bounce > 0) {
+				this->prepareStage(commandBuffer, bounce, WAVEFRONT_STAGE_EXTEND);
+
+				if (this->isSorted) {
+					this->sortRays(commandBuffer, bounce, wavefrontQueue);
+					this->pushStage(commandBuffer, bounce, WAVEFRONT_STAGE_EXTEND, true);
+				}
+
+				this->extendPipeline->bind(vkCommandBuffer);
+				this->extendPipeline->dispatchIndirect(vkCommandBuffer, counterBuffer, offsetof(WavefrontCounters, extendArgs));
+				this->stageBarrier(commandBuffer);
+			}
+
+			this->prepareStage(commandBuffer, bounce, WAVEFRONT_STAGE_SHADE);
+
+			this->shadeGgxPipeline->bind(vkCommandBuffer);
+			this->shadeGgxPipeline->dispatchIndirect(vkCommandBuffer, counterBuffer, offsetof(WavefrontCounters, ggxArgs));
+
+			this->shadeLambertPipeline->bind(vkCommandBuffer);
+			this->shadeLambertPipeline->dispatchIndirect(vkCommandBuffer, counterBuffer, offsetof(WavefrontCounters, lambertArgs));
+			this->stageBarrier(commandBuffer);
+
+			this->prepareStage(commandBuffer, bounce, WAVEFRONT_STAGE_CONNECT);
+
+			this->connectPipeline->bind(vkCommandBuffer);
+			this->connectPipeline->dispatchIndirect(vkCommandBuffer, counterBuffer, offsetof(WavefrontCounters, connectArgs));
+			this->stageBarrier(commandBuffer);
+		}
+
+		this->finishPipeline->bind(vkCommandBuffer);
+		this->finishPipeline->dispatch(vkCommandBuffer, (this->width + 7) / 8, (this->height + 7) / 8, 1);
+	}
+
+	// Sizes the next stage from its input queue, all kernels of the stage then see the same bounce and stage
+	void EngineWavefrontRenderSystem::prepareStage(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t bounce, uint32_t stage) {
+		this->pushStage(commandBuffer, bounce, stage);
+
+		this->dispatchPipeline->bind(commandBuffer->getCommandBuffer());
+		this->dispatchPipeline->dispatch(commandBuffer->getCommandBuffer(), 1, 1, 1);
+		this->stageBarrier(commandBuffer);
+	}
+
+	// Counting sort of the queued rays over all key bits at once: count the keys, scan the bins, scatter into them
+	void EngineWavefrontRenderSystem::sortRays(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t bounce, const EngineWavefrontQueue &wavefrontQueue) {
+		VkCommandBuffer vkCommandBuffer = commandBuffer->getCommandBuffer();
+		VkBuffer counterBuffer = wavefrontQueue.getCounterBuffer();
+
+		vkCmdFillBuffer(vkCommandBuffer, wavefrontQueue.getSortBinBuffer(), offsetof(WavefrontSortBins, binCounts), 
+			sizeof(WavefrontSortBins::binCounts), 0);
+		this->stageBarrier(commandBuffer);
+
+		this->sortKeyPipeline->bind(vkCommandBuffer);
+		this->sortKeyPipeline->dispatchIndirect(vkCommandBuffer, counterBuffer, offsetof(WavefrontCounters, extendArgs));
+		this->stageBarrier(commandBuffer);
+
+		this->sortScanPipeline->bind(vkCommandBuffer);
+		this->sortScanPipeline->dispatch(vkCommandBuffer, 1, 1, 1);
+		this->stageBarrier(commandBuffer);
+
+		this->sortScatterPipeline->bind(vkCommandBuffer);
+		this->sortScatterPipeline->dispatchIndirect(vkCommandBuffer, counterBuffer, offsetof(WavefrontCounters, extendArgs));
+		this->stageBarrier(commandBuffer);
+	}
+
+	void EngineWavefrontRenderSystem::pushStage(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t bounce, uint32_t stage, bool isSorted) {
+		WavefrontPushConstant pushConstant{};
+		pushConstant.bounce = bounce;
+		pushConstant.stage = stage;
+		pushConstant.isSorted = isSorted ? 1u : 0u;
+
+		vkCmdPushConstants(
+			commandBuffer->getCommandBuffer(), 
+			this->pipelineLayout, 
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(WavefrontPushConstant),
+			&pushConstant
+		);
+	}
+
+	void EngineWavefrontRenderSystem::stageBarrier(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer->getCommandBuffer(), 
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../../vulkan/command/command_buffer.hpp"
+#include "../../vulkan/device/device.hpp"
+#include "../../vulkan/pipeline/compute_pipeline.hpp"
+#include "../../vulkan/buffer/buffer.hpp"
+#include "../../vulkan/descriptor/descriptor.hpp"
+#include "../data/buffer/wavefront_queue.hpp"
+#include "../general_struct.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace nugiEngine {
+	// Same integrator as EngineTraceRayRenderSystem, but every bounce is split into extend, shade (one pipeline per
+	// material type) and connect kernels working on compacted queues, so lanes of one dispatch run the same code.
+	// With isSorted, the rays of every bounce after the first are binned by origin cell and direction octant before they are traced.
+	class EngineWavefrontRenderSystem {
+		public:
+			EngineWavefrontRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorSetLayout> rayTraceDescSetLayout, 
+				std::shared_ptr<EngineDescriptorSetLayout> wavefrontDescSetLayout, uint32_t width, uint32_t height, uint32_t maxBounce = 50,
+				bool isSorted = false);
+			~EngineWavefrontRenderSystem();
+
+			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet rayTraceDescSet, VkDescriptorSet wavefrontDescSet, 
+				const EngineWavefrontQueue &wavefrontQueue);
+
+		private:
+			void createPipelineLayout(VkDescriptorSetLayout rayTraceDescSetLayout, VkDescriptorSetLayout wavefrontDescSetLayout);
+			void createPipeline();
+
+			void prepareStage(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t bounce, uint32_t stage);
+			void pushStage(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t bounce, uint32_t stage, bool isSorted = false);
+			void sortRays(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t bounce, const EngineWavefrontQueue &wavefrontQueue);
+			void stageBarrier(std::shared_ptr<EngineCommandBuffer> commandBuffer);
+
+			EngineDevice& appDevice;
+			
+			VkPipelineLayout pipelineLayout;
+
+			std::unique_ptr<EngineComputePipeline> generatePipeline;
+			std::unique_ptr<EngineComputePipeline> dispatchPipeline;
+			std::unique_ptr<EngineComputePipeline> extendPipeline;
+			std::unique_ptr<EngineComputePipeline> shadeGgxPipeline;
+			std::unique_ptr<EngineComputePipeline> shadeLambertPipeline;
+			std::unique_ptr<EngineComputePipeline> connectPipeline;
+			std::unique_ptr<EngineComputePipeline> finishPipeline;
+			std::unique_ptr<EngineComputePipeline> sortKeyPipeline;
+			std::unique_ptr<EngineComputePipeline> sortScanPipeline;
+			std::unique_ptr<EngineComputePipeline> sortScatterPipeline;
+
+			uint32_t width, height, maxBounce;
+			bool isSorted;
+	};
+}
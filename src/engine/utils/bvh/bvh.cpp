@@ -1,5 +1,11 @@
 #include "bvh.hpp"
 
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
 namespace nugiEngine {
   uint32_t Aabb::longestAxis() {
     float x = abs(max[0] - min[0]);
@@ -22,272 +28,790 @@ namespace nugiEngine {
     return rand() % 3;
   }
 
-  Aabb PrimitiveBoundBox::boundingBox() {
-    return Aabb { 
-      glm::min(glm::min((*this->vertices)[this->primitive.indices.x].position, (*this->vertices)[this->primitive.indices.y].position), (*this->vertices)[this->primitive.indices.z].position) - glm::vec4(eps, 0.0f),
-      glm::max(glm::max((*this->vertices)[this->primitive.indices.x].position, (*this->vertices)[this->primitive.indices.y].position), (*this->vertices)[this->primitive.indices.z].position) + glm::vec4(eps, 0.0f)
-    };
+  BvhNode BvhItemBuild::getGpuModel() {
+    bool leaf = leftNodeIndex == 0 && rightNodeIndex == 0;
+
+    BvhNode node{};
+    node.minimum = box.min;
+    node.maximum = box.max;      
+
+    if (leaf) {
+      node.leftObjIndex = leftObjIndex;
+      node.rightObjIndex = rightObjIndex;
+    } else {
+      node.leftNode = leftNodeIndex;
+      node.rightNode = rightNodeIndex;
+    }
+
+    return node;
   }
 
-  Aabb PointLightBoundBox::boundingBox() {
-    return Aabb { 
-      this->light.position - eps,
-      this->light.position + eps
-    };
+  float Aabb::surfaceArea() const {
+    glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
   }
 
-  Aabb AreaLightBoundBox::boundingBox() {
-    return Aabb { 
-      glm::min(glm::min(this->light.point0, this->light.point1), this->light.point2) - eps,
-      glm::max(glm::max(this->light.point0, this->light.point1), this->light.point2) + eps
-    };
+  void Aabb::grow(const Aabb &other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
   }
 
-  ObjectBoundBox::ObjectBoundBox(uint32_t i, Object &o, std::shared_ptr<std::vector<Primitive>> p, std::shared_ptr<TransformComponent> t, std::shared_ptr<std::vector<Vertex>> v) : BoundBox(i), object{o}, primitives{p}, transformation{t}, vertices{v} {
-    this->originalMin = glm::vec3(this->findMin(0), this->findMin(1), this->findMin(2));
-    this->originalMax = glm::vec3(this->findMax(0), this->findMax(1), this->findMax(2));
+  void Aabb::grow(const glm::vec3 &point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
   }
 
-  Aabb ObjectBoundBox::boundingBox() {
-    auto curTransf = glm::mat4{ 1.0f };
-    auto originScalePosition = glm::vec3((this->originalMax - this->originalMin) / 2.0f + this->originalMin);
+  void BvhBuildReport::append(const BvhBuildReport &other) {
+    float totalNodes = static_cast<float>(nodeCount + other.nodeCount);
+    if (totalNodes > 0.0f) {
+      sahCost = (sahCost * nodeCount + other.sahCost * other.nodeCount) / totalNodes;
+    }
 
-    curTransf = glm::translate(curTransf, this->transformation->translation);
-    
-    curTransf = glm::translate(curTransf, originScalePosition);
-    curTransf = glm::scale(curTransf, this->transformation->scale);    
+    buildTime += other.buildTime;
+    nodeCount += other.nodeCount;
+    leafCount += other.leafCount;
+    wideNodeCount += other.wideNodeCount;
+    maxDepth = std::max(maxDepth, other.maxDepth);
 
-    curTransf = glm::rotate(curTransf, this->transformation->rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
-    curTransf = glm::rotate(curTransf, this->transformation->rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
-    curTransf = glm::rotate(curTransf, this->transformation->rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    if (leafSizeHistogram.size() < other.leafSizeHistogram.size()) {
+      leafSizeHistogram.resize(other.leafSizeHistogram.size(), 0);
+    }
 
-    curTransf = glm::translate(curTransf, -1.0f * originScalePosition);
+    for (size_t i = 0; i < other.leafSizeHistogram.size(); i++) {
+      leafSizeHistogram[i] += other.leafSizeHistogram[i];
+    }
+  }
 
-    auto newMin = glm::vec4{FLT_MAX, FLT_MAX, FLT_MAX, 1.0f};
-    auto newMax = glm::vec4{FLT_MIN, FLT_MIN, FLT_MIN, 1.0f};
+  void BvhBuildReport::print(const std::string &name) const {
+    std::cout << "bvh " << name << ": " << buildTime << " ms, " << nodeCount << " nodes, " << leafCount << " leaves, max depth " 
+      << maxDepth << ", SAH cost " << sahCost;
 
-    for (int i = 0; i < 2; i++) {
-      for (int j = 0; j < 2; j++) {
-        for (int k = 0; k < 2; k++) {
-          auto x = i * this->originalMax.x + (1 - i) * this->originalMin.x;
-          auto y = j * this->originalMax.y + (1 - j) * this->originalMin.y;
-          auto z = k * this->originalMax.z + (1 - k) * this->originalMin.z;
+    if (wideNodeCount > 0) {
+      std::cout << ", " << wideNodeCount << " wide nodes";
+    }
 
-          auto newTransf = curTransf * glm::vec4(x, y, z, 1.0f);
+    std::cout << std::endl;
 
-          newMin = glm::min(newMin, newTransf);
-          newMax = glm::max(newMax, newTransf);
-        }
-      }
+    std::cout << "\tleaf size histogram:";
+    for (size_t i = 1; i < leafSizeHistogram.size(); i++) {
+      std::cout << " [" << i << "] " << leafSizeHistogram[i];
     }
 
-    return Aabb {
-      glm::vec3(newMin) - eps,
-      glm::vec3(newMax) + eps
-    };
+    std::cout << std::endl;
+  }
+
+  Aabb surroundingBox(Aabb box0, Aabb box1) {
+    return Aabb{ glm::min(box0.min, box1.min), glm::max(box0.max, box1.max) };
   }
 
-  float ObjectBoundBox::findMax(uint32_t index) {
-    float max = FLT_MIN;
-    for (auto &&primitive : *this->primitives) {
-      if ((*this->vertices)[primitive.indices.x].position[index] > max) max = (*this->vertices)[primitive.indices.x].position[index];
-      if ((*this->vertices)[primitive.indices.y].position[index] > max) max = (*this->vertices)[primitive.indices.y].position[index];
-      if ((*this->vertices)[primitive.indices.z].position[index] > max) max = (*this->vertices)[primitive.indices.z].position[index];
+  void BvhBins::merge(const BvhBins &other) {
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      for (uint32_t bin = 0; bin < binNumber; bin++) {
+        boxes[axis][bin].grow(other.boxes[axis][bin]);
+        counts[axis][bin] += other.counts[axis][bin];
+      }
     }
+  }
 
-    return max;
+  uint32_t findBinIndex(const glm::vec3 &centroid, uint32_t axis, const Aabb &centroidBox) {
+    float scale = binNumber / (centroidBox.max[axis] - centroidBox.min[axis]);
+    return std::min(binNumber - 1, static_cast<uint32_t>((centroid[axis] - centroidBox.min[axis]) * scale));
   }
 
-  float ObjectBoundBox::findMin(uint32_t index) {
-    float min = FLT_MAX;
-    for (auto &&primitive : *this->primitives) {
-      if ((*this->vertices)[primitive.indices.x].position[index] < min) min = (*this->vertices)[primitive.indices.x].position[index];
-      if ((*this->vertices)[primitive.indices.y].position[index] < min) min = (*this->vertices)[primitive.indices.y].position[index];
-      if ((*this->vertices)[primitive.indices.z].position[index] < min) min = (*this->vertices)[primitive.indices.z].position[index];
-    }
+  // Bin the object centroids along all three axes. Axes where every centroid lies on the same plane stay empty.
+  void fillBins(const std::vector<BvhBuildObject> &objects, uint32_t begin, uint32_t end, const Aabb &centroidBox, BvhBins &bins) {
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      if (centroidBox.max[axis] - centroidBox.min[axis] <= 0.0f) {
+        continue;
+      }
 
-    return min;
+      for (uint32_t i = begin; i < end; i++) {
+        uint32_t bin = findBinIndex(objects[i].centroid, axis, centroidBox);
+
+        bins.counts[axis][bin]++;
+        bins.boxes[axis][bin].grow(objects[i].box);
+      }
+    }
   }
 
-  BvhNode BvhItemBuild::getGpuModel() {
-    bool leaf = leftNodeIndex == 0 && rightNodeIndex == 0;
+  // Sweep the bins to find the cheapest SAH split plane. The returned bin is the first bin of the right child.
+  BvhSplit findBinnedSahSplit(const BvhBins &bins, const Aabb &box) {
+    BvhSplit bestSplit{};
+    float area = box.surfaceArea();
 
-    BvhNode node{};
-    node.minimum = box.min;
-    node.maximum = box.max;      
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      // Right-to-left sweep stores the area and count of everything at or after each split plane
+      float rightAreas[binNumber]{};
+      uint32_t rightCounts[binNumber]{};
 
-    if (leaf) {
-      node.leftObjIndex = objects[0]->index;
+      Aabb rightBox{};
+      uint32_t rightCount = 0;
+
+      for (uint32_t bin = binNumber - 1; bin > 0; bin--) {
+        rightBox.grow(bins.boxes[axis][bin]);
+        rightCount += bins.counts[axis][bin];
+
+        rightAreas[bin] = rightBox.surfaceArea();
+        rightCounts[bin] = rightCount;
+      }
+
+      Aabb leftBox{};
+      uint32_t leftCount = 0;
+
+      for (uint32_t bin = 1; bin < binNumber; bin++) {
+        leftBox.grow(bins.boxes[axis][bin - 1]);
+        leftCount += bins.counts[axis][bin - 1];
 
-      if (objects.size() > 1) {
-        node.rightObjIndex = objects[1]->index;
+        if (leftCount == 0 || rightCounts[bin] == 0) {
+          continue;
+        }
+
+        float cost = traversalCost + intersectionCost * (leftBox.surfaceArea() * leftCount + rightAreas[bin] * rightCounts[bin]) / area;
+        if (cost < bestSplit.cost) {
+          bestSplit.axis = axis;
+          bestSplit.bin = bin;
+          bestSplit.cost = cost;
+        }
       }
+    }
+
+    return bestSplit;
+  }
+
+  BvhBuilder::BvhBuilder(std::vector<BvhBuildObject> &objects, uint32_t maxLeafSize, TaskPool *taskPool) : objects{objects}, maxLeafSize{maxLeafSize}, taskPool{taskPool} {
+    // A binary tree whose leaves hold at least one object never has more than 2n - 1 nodes, 
+    // so the pool is allocated once and threads can claim nodes without locking
+    this->nodes.resize(2 * this->objects.size() - 1);
+    this->leafSizeHistogram.resize(this->maxLeafSize + 1, 0);
+  }
+
+  std::vector<BvhItemBuild> BvhBuilder::build() {
+    this->nodeCount = 1;
+    BvhBuildTask rootTask{ 1, 0, static_cast<uint32_t>(this->objects.size()), 0 };
+
+    if (this->taskPool != nullptr) {
+      this->taskPool->submit(this->taskGroup, [this, rootTask]() { this->buildSubtree(rootTask); });
+      this->taskPool->wait(this->taskGroup);
     } else {
-      node.leftNode = leftNodeIndex;
-      node.rightNode = rightNodeIndex;
+      this->buildSubtree(rootTask);
     }
 
-    return node;
+    return this->flatten();
   }
 
-  bool nodeCompare(BvhItemBuild &a, BvhItemBuild &b) {
-    return a.index < b.index;
+  void BvhBuilder::computeBounds(uint32_t begin, uint32_t end, Aabb &box, Aabb &centroidBox) {
+    if (this->taskPool == nullptr || end - begin < parallelBinObjects) {
+      for (uint32_t i = begin; i < end; i++) {
+        box.grow(this->objects[i].box);
+        centroidBox.grow(this->objects[i].centroid);
+      }
+
+      return;
+    }
+
+    uint32_t chunkCount = (end - begin + binChunkObjects - 1) / binChunkObjects;
+    std::vector<Aabb> chunkBoxes(chunkCount), chunkCentroidBoxes(chunkCount);
+    TaskGroup chunkGroup;
+
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+      this->taskPool->submit(chunkGroup, [this, &chunkBoxes, &chunkCentroidBoxes, chunk, begin, end]() {
+        uint32_t chunkEnd = std::min(end, begin + (chunk + 1) * binChunkObjects);
+
+        for (uint32_t i = begin + chunk * binChunkObjects; i < chunkEnd; i++) {
+          chunkBoxes[chunk].grow(this->objects[i].box);
+          chunkCentroidBoxes[chunk].grow(this->objects[i].centroid);
+        }
+      });
+    }
+
+    this->taskPool->wait(chunkGroup);
+
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+      box.grow(chunkBoxes[chunk]);
+      centroidBox.grow(chunkCentroidBoxes[chunk]);
+    }
   }
 
-  Aabb surroundingBox(Aabb box0, Aabb box1) {
-    return Aabb{ glm::min(box0.min, box1.min), glm::max(box0.max, box1.max) };
+  BvhBins BvhBuilder::computeBins(uint32_t begin, uint32_t end, const Aabb &centroidBox) {
+    BvhBins bins{};
+
+    if (this->taskPool == nullptr || end - begin < parallelBinObjects) {
+      fillBins(this->objects, begin, end, centroidBox, bins);
+      return bins;
+    }
+
+    uint32_t chunkCount = (end - begin + binChunkObjects - 1) / binChunkObjects;
+    std::vector<BvhBins> chunkBins(chunkCount);
+    TaskGroup chunkGroup;
+
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+      this->taskPool->submit(chunkGroup, [this, &chunkBins, &centroidBox, chunk, begin, end]() {
+        uint32_t chunkEnd = std::min(end, begin + (chunk + 1) * binChunkObjects);
+        fillBins(this->objects, begin + chunk * binChunkObjects, chunkEnd, centroidBox, chunkBins[chunk]);
+      });
+    }
+
+    this->taskPool->wait(chunkGroup);
+
+    // Merged in chunk order, so the result does not depend on which thread finished first
+    for (auto &&chunk : chunkBins) {
+      bins.merge(chunk);
+    }
+
+    return bins;
   }
 
-  Aabb objectListBoundingBox(std::vector<std::shared_ptr<BoundBox>> &objects) {
-    Aabb tempBox;
-    Aabb outputBox;
-    bool firstBox = true;
+  void BvhBuilder::buildSubtree(BvhBuildTask rootTask) {
+    std::stack<BvhBuildTask> taskStack;
+    taskStack.push(rootTask);
+
+    uint32_t localMaxDepth = 0;
+    std::vector<uint32_t> localLeafSizeHistogram(this->maxLeafSize + 1, 0);
+
+    while (!taskStack.empty()) {
+      BvhBuildTask task = taskStack.top();
+      taskStack.pop();
+
+      Aabb box{}, centroidBox{};
+      this->computeBounds(task.begin, task.end, box, centroidBox);
+
+      BvhItemBuild &node = this->nodes[task.nodeIndex - 1];
+      node.box = box;
+      localMaxDepth = std::max(localMaxDepth, task.depth);
+
+      uint32_t objectSpan = task.end - task.begin;
+      BvhSplit split{};
+
+      if (objectSpan > 1) {
+        split = findBinnedSahSplit(this->computeBins(task.begin, task.end, centroidBox), box);
+      }
+
+      // Keep the range as a leaf when intersecting all of it is cheaper than the best split.
+      // A leaf can not hold more than maxLeafSize, so larger ranges are split even if the SAH prefers a leaf
+      if (objectSpan <= this->maxLeafSize && intersectionCost * objectSpan <= split.cost) {
+        node.firstObject = task.begin;
+        node.objectCount = objectSpan;
+        node.leftObjIndex = this->objects[task.begin].index;
+        if (objectSpan > 1) {
+          node.rightObjIndex = this->objects[task.begin + 1].index;
+        }
+
+        localLeafSizeHistogram[objectSpan]++;
+        continue;
+      }
+
+      uint32_t mid = task.begin + objectSpan / 2;
 
-    for (auto &object : objects) {
-      tempBox = object->boundingBox();
-      outputBox = firstBox ? tempBox : surroundingBox(outputBox, tempBox);
-      firstBox = false;
+      if (split.cost < FLT_MAX) {
+        auto midIterator = std::partition(this->objects.begin() + task.begin, this->objects.begin() + task.end, 
+          [&](const BvhBuildObject &object) {
+            return findBinIndex(object.centroid, split.axis, centroidBox) < split.bin;
+          }
+        );
+
+        mid = static_cast<uint32_t>(std::distance(this->objects.begin(), midIterator));
+      }
+
+      // All centroids are in the same spot (or binning degenerated), fall back to splitting the range in half
+      if (mid == task.begin || mid == task.end) {
+        mid = task.begin + objectSpan / 2;
+      }
+
+      uint32_t leftNodeIndex = this->nodeCount.fetch_add(2) + 1;
+      uint32_t rightNodeIndex = leftNodeIndex + 1;
+
+      node.leftNodeIndex = leftNodeIndex;
+      node.rightNodeIndex = rightNodeIndex;
+
+      BvhBuildTask childTasks[2] = {
+        BvhBuildTask{ leftNodeIndex, task.begin, mid, task.depth + 1 },
+        BvhBuildTask{ rightNodeIndex, mid, task.end, task.depth + 1 }
+      };
+
+      for (auto &&childTask : childTasks) {
+        if (this->taskPool != nullptr && childTask.end - childTask.begin >= parallelTaskObjects) {
+          this->taskPool->submit(this->taskGroup, [this, childTask]() { this->buildSubtree(childTask); });
+        } else {
+          taskStack.push(childTask);
+        }
+      }
     }
 
-    return outputBox;
+    std::lock_guard<std::mutex> lock(this->statisticMutex);
+    this->maxDepth = std::max(this->maxDepth, localMaxDepth);
+
+    for (uint32_t i = 0; i <= this->maxLeafSize; i++) {
+      this->leafSizeHistogram[i] += localLeafSizeHistogram[i];
+    }
   }
 
-  bool boxCompare(std::shared_ptr<BoundBox> a, std::shared_ptr<BoundBox> b, uint32_t axis) {
-    Aabb boxA = a->boundingBox();
-    Aabb boxB = b->boundingBox();
+  // Renumber the node pool depth first: children are numbered when their parent is visited, 
+  // the right subtree is visited first. This is the same order the single threaded builder used.
+  std::vector<BvhItemBuild> BvhBuilder::flatten() {
+    std::vector<BvhItemBuild> flattenNodes;
+    flattenNodes.reserve(this->nodeCount);
+
+    std::stack<uint32_t> nodeStack;
+    nodeStack.push(1);
+
+    flattenNodes.emplace_back(this->nodes[0]);
+    flattenNodes[0].index = 1;
 
-    float Apos = (boxA.max[axis] - boxA.min[axis]) / 2 + boxA.min[axis];
-    float Bpos = (boxB.max[axis] - boxB.min[axis]) / 2 + boxB.min[axis];
+    std::vector<uint32_t> flattenIndices(this->nodeCount, 0);
+    flattenIndices[0] = 1;
 
-    return Apos < Bpos;
+    while (!nodeStack.empty()) {
+      uint32_t poolIndex = nodeStack.top();
+      nodeStack.pop();
+
+      BvhItemBuild &node = flattenNodes[flattenIndices[poolIndex - 1] - 1];
+      if (node.leftNodeIndex == 0 && node.rightNodeIndex == 0) {
+        continue;
+      }
+
+      uint32_t childPoolIndices[2] = { node.leftNodeIndex, node.rightNodeIndex };
+      uint32_t childFlattenIndices[2];
+
+      for (uint32_t i = 0; i < 2; i++) {
+        childFlattenIndices[i] = static_cast<uint32_t>(flattenNodes.size() + 1);
+        flattenIndices[childPoolIndices[i] - 1] = childFlattenIndices[i];
+
+        flattenNodes.emplace_back(this->nodes[childPoolIndices[i] - 1]);
+        flattenNodes.back().index = childFlattenIndices[i];
+      }
+
+      // emplace_back may have moved the parent, so look it up again
+      BvhItemBuild &parent = flattenNodes[flattenIndices[poolIndex - 1] - 1];
+      parent.leftNodeIndex = childFlattenIndices[0];
+      parent.rightNodeIndex = childFlattenIndices[1];
+
+      nodeStack.push(childPoolIndices[0]);
+      nodeStack.push(childPoolIndices[1]);
+    }
+
+    return flattenNodes;
   }
 
-  bool boxXCompare(std::shared_ptr<BoundBox> a, std::shared_ptr<BoundBox> b) {
-    return boxCompare(a, b, 0);
+  float computeSahCost(const std::vector<BvhItemBuild> &nodes, float rootArea) {
+    float cost = 0.0f;
+
+    for (auto &&node : nodes) {
+      float relativeArea = rootArea > 0.0f ? node.box.surfaceArea() / rootArea : 1.0f;
+
+      if (node.leftNodeIndex == 0 && node.rightNodeIndex == 0) {
+        cost += relativeArea * intersectionCost * node.objectCount;
+      } else {
+        cost += relativeArea * traversalCost;
+      }
+    }
+
+    return cost;
   }
 
-  bool boxYCompare(std::shared_ptr<BoundBox> a, std::shared_ptr<BoundBox> b) {
-    return boxCompare(a, b, 1);
+  // Direct children of a binary node. Leaves have none and always stay a single child slot.
+  std::vector<WideBvhChild> findWideBvhChildren(const std::vector<BvhItemBuild> &nodes, uint32_t nodeIndex) {
+    const BvhItemBuild &node = nodes[nodeIndex - 1];
+    std::vector<WideBvhChild> children;
+
+    if (node.leftNodeIndex != 0 || node.rightNodeIndex != 0) {
+      children.emplace_back(WideBvhChild{ nodes[node.leftNodeIndex - 1].box, node.leftNodeIndex });
+      children.emplace_back(WideBvhChild{ nodes[node.rightNodeIndex - 1].box, node.rightNodeIndex });
+    }
+
+    return children;
   }
 
-  bool boxZCompare(std::shared_ptr<BoundBox> a, std::shared_ptr<BoundBox> b) {
-    return boxCompare(a, b, 2);
+  // Decodes one quantized bound exactly like wideBvhChildBound in the shaders. The product is exact, so the float 
+  // addition is the only rounding, and a fused multiply add gives the same result.
+  float decodeWideBvhBound(float origin, uint32_t quantized, float step) {
+    return origin + static_cast<float>(quantized) * step;
   }
 
-  uint32_t findPrimitiveSplitIndex(BvhItemBuild node, int axis, float length) {
-    float costArr[splitNumber]{};
+  // Child boxes are stored as 8 bit offsets from the parent minimum in steps of a power of two. They are rounded outwards, 
+  // and then widened further wherever the float decode would round back into the child box.
+  WideBvhNode quantizeWideBvhNode(const Aabb &box, const std::vector<WideBvhChild> &children) {
+    WideBvhNode node{};
+    node.origin = box.min;
+    node.childCount = static_cast<uint32_t>(children.size());
 
-    for (int i = 0; i < splitNumber; i++) {
-      int totalLeft = 0, totalRight = 0;
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      float extent = box.max[axis] - box.min[axis];
+      int exponent = extent > 0.0f ? static_cast<int>(std::ceil(std::log2(extent / quantizationSteps))) : -126;
 
-      float leftLength = length * (i + 1) / (splitNumber + 1);
-      float posBarrier = leftLength + node.box.min[axis];
+      // The last step has to reach the parent maximum as decoded, so every child maximum can reach it too
+      while (exponent < 126 && decodeWideBvhBound(box.min[axis], quantizationSteps, std::ldexp(1.0f, exponent)) < box.max[axis]) {
+        exponent++;
+      }
 
-      for (auto &&item : node.objects) {
-        Aabb curBox = item->boundingBox();
-        float pos = (curBox.max[axis] - curBox.min[axis]) / 2.0f + curBox.min[axis];
+      exponent = std::clamp(exponent, -126, 126);
+      node.exponents |= static_cast<uint32_t>(exponent + 127) << (8 * axis);
 
-        if (pos < posBarrier) {
-          totalLeft++;
-        } else {
-          totalRight++;
+      double step = std::ldexp(1.0, exponent);
+      float floatStep = std::ldexp(1.0f, exponent);
+
+      for (uint32_t i = 0; i < children.size(); i++) {
+        double minimum = std::floor((children[i].box.min[axis] - box.min[axis]) / step);
+        double maximum = std::ceil((children[i].box.max[axis] - box.min[axis]) / step);
+
+        uint32_t quantizedMinimum = static_cast<uint32_t>(std::clamp(minimum, 0.0, static_cast<double>(quantizationSteps)));
+        uint32_t quantizedMaximum = static_cast<uint32_t>(std::clamp(maximum, 0.0, static_cast<double>(quantizationSteps)));
+
+        while (quantizedMinimum > 0 && decodeWideBvhBound(node.origin[axis], quantizedMinimum, floatStep) > children[i].box.min[axis]) {
+          quantizedMinimum--;
         }
-      }
 
-      float probLeft = leftLength / length;
-      float probRight = (length - leftLength) / length;
+        while (quantizedMaximum < quantizationSteps && decodeWideBvhBound(node.origin[axis], quantizedMaximum, floatStep) < children[i].box.max[axis]) {
+          quantizedMaximum++;
+        }
+
+        // A child the traversal could miss is a broken tree, not a slower one
+        if (decodeWideBvhBound(node.origin[axis], quantizedMinimum, floatStep) > children[i].box.min[axis] ||
+          decodeWideBvhBound(node.origin[axis], quantizedMaximum, floatStep) < children[i].box.max[axis]) 
+        {
+          throw std::runtime_error("quantized wide bvh node does not contain its child bounds");
+        }
 
-      costArr[i] = 0.5f + probLeft * totalLeft * 1.0f + probRight * totalRight * 1.0f;
+        node.quantizedMinimum[axis] |= quantizedMinimum << (8 * i);
+        node.quantizedMaximum[axis] |= quantizedMaximum << (8 * i);
+      }
     }
 
-    return static_cast<uint32_t>(std::distance(costArr, std::min_element(costArr, costArr + splitNumber)));
+    return node;
   }
 
-  // Since GPU can't deal with tree structures we need to create a flattened BVH.
-  // Stack is used instead of a tree.
-  std::shared_ptr<std::vector<BvhNode>> createBvh(const std::vector<std::shared_ptr<BoundBox>> boundedBoxes) {
-    uint32_t nodeCounter = 1;
-    std::vector<BvhItemBuild> intermediate;
-    std::stack<BvhItemBuild> nodeStack;
-
-    BvhItemBuild root;
-    root.index = nodeCounter;
-    root.objects = boundedBoxes;
+  // Collapse the binary tree top down. Every wide node starts from the children of one binary node and keeps
+  // opening the child with the largest surface area while the result still fits in wideBvhWidth slots.
+  std::vector<WideBvhNode> collapseBvh(const std::vector<BvhItemBuild> &nodes) {
+    std::vector<WideBvhNode> wideNodes;
+    if (nodes.empty()) {
+      return wideNodes;
+    }
 
-    nodeCounter++;
-    nodeStack.push(root);
+    std::stack<std::pair<uint32_t, uint32_t>> nodeStack; // binary node index, wide node index
+    nodeStack.push({ 1, 1 });
+    wideNodes.emplace_back();
 
     while (!nodeStack.empty()) {
-      BvhItemBuild currentNode = nodeStack.top();
+      auto [nodeIndex, wideIndex] = nodeStack.top();
       nodeStack.pop();
 
-      currentNode.box = objectListBoundingBox(currentNode.objects);
+      // A leaf root still gets a node of its own, with the leaf as its only child
+      std::vector<WideBvhChild> children = findWideBvhChildren(nodes, nodeIndex);
+      if (children.empty()) {
+        children.emplace_back(WideBvhChild{ nodes[nodeIndex - 1].box, nodeIndex });
+      }
 
-      int axis = currentNode.box.longestAxis();
-      auto comparator = (axis == 0) ? boxXCompare
-                      : (axis == 1) ? boxYCompare
-                      : boxZCompare;
+      while (true) {
+        int openIndex = -1;
+        float openArea = -1.0f;
+        std::vector<WideBvhChild> openChildren;
 
-      size_t objectSpan = currentNode.objects.size();
-      std::sort(currentNode.objects.begin(), currentNode.objects.end(), comparator);
+        for (uint32_t i = 0; i < children.size(); i++) {
+          if (children[i].box.surfaceArea() <= openArea) {
+            continue;
+          }
 
-      if (objectSpan <= 2) {
-        intermediate.push_back(currentNode);
-        continue;
-      } else {
-        float length = currentNode.box.max[axis] - currentNode.box.min[axis];
-        int mid = findPrimitiveSplitIndex(currentNode, axis, length); //  std::ceil(objectSpan / 2);
+          std::vector<WideBvhChild> grandChildren = findWideBvhChildren(nodes, children[i].nodeIndex);
+          if (!grandChildren.empty() && children.size() - 1 + grandChildren.size() <= wideBvhWidth) {
+            openIndex = static_cast<int>(i);
+            openArea = children[i].box.surfaceArea();
+            openChildren = grandChildren;
+          }
+        }
+
+        if (openIndex < 0) {
+          break;
+        }
+
+        children.erase(children.begin() + openIndex);
+        children.insert(children.begin() + openIndex, openChildren.begin(), openChildren.end());
+      }
+
+      WideBvhNode wideNode = quantizeWideBvhNode(nodes[nodeIndex - 1].box, children);
+
+      for (uint32_t i = 0; i < children.size(); i++) {
+        const BvhItemBuild &child = nodes[children[i].nodeIndex - 1];
+
+        if (child.leftNodeIndex == 0 && child.rightNodeIndex == 0) {
+          wideNode.children[i] = wideBvhLeafFlag | child.firstObject;
+          wideNode.leafCounts |= child.objectCount << (8 * i);
+          continue;
+        }
+
+        wideNodes.emplace_back();
+        wideNode.children[i] = static_cast<uint32_t>(wideNodes.size());
+        nodeStack.push({ children[i].nodeIndex, wideNode.children[i] });
+      }
+
+      wideNodes[wideIndex - 1] = wideNode;
+    }
+
+    return wideNodes;
+  }
+
+  // Recompute every node from new object bounds (given in leaf order) while keeping the topology. Wide nodes
+  // are numbered parents first, so walking them backwards visits all children before their parent.
+  BvhRefitResult refitWideBvh(std::vector<WideBvhNode> &nodes, const BvhBuildInput &input) {
+    BvhRefitResult result{};
+    std::vector<Aabb> nodeBoxes(nodes.size());
 
-        float posBarrier = length * (mid + 1) / (splitNumber + 1) + currentNode.box.min[axis];
-        BvhItemBuild leftNode, rightNode;
+    float traversalArea = 0.0f;
+    float intersectionArea = 0.0f;
 
-        for (auto &&item : currentNode.objects) {
-          Aabb curBox = item->boundingBox();
-          float pos = (curBox.max[axis] - curBox.min[axis]) / 2 + curBox.min[axis];
+    for (size_t nodeIndex = nodes.size(); nodeIndex > 0; nodeIndex--) {
+      WideBvhNode &node = nodes[nodeIndex - 1];
 
-          if (pos < posBarrier) {
-            leftNode.objects.push_back(item);
-          } else {
-            rightNode.objects.push_back(item);
+      Aabb box{};
+      std::vector<WideBvhChild> children(node.childCount);
+
+      for (uint32_t i = 0; i < node.childCount; i++) {
+        uint32_t child = node.children[i];
+
+        if ((child & wideBvhLeafFlag) != 0) {
+          uint32_t firstObject = child & ~wideBvhLeafFlag;
+          uint32_t objectCount = (node.leafCounts >> (8 * i)) & 0xFF;
+
+          for (uint32_t j = firstObject; j < firstObject + objectCount; j++) {
+            children[i].box.grow(Aabb{ input.minimums[j], input.maximums[j] });
           }
+
+          intersectionArea += children[i].box.surfaceArea() * objectCount;
+        } else {
+          children[i].box = nodeBoxes[child - 1];
         }
 
-        if (leftNode.objects.size() == 0 || rightNode.objects.size() == 0) {
-					mid = static_cast<int>(std::ceil(objectSpan / 2));
+        box.grow(children[i].box);
+      }
+
+      nodeBoxes[nodeIndex - 1] = box;
+      traversalArea += box.surfaceArea();
+
+      WideBvhNode refitNode = quantizeWideBvhNode(box, children);
+      refitNode.children = node.children;
+      refitNode.leafCounts = node.leafCounts;
 
-					leftNode.objects.clear();
-					rightNode.objects.clear();
+      if (std::memcmp(&refitNode, &node, sizeof(WideBvhNode)) != 0) {
+        node = refitNode;
+        result.dirtyNodes.emplace_back(static_cast<uint32_t>(nodeIndex));
+      }
+    }
+
+    if (!nodes.empty()) {
+      float rootArea = nodeBoxes[0].surfaceArea();
+      result.sahCost = rootArea > 0.0f ? (traversalCost * traversalArea + intersectionCost * intersectionArea) / rootArea : 0.0f;
+    }
+
+    // Report the nodes in buffer order, so neighbouring nodes can share one copy
+    std::reverse(result.dirtyNodes.begin(), result.dirtyNodes.end());
+    return result;
+  }
+
+  void BvhBuildInput::reserve(size_t size) {
+    this->minimums.reserve(size);
+    this->maximums.reserve(size);
+    this->centroids.reserve(size);
+    this->indices.reserve(size);
+  }
 
-					for (int i = 0; i < mid; i++) {
-						leftNode.objects.push_back(currentNode.objects[i]);
-					}
+  void BvhBuildInput::add(const glm::vec3 &minimum, const glm::vec3 &maximum, uint32_t index) {
+    this->minimums.emplace_back(minimum);
+    this->maximums.emplace_back(maximum);
+    this->centroids.emplace_back((minimum + maximum) * 0.5f);
+    this->indices.emplace_back(index);
+  }
+
+  Aabb findPrimitiveListBoundingBox(const std::vector<Primitive> &primitives, const std::vector<Vertex> &vertices) {
+    Aabb box{};
+
+    for (auto &&primitive : primitives) {
+      box.grow(glm::vec3(vertices[primitive.indices.x].position));
+      box.grow(glm::vec3(vertices[primitive.indices.y].position));
+      box.grow(glm::vec3(vertices[primitive.indices.z].position));
+    }
 
-					for (int i = mid; i < objectSpan; i++) {
-						rightNode.objects.push_back(currentNode.objects[i]);
-					}
-        }        
+    return box;
+  }
 
-        leftNode.index = nodeCounter;
-        nodeCounter++;
-        nodeStack.push(leftNode);
+  Aabb transformBoundingBox(const Aabb &box, const glm::mat4 &matrix) {
+    Aabb transformedBox{};
 
-        rightNode.index = nodeCounter;
-        nodeCounter++;
-        nodeStack.push(rightNode);
+    for (int i = 0; i < 2; i++) {
+      for (int j = 0; j < 2; j++) {
+        for (int k = 0; k < 2; k++) {
+          auto x = i * box.max.x + (1 - i) * box.min.x;
+          auto y = j * box.max.y + (1 - j) * box.min.y;
+          auto z = k * box.max.z + (1 - k) * box.min.z;
 
-        currentNode.leftNodeIndex = leftNode.index;
-        currentNode.rightNodeIndex = rightNode.index;
-        intermediate.push_back(currentNode);
+          transformedBox.grow(glm::vec3(matrix * glm::vec4(x, y, z, 1.0f)));
+        }
       }
     }
 
-    std::sort(intermediate.begin(), intermediate.end(), nodeCompare);
+    return transformedBox;
+  }
+
+  BvhBuildInput createPrimitiveBuildInput(const std::vector<Primitive> &primitives, const std::vector<Vertex> &vertices) {
+    BvhBuildInput input{};
+    input.reserve(primitives.size());
+
+    for (uint32_t i = 0; i < primitives.size(); i++) {
+      glm::vec3 point0 = vertices[primitives[i].indices.x].position;
+      glm::vec3 point1 = vertices[primitives[i].indices.y].position;
+      glm::vec3 point2 = vertices[primitives[i].indices.z].position;
+
+      input.add(glm::min(glm::min(point0, point1), point2) - eps, glm::max(glm::max(point0, point1), point2) + eps, i + 1);
+    }
+
+    return input;
+  }
+
+  // The object matrix is built once per object here instead of once per bounding box query
+  BvhBuildInput createObjectBuildInput(const std::vector<Object> &objects, const std::vector<std::shared_ptr<TransformComponent>> &transforms) {
+    BvhBuildInput input{};
+    input.reserve(objects.size());
+
+    for (uint32_t i = 0; i < objects.size(); i++) {
+      auto transform = transforms[objects[i].transformIndex];
+      Aabb box = transformBoundingBox(Aabb{ transform->objectMinimum, transform->objectMaximum }, transform->getPointMatrix());
+
+      input.add(box.min - eps, box.max + eps, i + 1);
+    }
+
+    return input;
+  }
+
+  BvhBuildInput createAreaLightBuildInput(const std::vector<AreaLight> &areaLights) {
+    BvhBuildInput input{};
+    input.reserve(areaLights.size());
+
+    for (uint32_t i = 0; i < areaLights.size(); i++) {
+      input.add(
+        glm::min(glm::min(areaLights[i].point0, areaLights[i].point1), areaLights[i].point2) - eps,
+        glm::max(glm::max(areaLights[i].point0, areaLights[i].point1), areaLights[i].point2) + eps,
+        i + 1
+      );
+    }
+
+    return input;
+  }
+
+  // Since GPU can't deal with tree structures the tree is flattened into an array, where inner nodes refer to 
+  // their children by index.
+  std::vector<BvhItemBuild> buildBvhItems(const BvhBuildInput &input, uint32_t maxLeafSize, std::vector<uint32_t> &objectOrder, BvhBuildReport *report, 
+    TaskPool *taskPool) 
+  {
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    if (input.size() == 0) {
+      return {};
+    }
+
+    // The builder partitions one contiguous array in place, so the input arrays are interleaved once here
+    std::vector<BvhBuildObject> objects(input.size());
+    for (size_t i = 0; i < input.size(); i++) {
+      objects[i] = BvhBuildObject{ Aabb{ input.minimums[i], input.maximums[i] }, input.centroids[i], input.indices[i] };
+    }
+
+    // Small inputs are not worth the hand-off to other threads
+    if (objects.size() < parallelTaskObjects) {
+      taskPool = nullptr;
+    }
+
+    BvhBuilder builder{objects, maxLeafSize, taskPool};
+    std::vector<BvhItemBuild> intermediate = builder.build();
+
+    // The builder leaves the objects sorted so that every leaf covers a contiguous range
+    objectOrder.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+      objectOrder[i] = objects[i].index;
+    }
+
+    if (report != nullptr) {
+      auto endTime = std::chrono::high_resolution_clock::now();
+
+      report->buildTime = std::chrono::duration<double, std::chrono::milliseconds::period>(endTime - startTime).count();
+      report->sahCost = computeSahCost(intermediate, intermediate[0].box.surfaceArea());
+      report->nodeCount = static_cast<uint32_t>(intermediate.size());
+      report->leafCount = (report->nodeCount + 1) / 2; // every inner node has exactly two children
+      report->maxDepth = builder.getMaxDepth();
+      report->leafSizeHistogram = builder.getLeafSizeHistogram();
+    }
+
+    return intermediate;
+  }
+
+  // Number of inner wide nodes on the longest path from the root
+  static uint32_t findWideBvhDepth(const std::vector<WideBvhNode> &nodes) {
+    if (nodes.empty()) {
+      return 0;
+    }
+
+    uint32_t maxDepth = 0;
+    std::stack<std::pair<uint32_t, uint32_t>> nodeStack; // wide node index, depth
+    nodeStack.push({ 1, 1 });
+
+    while (!nodeStack.empty()) {
+      auto [nodeIndex, depth] = nodeStack.top();
+      nodeStack.pop();
+
+      maxDepth = std::max(maxDepth, depth);
+
+      const WideBvhNode &node = nodes[nodeIndex - 1];
+      for (uint32_t i = 0; i < node.childCount; i++) {
+        if ((node.children[i] & wideBvhLeafFlag) == 0) {
+          nodeStack.push({ node.children[i], depth + 1 });
+        }
+      }
+    }
+
+    return maxDepth;
+  }
+
+  std::shared_ptr<std::vector<BvhNode>> createBvh(const BvhBuildInput &input, BvhBuildReport *report, TaskPool *taskPool) {
     auto output = std::make_shared<std::vector<BvhNode>>();
 
-    for (int i = 0; i < intermediate.size(); i++) {
-      output->emplace_back(intermediate[i].getGpuModel());
+    // The depth is needed for the stack check below even if the caller does not want a report
+    BvhBuildReport localReport{};
+    if (report == nullptr) {
+      report = &localReport;
+    }
+
+    std::vector<uint32_t> objectOrder;
+    std::vector<BvhItemBuild> intermediate = buildBvhItems(input, maxLeafObjects, objectOrder, report, taskPool);
+
+    // Every visited node leaves at most its sibling on the stack, one per level below the root
+    if (report->maxDepth + 1 > bvhStackSize) {
+      throw std::runtime_error("bvh is too deep for the traversal stack of the shaders");
+    }
+
+    output->reserve(intermediate.size());
+    for (auto &&node : intermediate) {
+      output->emplace_back(node.getGpuModel());
+    }
+
+    return output;
+  }
+
+  std::shared_ptr<std::vector<WideBvhNode>> createWideBvh(const BvhBuildInput &input, std::vector<uint32_t> &objectOrder, BvhBuildReport *report, 
+    TaskPool *taskPool) 
+  {
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<BvhItemBuild> intermediate = buildBvhItems(input, maxWideLeafObjects, objectOrder, report, taskPool);
+    auto output = std::make_shared<std::vector<WideBvhNode>>(collapseBvh(intermediate));
+
+    // Every visited node leaves at most wideBvhWidth - 1 siblings on the stack, one set per level
+    if ((wideBvhWidth - 1) * findWideBvhDepth(*output) + 1 > bvhStackSize) {
+      throw std::runtime_error("wide bvh is too deep for the traversal stack of the shaders");
+    }
+
+    if (report != nullptr) {
+      auto endTime = std::chrono::high_resolution_clock::now();
+
+      report->buildTime = std::chrono::duration<double, std::chrono::milliseconds::period>(endTime - startTime).count();
+      report->wideNodeCount = static_cast<uint32_t>(output->size());
     }
 
     return output;
   }
-}
\ No newline at end of file
+}
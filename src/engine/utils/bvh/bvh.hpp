@@ -7,106 +7,203 @@
 
 #include "../sort/sort.hpp"
 #include "../transform/transform.hpp"
+#include "../task_pool/task_pool.hpp"
 #include "../../general_struct.hpp"
 
 #include <vector>
 #include <memory>
 #include <algorithm>
 #include <stack>
+#include <string>
+#include <atomic>
+#include <mutex>
 
 namespace nugiEngine {
   const glm::vec3 eps(0.1f);
-  const uint32_t splitNumber = 11;
+
+  // Binned SAH parameters. The binary GPU BvhNode can only reference two objects per leaf (leftObjIndex / rightObjIndex),
+  // wide Bvh leaves hold a contiguous range of up to maxWideLeafObjects objects
+  const uint32_t binNumber = 16;
+  const uint32_t maxLeafObjects = 2;
+  const uint32_t maxWideLeafObjects = 8;
+  const float traversalCost = 2.0f; // a node visit decodes and tests several child boxes, about two triangle tests
+  const float intersectionCost = 1.0f;
+
+  // Parallel build parameters. Ranges at least this big are built as separate tasks / binned in chunks
+  const uint32_t parallelTaskObjects = 4096;
+  const uint32_t parallelBinObjects = 65536;
+  const uint32_t binChunkObjects = 16384;
+
+  // Wide Bvh parameters. Binary nodes are collapsed into WideBvhNode with up to wideBvhWidth children
+  const uint32_t wideBvhWidth = 4;
+  const uint32_t wideBvhLeafFlag = 0x80000000u;
+  const uint32_t quantizationSteps = 255;
+
+  // Entries of the fixed traversal stacks in the shaders (BVH_STACK_SIZE in struct.glsl). 
+  // The builders throw on a tree whose traversal could overflow them
+  const uint32_t bvhStackSize = 64;
+
+  // A refitted tree should be rebuilt once its SAH cost grows past this ratio of the cost it was built with
+  const float rebuildSahRatio = 1.5f;
 
   // Axis-aligned bounding box.
   struct Aabb {
     glm::vec3 min = glm::vec3{FLT_MAX};
-    glm::vec3 max = glm::vec3{FLT_MIN};
+    glm::vec3 max = glm::vec3{-FLT_MAX};
 
     uint32_t longestAxis();
     uint32_t randomAxis();
-  };
 
-  // Utility structure to keep track of the initial triangle index in the triangles array while sorting.
-  struct BoundBox {
-    uint32_t index;
+    float surfaceArea() const;
+    void grow(const Aabb &other);
+    void grow(const glm::vec3 &point);
+  };
 
-    BoundBox(uint32_t i) : index{i} {}
+  // Structure-of-arrays builder input: one entry per object in every array. The index is the (1-based) 
+  // value written into the leaves. Filled straight from the scene arrays, without allocating per object.
+  struct BvhBuildInput {
+    std::vector<glm::vec3> minimums;
+    std::vector<glm::vec3> maximums;
+    std::vector<glm::vec3> centroids;
+    std::vector<uint32_t> indices;
 
-    virtual Aabb boundingBox() = 0;
+    size_t size() const { return this->indices.size(); }
 
-    virtual glm::vec3 getOriginalMin() { return glm::vec3(0.0f); }
-    virtual glm::vec3 getOriginalMax() { return glm::vec3(0.0f); }
+    void reserve(size_t size);
+    void add(const glm::vec3 &minimum, const glm::vec3 &maximum, uint32_t index);
   };
 
-  struct PrimitiveBoundBox : BoundBox {
-    Primitive &primitive;
-    std::shared_ptr<std::vector<Vertex>> vertices;
+  // Bounding box and centroid of a single object, computed once before the build starts.
+  struct BvhBuildObject {
+    Aabb box;
+    glm::vec3 centroid;
+    uint32_t index;
+  };
 
-    PrimitiveBoundBox(uint32_t i, Primitive &p, std::shared_ptr<std::vector<Vertex>> v) : BoundBox(i), primitive{p}, vertices{v} {}
+  // Intermediate BvhNode structure needed for constructing Bvh.
+  struct BvhItemBuild {
+    Aabb box;
+    uint32_t index = 0; // index refers to the index in the final array of nodes.
+    uint32_t leftNodeIndex = 0;
+    uint32_t rightNodeIndex = 0;
+    uint32_t leftObjIndex = 0;
+    uint32_t rightObjIndex = 0;
+    uint32_t firstObject = 0; // leaf range in the reordered object list
+    uint32_t objectCount = 0;
 
-    Aabb boundingBox();
+    BvhNode getGpuModel();
   };
 
-  struct ObjectBoundBox : BoundBox {
-    Object &object;
-    std::shared_ptr<TransformComponent> transformation;
-    std::shared_ptr<std::vector<Primitive>> primitives;
-    std::shared_ptr<std::vector<Vertex>> vertices;
-
-    glm::vec3 originalMin{};
-    glm::vec3 originalMax{};
+  // Object range still waiting to be split, together with the node it belongs to.
+  struct BvhBuildTask {
+    uint32_t nodeIndex;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t depth;
+  };
 
-    ObjectBoundBox(uint32_t i, Object &o, std::shared_ptr<std::vector<Primitive>> p, std::shared_ptr<TransformComponent> t, std::shared_ptr<std::vector<Vertex>> v);
+  struct BvhSplit {
+    uint32_t axis = 0;
+    uint32_t bin = 0;
+    float cost = FLT_MAX;
+  };
 
-    glm::vec3 getOriginalMin() { return this->originalMin; }
-    glm::vec3 getOriginalMax() { return this->originalMax; }
-    
-    Aabb boundingBox();
+  // Centroid bins of all three axes for one node.
+  struct BvhBins {
+    Aabb boxes[3][binNumber];
+    uint32_t counts[3][binNumber]{};
 
-    private:
-      float findMax(uint32_t index);
-      float findMin(uint32_t index);
+    void merge(const BvhBins &other);
   };
 
-  struct PointLightBoundBox : BoundBox {
-    PointLight &light;
+  // Build time and tree quality of a Bvh. The SAH cost is relative to the root surface area.
+  struct BvhBuildReport {
+    double buildTime = 0.0; // in milliseconds
+    float sahCost = 0.0f;
+    uint32_t nodeCount = 0;
+    uint32_t leafCount = 0;
+    uint32_t maxDepth = 0;
+    std::vector<uint32_t> leafSizeHistogram; // leafSizeHistogram[n] is the number of leaves holding n objects
+    uint32_t wideNodeCount = 0;
+
+    void append(const BvhBuildReport &other);
+    void print(const std::string &name) const;
+  };
 
-    PointLightBoundBox(int i, PointLight &l) : BoundBox(i), light{l} {}
+  // Outcome of a refit: the SAH cost of the refitted tree and the (1-based) nodes whose data changed.
+  struct BvhRefitResult {
+    float sahCost = 0.0f;
+    std::vector<uint32_t> dirtyNodes;
+  };
 
-    Aabb boundingBox();
+  // One child slot of a wide node while collapsing.
+  struct WideBvhChild {
+    Aabb box;
+    uint32_t nodeIndex = 0; // 1-based index of the binary node
   };
 
-  struct AreaLightBoundBox : BoundBox {
-    AreaLight &light;
+  // Builds the tree on a work-stealing task pool (or on the calling thread when there is none).
+  // Nodes are allocated from a shared pool in whatever order the threads reach them and renumbered
+  // depth first afterwards, so the flattened output is the same on every run and thread count.
+  class BvhBuilder {
+    public:
+      BvhBuilder(std::vector<BvhBuildObject> &objects, uint32_t maxLeafSize = maxLeafObjects, TaskPool *taskPool = nullptr);
 
-    AreaLightBoundBox(int i, AreaLight &l) : BoundBox(i), light{l} {}
+      BvhBuilder(const BvhBuilder&) = delete;
+      BvhBuilder& operator = (const BvhBuilder&) = delete;
 
-    Aabb boundingBox();
-  };
+      std::vector<BvhItemBuild> build();
 
-  // Intermediate BvhNode structure needed for constructing Bvh.
-  struct BvhItemBuild {
-    Aabb box;
-    uint32_t index = 0; // index refers to the index in the final array of nodes. Used for sorting a flattened Bvh.
-    uint32_t leftNodeIndex = 0;
-    uint32_t rightNodeIndex = 0;
-    std::vector<std::shared_ptr<BoundBox>> objects;
+      uint32_t getMaxDepth() const { return this->maxDepth; }
+      std::vector<uint32_t> getLeafSizeHistogram() const { return this->leafSizeHistogram; }
 
-    BvhNode getGpuModel();
+    private:
+      std::vector<BvhBuildObject> &objects;
+      std::vector<BvhItemBuild> nodes;
+      std::atomic<uint32_t> nodeCount{0};
+      uint32_t maxLeafSize;
+
+      TaskPool *taskPool;
+      TaskGroup taskGroup;
+
+      std::mutex statisticMutex;
+      uint32_t maxDepth = 0;
+      std::vector<uint32_t> leafSizeHistogram;
+
+      void buildSubtree(BvhBuildTask task);
+      void computeBounds(uint32_t begin, uint32_t end, Aabb &box, Aabb &centroidBox);
+      BvhBins computeBins(uint32_t begin, uint32_t end, const Aabb &centroidBox);
+      std::vector<BvhItemBuild> flatten();
   };
 
-  bool nodeCompare(BvhItemBuild &a, BvhItemBuild &b);
   Aabb surroundingBox(Aabb box0, Aabb box1);
-  Aabb objectListBoundingBox(std::vector<std::shared_ptr<BoundBox>> &objects);
-  bool boxCompare(std::shared_ptr<BoundBox> a, std::shared_ptr<BoundBox> b, uint32_t axis);
-  bool boxXCompare(std::shared_ptr<BoundBox> a, std::shared_ptr<BoundBox> b);
-  bool boxYCompare(std::shared_ptr<BoundBox> a, std::shared_ptr<BoundBox> b);
-  bool boxZCompare(std::shared_ptr<BoundBox> a, std::shared_ptr<BoundBox> b);
-  uint32_t findPrimitiveSplitIndex(BvhItemBuild node, uint32_t axis, float length);
-
-  // Since GPU can't deal with tree structures we need to create a flattened BVH.
-  // Stack is used instead of a tree.
-  std::shared_ptr<std::vector<BvhNode>> createBvh(const std::vector<std::shared_ptr<BoundBox>> boundedBoxes);
+  uint32_t findBinIndex(const glm::vec3 &centroid, uint32_t axis, const Aabb &centroidBox);
+  void fillBins(const std::vector<BvhBuildObject> &objects, uint32_t begin, uint32_t end, const Aabb &centroidBox, BvhBins &bins);
+  BvhSplit findBinnedSahSplit(const BvhBins &bins, const Aabb &box);
+  float computeSahCost(const std::vector<BvhItemBuild> &nodes, float rootArea);
+
+  std::vector<WideBvhChild> findWideBvhChildren(const std::vector<BvhItemBuild> &nodes, uint32_t nodeIndex);
+  float decodeWideBvhBound(float origin, uint32_t quantized, float step);
+  WideBvhNode quantizeWideBvhNode(const Aabb &box, const std::vector<WideBvhChild> &children);
+  std::vector<WideBvhNode> collapseBvh(const std::vector<BvhItemBuild> &nodes);
+  BvhRefitResult refitWideBvh(std::vector<WideBvhNode> &nodes, const BvhBuildInput &input);
+
+  Aabb findPrimitiveListBoundingBox(const std::vector<Primitive> &primitives, const std::vector<Vertex> &vertices);
+  Aabb transformBoundingBox(const Aabb &box, const glm::mat4 &matrix);
+
+  BvhBuildInput createPrimitiveBuildInput(const std::vector<Primitive> &primitives, const std::vector<Vertex> &vertices);
+  BvhBuildInput createObjectBuildInput(const std::vector<Object> &objects, const std::vector<std::shared_ptr<TransformComponent>> &transforms);
+  BvhBuildInput createAreaLightBuildInput(const std::vector<AreaLight> &areaLights);
+
+  // Since GPU can't deal with tree structures the tree is flattened into an array, where inner nodes refer to 
+  // their children by index. Without a task pool, or for small inputs, the whole build runs on the calling thread.
+  std::vector<BvhItemBuild> buildBvhItems(const BvhBuildInput &input, uint32_t maxLeafSize, std::vector<uint32_t> &objectOrder, BvhBuildReport *report = nullptr, 
+    TaskPool *taskPool = nullptr);
+  std::shared_ptr<std::vector<BvhNode>> createBvh(const BvhBuildInput &input, BvhBuildReport *report = nullptr, TaskPool *taskPool = nullptr);
+
+  // Binary build followed by the collapse into 4-wide nodes with quantised child boxes. Leaves point at a range
+  // of objectOrder, which lists the (1-based) input indices in leaf order. Callers reorder their objects by it.
+  std::shared_ptr<std::vector<WideBvhNode>> createWideBvh(const BvhBuildInput &input, std::vector<uint32_t> &objectOrder, BvhBuildReport *report = nullptr, 
+    TaskPool *taskPool = nullptr);
 
 }// namespace nugiEngine 
@@ -0,0 +1,62 @@
+#include "image_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace nugiEngine {
+  static uint8_t encodeSrgb(float value) {
+    value = std::clamp(value, 0.0f, 1.0f);
+    value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+
+    return static_cast<uint8_t>(value * 255.0f + 0.5f);
+  }
+
+  static void writePfm(std::ofstream &file, const std::vector<glm::vec4> &pixels, uint32_t width, uint32_t height) {
+    // Negative scale marks little endian data, rows are stored from the bottom
+    file << "PF\n" << width << " " << height << "\n-1.0\n";
+
+    for (uint32_t y = height; y > 0; y--) {
+      for (uint32_t x = 0; x < width; x++) {
+        const glm::vec4 &pixel = pixels[(y - 1) * width + x];
+        file.write(reinterpret_cast<const char*>(&pixel), 3 * sizeof(float));
+      }
+    }
+  }
+
+  static void writePpm(std::ofstream &file, const std::vector<glm::vec4> &pixels, uint32_t width, uint32_t height) {
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    std::vector<uint8_t> row(width * 3);
+    for (uint32_t y = 0; y < height; y++) {
+      for (uint32_t x = 0; x < width; x++) {
+        const glm::vec4 &pixel = pixels[y * width + x];
+
+        row[x * 3 + 0] = encodeSrgb(pixel.r);
+        row[x * 3 + 1] = encodeSrgb(pixel.g);
+        row[x * 3 + 2] = encodeSrgb(pixel.b);
+      }
+
+      file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+  }
+
+  void writeImageFile(const std::string &filePath, const std::vector<glm::vec4> &pixels, uint32_t width, uint32_t height) {
+    if (pixels.size() < static_cast<size_t>(width) * height) {
+      throw std::runtime_error("not enough pixels to write " + filePath);
+    }
+
+    std::ofstream file{filePath, std::ios::binary};
+    if (!file.is_open()) {
+      throw std::runtime_error("failed to open file: " + filePath);
+    }
+
+    bool isPfm = filePath.size() >= 4 && filePath.compare(filePath.size() - 4, 4, ".pfm") == 0;
+    if (isPfm) {
+      writePfm(file, pixels, width, height);
+    } else {
+      writePpm(file, pixels, width, height);
+    }
+  }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+namespace nugiEngine {
+	// Writes linear RGB pixels, stored row by row from the top. A ".pfm" path keeps the raw floats,
+	// anything else is written as an sRGB encoded binary PPM.
+	void writeImageFile(const std::string &filePath, const std::vector<glm::vec4> &pixels, uint32_t width, uint32_t height);
+}
@@ -0,0 +1,162 @@
+#include "task_pool.hpp"
+
+#include <algorithm>
+
+namespace nugiEngine {
+  // Which pool and queue the current thread works for. Threads outside of the pool have no own queue.
+  static thread_local TaskPool *currentPool = nullptr;
+  static thread_local uint32_t currentQueueIndex = 0;
+
+  TaskPool::TaskPool(uint32_t threadCount) {
+    threadCount = std::max(threadCount, 1u);
+
+    for (uint32_t i = 0; i < threadCount; i++) {
+      this->queues.emplace_back(std::make_unique<WorkerQueue>());
+    }
+
+    for (uint32_t i = 0; i < threadCount; i++) {
+      this->workers.emplace_back(&TaskPool::workerLoop, this, i);
+    }
+  }
+
+  TaskPool::~TaskPool() {
+    {
+      std::lock_guard<std::mutex> lock(this->sleepMutex);
+      this->isRunning = false;
+    }
+
+    this->sleepCondition.notify_all();
+
+    for (auto &&worker : this->workers) {
+      worker.join();
+    }
+  }
+
+  uint32_t TaskPool::getCurrentQueueIndex() {
+    if (currentPool == this) {
+      return currentQueueIndex;
+    }
+
+    return this->nextQueueIndex.fetch_add(1) % static_cast<uint32_t>(this->queues.size());
+  }
+
+  void TaskPool::submit(TaskGroup &group, std::function<void()> task) {
+    group.pendingCount++;
+    uint32_t queueIndex = this->getCurrentQueueIndex();
+
+    // Counted before the push, so a thief can never take the task before it is counted
+    {
+      std::lock_guard<std::mutex> lock(this->queues[queueIndex]->mutex);
+      this->queuedCount++;
+
+      this->queues[queueIndex]->tasks.emplace_back([this, &group, task = std::move(task)]() {
+        task();
+
+        if (--group.pendingCount == 0) {
+          this->notifyWaiters();
+        }
+      });
+    }
+
+    // A worker checks queuedCount under sleepMutex before it sleeps, so taking the mutex here means 
+    // it is either asleep already and gets the notification, or sees the new task
+    {
+      std::lock_guard<std::mutex> lock(this->sleepMutex);
+    }
+
+    this->sleepCondition.notify_one();
+
+    // A waiting thread may help with the new task, and has to if it is the only worker
+    this->notifyWaiters();
+  }
+
+  // Waiters count themselves under sleepMutex before checking their condition, so taking it here 
+  // means no waiter can miss the change that was made just before
+  void TaskPool::notifyWaiters() {
+    if (this->waitingCount == 0) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->sleepMutex);
+    }
+
+    this->waitCondition.notify_all();
+  }
+
+  bool TaskPool::popTask(uint32_t queueIndex, std::function<void()> &task) {
+    uint32_t queueCount = static_cast<uint32_t>(this->queues.size());
+
+    {
+      std::lock_guard<std::mutex> lock(this->queues[queueIndex]->mutex);
+
+      if (!this->queues[queueIndex]->tasks.empty()) {
+        task = std::move(this->queues[queueIndex]->tasks.back());
+        this->queues[queueIndex]->tasks.pop_back();
+        this->queuedCount--;
+
+        return true;
+      }
+    }
+
+    for (uint32_t i = 1; i < queueCount; i++) {
+      uint32_t victimIndex = (queueIndex + i) % queueCount;
+      std::lock_guard<std::mutex> lock(this->queues[victimIndex]->mutex);
+
+      if (!this->queues[victimIndex]->tasks.empty()) {
+        task = std::move(this->queues[victimIndex]->tasks.front());
+        this->queues[victimIndex]->tasks.pop_front();
+        this->queuedCount--;
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void TaskPool::workerLoop(uint32_t queueIndex) {
+    currentPool = this;
+    currentQueueIndex = queueIndex;
+
+    std::function<void()> task;
+
+    while (true) {
+      if (this->popTask(queueIndex, task)) {
+        task();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(this->sleepMutex);
+      if (!this->isRunning) {
+        return;
+      }
+
+      this->sleepCondition.wait(lock, [this]() { 
+        return this->queuedCount > 0 || !this->isRunning; 
+      });
+    }
+  }
+
+  void TaskPool::wait(TaskGroup &group) {
+    uint32_t queueIndex = this->getCurrentQueueIndex();
+    std::function<void()> task;
+
+    while (group.pendingCount > 0) {
+      if (this->popTask(queueIndex, task)) {
+        task();
+        continue;
+      }
+
+      // The rest of the group is running on other threads
+      std::unique_lock<std::mutex> lock(this->sleepMutex);
+      this->waitingCount++;
+
+      this->waitCondition.wait(lock, [this, &group]() { 
+        return group.pendingCount == 0 || this->queuedCount > 0; 
+      });
+
+      this->waitingCount--;
+    }
+  }
+} // namespace nugiEngine
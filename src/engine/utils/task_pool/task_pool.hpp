@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nugiEngine {
+  // Counts the tasks of one parallel job that are still queued or running.
+  struct TaskGroup {
+    std::atomic<uint32_t> pendingCount{0};
+  };
+
+  // Work-stealing thread pool. Every worker owns a queue, pops its newest task first and steals the
+  // oldest task of another worker when its own queue runs dry. Tasks submitted from inside a worker go
+  // to that worker's queue, so recursive jobs (like building BVH subtrees) stay on the same thread until stolen.
+  class TaskPool {
+    public:
+      TaskPool(uint32_t threadCount = std::thread::hardware_concurrency());
+      ~TaskPool();
+
+      TaskPool(const TaskPool&) = delete;
+      TaskPool& operator = (const TaskPool&) = delete;
+
+      uint32_t getThreadCount() const { return static_cast<uint32_t>(this->workers.size()); }
+
+      void submit(TaskGroup &group, std::function<void()> task);
+
+      // Runs queued tasks on the calling thread until every task in the group has finished, 
+      // and sleeps whenever there is nothing left to help with
+      void wait(TaskGroup &group);
+
+    private:
+      struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+      };
+
+      std::vector<std::unique_ptr<WorkerQueue>> queues;
+      std::vector<std::thread> workers;
+
+      std::mutex sleepMutex;
+      std::condition_variable sleepCondition;
+      std::condition_variable waitCondition;
+      std::atomic<uint32_t> waitingCount{0};
+
+      std::atomic<uint32_t> queuedCount{0};
+      std::atomic<uint32_t> nextQueueIndex{0};
+      std::atomic<bool> isRunning{true};
+
+      void workerLoop(uint32_t queueIndex);
+      bool popTask(uint32_t queueIndex, std::function<void()> &task);
+      uint32_t getCurrentQueueIndex();
+      void notifyWaiters();
+  };
+} // namespace nugiEngine
@@ -0,0 +1,56 @@
+// ------------- Adaptive Sampling -------------
+
+#define ADAPTIVE_TILE_SIZE 8u
+
+// Keeps dark pixels from needing an absolute error they can never reach
+#define ADAPTIVE_MIN_LUMINANCE 0.01f
+
+// A tile always holds ADAPTIVE_TILE_SIZE x ADAPTIVE_TILE_SIZE traced pixels, one per invocation of a workgroup. 
+// The tiles at the right and bottom edge may reach past the image, their pixels out there are skipped.
+uvec2 tileSize() {
+  return ADAPTIVE_TILE_SIZE * traceScale();
+}
+
+uint tileCountX() {
+  return (imgSize.x + tileSize().x - 1u) / tileSize().x;
+}
+
+bool isInsideImage(uvec2 imgPosition) {
+  return imgPosition.x < imgSize.x && imgPosition.y < imgSize.y;
+}
+
+// A pixel is done once the standard error of its mean luminance falls below errorThreshold of that mean. 
+// Nothing is converged on the first sample of a new accumulation, right after the camera moved, while the statistics 
+// still predate either of those or with errorThreshold at zero.
+bool isPixelConverged(PixelStatistics statistics) {
+  if (ubo.randomSeed == 0u || ubo.isCameraMoved == 1u || ubo.isStatisticsStale == 1u || ubo.errorThreshold <= 0.0f || 
+    statistics.sampleCount < max(ubo.minSamples, 2u)) 
+  {
+    return false;
+  }
+
+  float variance = statistics.m2 / float(statistics.sampleCount - 1u);
+  float standardError = sqrt(variance / float(statistics.sampleCount));
+
+  return standardError <= ubo.errorThreshold * max(statistics.mean, ADAPTIVE_MIN_LUMINANCE);
+}
+
+// Tiled rendering only covers part of the image in every frame
+bool isTileInRange(uint tileIndex) {
+  return tileIndex >= ubo.firstTile && tileIndex - ubo.firstTile < ubo.tileCount;
+}
+
+bool isTileActive(uvec2 imgPosition) {
+  uvec2 tile = imgPosition / tileSize();
+  return tileMasks[tile.y * tileCountX() + tile.x] != 0u;
+}
+
+// First pixel of the cell of the current invocation when the dispatch runs one workgroup per active tile
+uvec2 activeTileCell() {
+  uint tileIndex = activeTiles[gl_WorkGroupID.x];
+  return uvec2(tileIndex % tileCountX(), tileIndex / tileCountX()) * tileSize() + gl_LocalInvocationID.xy * traceScale();
+}
+
+uvec2 activeTilePixel() {
+  return tracedPixel(activeTileCell());
+}
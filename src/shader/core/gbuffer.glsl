@@ -0,0 +1,96 @@
+// ------------- G-Buffer -------------
+
+// The forward pass writes a compact G-buffer or a visibility buffer, these read either one back. The position is not stored:
+// the primary hit distance along the camera ray through the pixel center is enough to find it again.
+vec3 primaryRayDirection(uvec2 imgPosition) {
+  vec2 ndc = (vec2(imgPosition) + 0.5f) / vec2(imgSize) * 2.0f - 1.0f;
+  vec4 nearPoint = ubo.inverseViewProjection * vec4(ndc, 0.0f, 1.0f);
+
+  return normalize(nearPoint.xyz / nearPoint.w - ubo.origin);
+}
+
+vec3 gBufferPosition(uvec2 imgPosition) {
+  return ubo.origin + primaryRayDirection(imgPosition) * primaryHitDistance(imgPosition);
+}
+
+// In visibility buffer mode only the primitive is known, its vertices and material are fetched here.
+// Like the forward pass, the material comes from the first vertex. Zero where nothing was drawn.
+uint visiblePrimitive(uvec2 imgPosition) {
+  return imageLoad(visibilityResource, ivec2(imgPosition)).x;
+}
+
+vec3 vertexNormal(uint index) {
+  return octahedralDecode(unpackSnorm2x16(vertexAttributes[index].normal));
+}
+
+uint vertexMaterialIndex(uint index) {
+  return vertexAttributes[index].indices & 0xFFFFu;
+}
+
+uint vertexTransformIndex(uint index) {
+  return vertexAttributes[index].indices >> 16;
+}
+
+// Barycentrics of the hit point on the primitive, in world space like the forward pass
+vec3 visibleBarycentrics(Primitive primitive, vec3 position) {
+  Transformation transformation = transformations[vertexTransformIndex(primitive.indices.x)];
+
+  vec3 point0 = (transformation.pointMatrix * vec4(vertexPosition(primitive.indices.x), 1.0f)).xyz;
+  vec3 edge1 = (transformation.pointMatrix * vec4(vertexPosition(primitive.indices.y), 1.0f)).xyz - point0;
+  vec3 edge2 = (transformation.pointMatrix * vec4(vertexPosition(primitive.indices.z), 1.0f)).xyz - point0;
+  vec3 offset = position - point0;
+
+  float dot11 = dot(edge1, edge1);
+  float dot12 = dot(edge1, edge2);
+  float dot22 = dot(edge2, edge2);
+  float denominator = max(dot11 * dot22 - dot12 * dot12, KEPSILON);
+
+  float v = (dot22 * dot(offset, edge1) - dot12 * dot(offset, edge2)) / denominator;
+  float w = (dot11 * dot(offset, edge2) - dot12 * dot(offset, edge1)) / denominator;
+
+  return vec3(1.0f - v - w, v, w);
+}
+
+vec3 gBufferNormal(uvec2 imgPosition) {
+  if (ubo.isVisibilityBuffer == 1u) {
+    uint primitiveId = visiblePrimitive(imgPosition);
+    if (primitiveId == 0u) {
+      return vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    Primitive primitive = primitives[primitiveId - 1u];
+    vec3 barycentrics = visibleBarycentrics(primitive, gBufferPosition(imgPosition));
+
+    vec3 normal = barycentrics.x * vertexNormal(primitive.indices.x) + barycentrics.y * vertexNormal(primitive.indices.y)
+      + barycentrics.z * vertexNormal(primitive.indices.z);
+
+    return normalize(mat3(transformations[vertexTransformIndex(primitive.indices.x)].normalMatrix) * normal);
+  }
+
+  return octahedralDecode(unpackSnorm2x16(imageLoad(normalResource, ivec2(imgPosition)).x));
+}
+
+// Base colors are kept in 0 - 255, like the materials they come from
+vec3 gBufferAlbedoColor(uvec2 imgPosition) {
+  if (ubo.isVisibilityBuffer == 1u) {
+    uint primitiveId = visiblePrimitive(imgPosition);
+    return primitiveId == 0u ? vec3(0.0f) : materials[vertexMaterialIndex(primitives[primitiveId - 1u].indices.x)].baseColor;
+  }
+
+  return imageLoad(albedoColorResource, ivec2(imgPosition)).xyz * 255.0f;
+}
+
+// Metallicness, roughness and fresnel reflectance
+vec3 gBufferMaterialParams(uvec2 imgPosition) {
+  if (ubo.isVisibilityBuffer == 1u) {
+    uint primitiveId = visiblePrimitive(imgPosition);
+    if (primitiveId == 0u) {
+      return vec3(0.0f);
+    }
+
+    Material material = materials[vertexMaterialIndex(primitives[primitiveId - 1u].indices.x)];
+    return vec3(material.metallicness, material.roughness, material.fresnelReflect);
+  }
+
+  return imageLoad(materialResource, ivec2(imgPosition)).xyz;
+}
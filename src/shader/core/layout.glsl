@@ -0,0 +1,115 @@
+// ------------- Ray Trace Layout -------------
+
+layout(set = 0, binding = 0, rgba32f) uniform image2D targetImage;
+
+layout(set = 0, binding = 1) uniform readonly RayTraceUbo {
+  vec3 origin;
+  vec3 background;
+  uint numLights;
+  uint randomSeed;
+  uint minBounce;
+  uint maxBounce;
+  uint seedOffset;
+  uint minSamples;
+  float errorThreshold;
+  uint firstTile;
+  uint tileCount;
+  uint traceMode;
+  mat4 inverseViewProjection;
+  mat4 previousViewProjection;
+  vec3 previousOrigin;
+  uint maxHistory;
+  uint isCameraMoved;
+  uint isVisibilityBuffer;
+  uint isStatisticsStale;
+} ubo;
+
+layout(set = 0, binding = 2) buffer readonly ObjectSsbo {
+  Object objects[];
+};
+
+layout(set = 0, binding = 3) buffer readonly ObjectBvhSsbo {
+  WideBvhNode objectBvhNodes[];
+};
+
+layout(set = 0, binding = 4) buffer readonly PrimitiveSsbo {
+  Primitive primitives[];
+};
+
+layout(set = 0, binding = 5) buffer readonly PrimitiveBvhSsbo {
+  WideBvhNode primitiveBvhNodes[];
+};
+
+layout(set = 0, binding = 6) buffer readonly VertexPositionSsbo {
+  VertexPosition vertexPositions[];
+};
+
+// Only needed for shading the primary hits of the visibility buffer
+layout(set = 0, binding = 20) buffer readonly VertexAttributeSsbo {
+  VertexAttribute vertexAttributes[];
+};
+
+// What the traversal reads instead of the primitives and their vertex positions
+layout(set = 0, binding = 21) buffer readonly TriangleSsbo {
+  Triangle triangles[];
+};
+
+layout(set = 0, binding = 7) buffer readonly MaterialSsbo {
+  Material materials[];
+};
+
+layout(set = 0, binding = 8) buffer readonly TransformationSsbo {
+  Transformation transformations[];
+};
+
+/* layout(set = 0, binding = 9) buffer readonly PointLightSsbo {
+  PointLight lights[];
+}; */
+
+layout(set = 0, binding = 9) buffer readonly AreaLightSsbo {
+  AreaLight lights[];
+};
+
+layout(set = 0, binding = 10) buffer readonly LightBvhSsbo {
+  BvhNode lightBvhNodes[];
+};
+
+// Compact G-buffer, see core/gbuffer.glsl: primary hit distance, texture coordinates as two halves, octahedral normal 
+// as two snorm16, albedo and material parameters as unorm8
+layout(set = 0, binding = 11, r32f) uniform readonly image2D positionResource;
+layout(set = 0, binding = 12, r32ui) uniform readonly uimage2D textCoordResource;
+layout(set = 0, binding = 13, r32ui) uniform readonly uimage2D normalResource;
+layout(set = 0, binding = 14, rgba8) uniform readonly image2D albedoColorResource;
+layout(set = 0, binding = 15, rgba8) uniform readonly image2D materialResource;
+
+// Adaptive sampling: luminance statistics written by the sampling pass, and the 8x8 tiles that are still traced
+layout(set = 0, binding = 16) buffer readonly PixelStatisticsSsbo {
+  PixelStatistics pixelStatistics[];
+};
+
+layout(set = 0, binding = 17) buffer TileMaskSsbo {
+  uint tileMasks[];
+};
+
+layout(set = 0, binding = 18) buffer ActiveTileSsbo {
+  uvec4 activeTileArgs;
+  uint activeTiles[];
+};
+
+// Primitive index plus one and the primary hit distance, drawn instead of the G-buffer in visibility buffer mode
+layout(set = 0, binding = 19, rg32ui) uniform readonly uimage2D visibilityResource;
+
+uvec2 imgSize = uvec2(imageSize(targetImage));
+
+vec3 vertexPosition(uint index) {
+  return vec3(vertexPositions[index].x, vertexPositions[index].y, vertexPositions[index].z);
+}
+
+// Goes into the alpha of the target image, the sampling pass finds the surface of a pixel again from it
+float primaryHitDistance(uvec2 imgPosition) {
+  if (ubo.isVisibilityBuffer == 1u) {
+    return uintBitsToFloat(imageLoad(visibilityResource, ivec2(imgPosition)).y);
+  }
+
+  return imageLoad(positionResource, ivec2(imgPosition)).x;
+}
\ No newline at end of file
@@ -63,41 +63,47 @@ ShadeRecord indirectGgxShade(Ray r, HitRecord hit, uint materialIndex, uint addi
   return indirectGgxShade(r.direction, hit.point, hit.normal, materials[materialIndex].baseColor, materials[materialIndex].roughness, materials[materialIndex].fresnelReflect, additionalRandomSeed);
 }
 
-ShadeRecord directGgxShade(vec3 rayDirection, vec3 point, vec3 normal, vec3 surfaceColor, float roughness, float fresnelReflect, uint additionalRandomSeed) {
+// Light sample of directGgxShade before the visibility test, the light only counts if shadowRay is unoccluded
+ShadeRecord directGgxSample(vec3 rayDirection, vec3 point, vec3 normal, vec3 surfaceColor, float roughness, float fresnelReflect, uint additionalRandomSeed, out Ray shadowRay) {
   ShadeRecord scat;
-  Ray shadowRay;
-
-  scat.radiance = vec3(0.0f);
-  scat.pdf = 0.0f;
 
   shadowRay.origin = point;
   uint lightIndex = randomUint(0, ubo.numLights - 1u, additionalRandomSeed);
 
   shadowRay.direction = areaLightGenerateRandom(lights[lightIndex], point, additionalRandomSeed);
-  HitRecord occludedHit = hitObjectBvh(shadowRay, 0.01f, 1.0f);
 
-  if (!occludedHit.isHit) {
-    vec3 unitLightDirection = normalize(shadowRay.direction);
-    vec3 hittedPointLightFaceNormal = areaLightFaceNormal(lights[lightIndex], unitLightDirection);
+  vec3 unitLightDirection = normalize(shadowRay.direction);
+  vec3 hittedPointLightFaceNormal = areaLightFaceNormal(lights[lightIndex], unitLightDirection);
 
-    float NloL = max(dot(hittedPointLightFaceNormal, -1.0f * unitLightDirection), 0.001f);
-    float NoL = max(dot(normal, unitLightDirection), 0.001f);    
+  float NloL = max(dot(hittedPointLightFaceNormal, -1.0f * unitLightDirection), 0.001f);
+  float NoL = max(dot(normal, unitLightDirection), 0.001f);    
 
-    vec3 unitViewDirection = normalize(rayDirection);
-    vec3 H = normalize(shadowRay.direction - rayDirection); // half vector
+  vec3 unitViewDirection = normalize(rayDirection);
+  vec3 H = normalize(shadowRay.direction - rayDirection); // half vector
 
-    float f0 = 0.16 * (fresnelReflect * fresnelReflect);
-    
-    float NoV = max(dot(normal, -1.0f * unitViewDirection), 0.001f);
-    float NoH = max(dot(normal, H), 0.001f);
-    float VoH = max(dot(unitViewDirection, H), 0.001f);
+  float f0 = 0.16 * (fresnelReflect * fresnelReflect);
+  
+  float NoV = max(dot(normal, -1.0f * unitViewDirection), 0.001f);
+  float NoH = max(dot(normal, H), 0.001f);
+  float VoH = max(dot(unitViewDirection, H), 0.001f);
+
+  float brdf = ggxBrdfValue(NoV, NoL, NoH, VoH, f0, roughness);
+  float sqrDistance = dot(shadowRay.direction, shadowRay.direction);
+  float area = areaAreaLight(lights[lightIndex]);
+
+  scat.pdf = ggxPdfValue(NoH, NoL, roughness);
+  scat.radiance = partialIntegrand(surfaceColor, brdf, NoL) * Gfactor(NloL, sqrDistance, area) * lights[lightIndex].color;
+
+  return scat;
+}
 
-    float brdf = ggxBrdfValue(NoV, NoL, NoH, VoH, f0, roughness);
-    float sqrDistance = dot(shadowRay.direction, shadowRay.direction);
-    float area = areaAreaLight(lights[lightIndex]);
+ShadeRecord directGgxShade(vec3 rayDirection, vec3 point, vec3 normal, vec3 surfaceColor, float roughness, float fresnelReflect, uint additionalRandomSeed) {
+  Ray shadowRay;
+  ShadeRecord scat = directGgxSample(rayDirection, point, normal, surfaceColor, roughness, fresnelReflect, additionalRandomSeed, shadowRay);
 
-    scat.pdf = ggxPdfValue(NoH, NoL, roughness);
-    scat.radiance = partialIntegrand(surfaceColor, brdf, NoL) * Gfactor(NloL, sqrDistance, area) * lights[lightIndex].color;
+  if (isOccluded(shadowRay, 0.01f, 1.0f)) {
+    scat.radiance = vec3(0.0f);
+    scat.pdf = 0.0f;
   }  
 
   return scat;
@@ -160,32 +166,38 @@ ShadeRecord indirectLambertShade(HitRecord hit, uint materialIndex, uint additio
   return indirectLambertShade(hit.point, hit.normal, materials[materialIndex].baseColor, additionalRandomSeed);
 }
 
-ShadeRecord directLambertShade(vec3 point, vec3 normal, vec3 surfaceColor, uint additionalRandomSeed) {
+// Light sample of directLambertShade before the visibility test, the light only counts if shadowRay is unoccluded
+ShadeRecord directLambertSample(vec3 point, vec3 normal, vec3 surfaceColor, uint additionalRandomSeed, out Ray shadowRay) {
   ShadeRecord scat;
-  Ray shadowRay;
-
-  scat.radiance = vec3(0.0f);
-  scat.pdf = 0.0f;
 
   shadowRay.origin = point;
   uint lightIndex = randomUint(0, ubo.numLights - 1u, additionalRandomSeed);
 
   shadowRay.direction = areaLightGenerateRandom(lights[lightIndex], point, additionalRandomSeed);
-  HitRecord occludedHit = hitObjectBvh(shadowRay, 0.01f, 1.0f);
 
-  if (!occludedHit.isHit) {
-    vec3 unitLightDirection = normalize(shadowRay.direction);
-    vec3 hittedPointLightFaceNormal = areaLightFaceNormal(lights[lightIndex], unitLightDirection);
+  vec3 unitLightDirection = normalize(shadowRay.direction);
+  vec3 hittedPointLightFaceNormal = areaLightFaceNormal(lights[lightIndex], unitLightDirection);
 
-    float NloL = max(dot(hittedPointLightFaceNormal, -1.0f * unitLightDirection), 0.001f);
-    float NoL = max(dot(normal, unitLightDirection), 0.001f);    
+  float NloL = max(dot(hittedPointLightFaceNormal, -1.0f * unitLightDirection), 0.001f);
+  float NoL = max(dot(normal, unitLightDirection), 0.001f);    
+
+  float sqrDistance = dot(shadowRay.direction, shadowRay.direction);
+  float area = areaAreaLight(lights[lightIndex]);
+  float brdf = lambertBrdfValue();
 
-    float sqrDistance = dot(shadowRay.direction, shadowRay.direction);
-    float area = areaAreaLight(lights[lightIndex]);
-    float brdf = lambertBrdfValue();
+  scat.pdf = lambertPdfValue(NoL);
+  scat.radiance = partialIntegrand(surfaceColor, brdf, NoL) * Gfactor(NloL, sqrDistance, area) * lights[lightIndex].color;
+
+  return scat;
+}
+
+ShadeRecord directLambertShade(vec3 point, vec3 normal, vec3 surfaceColor, uint additionalRandomSeed) {
+  Ray shadowRay;
+  ShadeRecord scat = directLambertSample(point, normal, surfaceColor, additionalRandomSeed, shadowRay);
 
-    scat.pdf = lambertPdfValue(NoL);
-    scat.radiance = partialIntegrand(surfaceColor, brdf, NoL) * Gfactor(NloL, sqrDistance, area) * lights[lightIndex].color;
+  if (isOccluded(shadowRay, 0.01f, 1.0f)) {
+    scat.radiance = vec3(0.0f);
+    scat.pdf = 0.0f;
   }  
 
   return scat;
@@ -0,0 +1,23 @@
+// ------------- Octahedral Normals -------------
+
+// Folds a unit vector onto the octahedron and flattens it into [-1, 1]^2, so two 16 bit values are enough for a normal
+vec2 octahedralEncode(vec3 normal) {
+  normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+
+  if (normal.z < 0.0f) {
+    vec2 signs = vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+    return (1.0f - abs(normal.yx)) * signs;
+  }
+
+  return normal.xy;
+}
+
+vec3 octahedralDecode(vec2 encoded) {
+  vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+
+  float fold = max(-normal.z, 0.0f);
+  normal.x += normal.x >= 0.0f ? -fold : fold;
+  normal.y += normal.y >= 0.0f ? -fold : fold;
+
+  return normalize(normal);
+}
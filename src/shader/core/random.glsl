@@ -7,8 +7,13 @@ float stepAndOutputRNGFloat(inout uint rngState) {
   return float(word) / 4294967295.0f;
 }
 
+// Kernels that do not run one invocation per pixel define the pixel the random numbers belong to
+#ifndef RANDOM_PIXEL_INDEX
+#define RANDOM_PIXEL_INDEX (imgSize.x * gl_GlobalInvocationID.y + gl_GlobalInvocationID.x)
+#endif
+
 float randomFloat(uint additionalRandomSeed) {
-  uint rngState =  (imgSize.x * gl_GlobalInvocationID.y + gl_GlobalInvocationID.x) * (push.randomSeed + 1 + additionalRandomSeed);
+  uint rngState =  (RANDOM_PIXEL_INDEX) * (ubo.randomSeed + ubo.seedOffset + 1 + additionalRandomSeed);
   return stepAndOutputRNGFloat(rngState);
 }
 
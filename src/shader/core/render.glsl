@@ -1,5 +1,12 @@
 // ------------- Integrand ------------- 
 
+#define ROULETTE_RANDOM_SEED 4096u
+
+// Chance for a path to go on past minBounce. Dim paths are likely to stop, survivors are reweighted by its inverse
+float survivalProbability(vec3 throughput) {
+  return clamp(max(throughput.r, max(throughput.g, throughput.b)), 0.05f, 1.0f);
+}
+
 vec3 integrandOverHemisphere(vec3 color, float brdf, float NoL, float pdf) {
   return color * brdf * NoL / pdf; 
 }
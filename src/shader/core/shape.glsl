@@ -50,24 +50,24 @@ vec3 areaLightGenerateRandom(AreaLight light, vec3 origin, uint additionalRandom
 // ------------- Triangle -------------
 
 vec3 triangleFaceNormal(uvec3 triIndices, vec3 rayDirection) {
-  vec3 v0v1 = vertices[triIndices.y].position.xyz - vertices[triIndices.x].position.xyz;
-  vec3 v0v2 = vertices[triIndices.z].position.xyz - vertices[triIndices.x].position.xyz;
+  vec3 v0v1 = vertexPosition(triIndices.y) - vertexPosition(triIndices.x);
+  vec3 v0v2 = vertexPosition(triIndices.z) - vertexPosition(triIndices.x);
 
   vec3 outwardNormal = normalize(cross(v0v1, v0v2));
   return setFaceNormal(rayDirection, outwardNormal);
 }
 
 float areaTriangle(uvec3 triIndices) {
-  vec3 v0v1 = vertices[triIndices.y].position.xyz - vertices[triIndices.x].position.xyz;
-  vec3 v0v2 = vertices[triIndices.z].position.xyz - vertices[triIndices.x].position.xyz;
+  vec3 v0v1 = vertexPosition(triIndices.y) - vertexPosition(triIndices.x);
+  vec3 v0v2 = vertexPosition(triIndices.z) - vertexPosition(triIndices.x);
 
   vec3 pvec = cross(v0v1, v0v2);
   return 0.5 * sqrt(dot(pvec, pvec)); 
 }
 
 vec3 triangleGenerateRandom(uvec3 triIndices, vec3 origin, uint additionalRandomSeed) {
-  vec3 a = vertices[triIndices.y].position.xyz - vertices[triIndices.x].position.xyz;
-  vec3 b = vertices[triIndices.z].position.xyz - vertices[triIndices.x].position.xyz;
+  vec3 a = vertexPosition(triIndices.y) - vertexPosition(triIndices.x);
+  vec3 b = vertexPosition(triIndices.z) - vertexPosition(triIndices.x);
 
   float u1 = randomFloat(additionalRandomSeed);
   float u2 = randomFloat(additionalRandomSeed + 1);
@@ -77,6 +77,6 @@ vec3 triangleGenerateRandom(uvec3 triIndices, vec3 origin, uint additionalRandom
     u2 = 1 - u2;
   }
 
-  vec3 randomTriangle = u1 * a + u2 * b + vertices[triIndices.x].position.xyz;
+  vec3 randomTriangle = u1 * a + u2 * b + vertexPosition(triIndices.x);
   return randomTriangle - origin;
 }
\ No newline at end of file
@@ -2,12 +2,19 @@
 
 // ---------------------- buffer struct ----------------------
 
-struct Vertex {
-  vec4 position;
-  vec4 textCoord;
-  vec4 normal;
-  uint materialIndex; // Because of hybrid rendering, Material Index also hold by Vertex
-  uint transformIndex; // Because of hybrid rendering, Transform Index also hold by Vertex
+// Three floats rather than a vec3, so the array stays tightly packed at 12 bytes per vertex
+struct VertexPosition {
+  float x;
+  float y;
+  float z;
+};
+
+// Half float texture coordinate, octahedral normal in two snorm16, 
+// material index in the low and transform index in the high 16 bits of indices
+struct VertexAttribute {
+  uint textCoord;
+  uint normal;
+  uint indices;
 };
 
 struct Primitive {
@@ -15,6 +22,13 @@ struct Primitive {
   uint materialIndex;
 };
 
+// Edge form of the primitive at the same index, with the unit geometric normal in the w components
+struct Triangle {
+  vec4 point0;
+  vec4 edge1;
+  vec4 edge2;
+};
+
 struct Object {
   uint firstBvhIndex;
   uint firstPrimitiveIndex;
@@ -46,6 +60,19 @@ struct BvhNode {
   vec3 minimum;
 };
 
+struct WideBvhNode {
+  vec3 origin;
+  uint exponents;
+
+  uvec4 children;
+
+  uvec3 quantizedMinimum;
+  uint childCount;
+
+  uvec3 quantizedMaximum;
+  uint leafCounts;
+};
+
 struct Material {
   vec3 baseColor;
 	float metallicness;
@@ -61,6 +88,12 @@ struct Transformation {
   mat4 normalMatrix;
 };
 
+struct PixelStatistics {
+  uint sampleCount;
+  float mean;
+  float m2;
+};
+
 // ---------------------- internal struct ----------------------
 
 struct Ray {
@@ -95,4 +128,6 @@ struct RadianceRecord {
 
 #define pi 3.14159265359
 #define FLT_MAX 3.402823466e+38
-#define FLT_MIN 1.175494351e-38
\ No newline at end of file
+#define FLT_MIN 1.175494351e-38
+#define WIDE_BVH_LEAF 0x80000000u
+#define BVH_STACK_SIZE 64 // bvhStackSize in bvh.hpp, the Bvh builders make sure traversals fit
\ No newline at end of file
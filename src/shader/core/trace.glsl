@@ -100,12 +100,13 @@ HitRecord hitAreaLight(AreaLight light, Ray r, float tMin, float tMax) {
 
 // ------------- Triangle -------------
 
-HitRecord hitTriangle(uvec3 triIndices, Ray r, float tMin, float tMax, uint transformIndex) {
+// Object space hit, hitPrimitiveBvh moves the closest one into world space
+HitRecord hitTriangle(Triangle triangle, Ray r, float tMin, float tMax) {
   HitRecord hit;
   hit.isHit = false;
 
-  vec3 v0v1 = vertices[triIndices.y].position.xyz - vertices[triIndices.x].position.xyz;
-  vec3 v0v2 = vertices[triIndices.z].position.xyz - vertices[triIndices.x].position.xyz;
+  vec3 v0v1 = triangle.edge1.xyz;
+  vec3 v0v2 = triangle.edge2.xyz;
   vec3 pvec = cross(r.direction, v0v2);
   float det = dot(v0v1, pvec);
   
@@ -115,7 +116,7 @@ HitRecord hitTriangle(uvec3 triIndices, Ray r, float tMin, float tMax, uint tran
     
   float invDet = 1.0f / det;
 
-  vec3 tvec = r.origin - vertices[triIndices.x].position.xyz;
+  vec3 tvec = r.origin - triangle.point0.xyz;
   float u = dot(tvec, pvec) * invDet;
   if (u < 0.0f || u > 1.0f) {
     return hit;
@@ -139,15 +140,41 @@ HitRecord hitTriangle(uvec3 triIndices, Ray r, float tMin, float tMax, uint tran
 
   hit.isHit = true;
   hit.t = t;
-  hit.point = (transformations[transformIndex].pointMatrix * vec4(rayAt(r, t), 1.0f)).xyz;
   hit.uv = vec2(u, v);
 
-  vec3 outwardNormal = normalize(cross(v0v1, v0v2));
-  hit.normal = normalize(mat3(transformations[transformIndex].normalMatrix) * setFaceNormal(r.direction, outwardNormal));
+  vec3 outwardNormal = vec3(triangle.point0.w, triangle.edge1.w, triangle.edge2.w);
+  hit.normal = setFaceNormal(r.direction, outwardNormal);
 
   return hit;
 }
 
+// Same test as hitTriangle, for shadow rays that only need to know whether anything is in the way
+bool occludeTriangle(Triangle triangle, Ray r, float tMin, float tMax) {
+  vec3 pvec = cross(r.direction, triangle.edge2.xyz);
+  float det = dot(triangle.edge1.xyz, pvec);
+
+  if (abs(det) < KEPSILON) {
+    return false;
+  }
+
+  float invDet = 1.0f / det;
+
+  vec3 tvec = r.origin - triangle.point0.xyz;
+  float u = dot(tvec, pvec) * invDet;
+  if (u < 0.0f || u > 1.0f) {
+    return false;
+  }
+
+  vec3 qvec = cross(tvec, triangle.edge1.xyz);
+  float v = dot(r.direction, qvec) * invDet;
+  if (v < 0.0f || u + v > 1.0f) {
+    return false;
+  }
+
+  float t = dot(triangle.edge2.xyz, qvec) * invDet;
+  return t > KEPSILON && t >= tMin && t <= tMax;
+}
+
 // ------------- Bvh -------------
 
 bool intersectAABB(Ray r, vec3 boxMin, vec3 boxMax) {
@@ -161,12 +188,38 @@ bool intersectAABB(Ray r, vec3 boxMin, vec3 boxMax) {
   return tNear < tFar;
 }
 
+// Entry distance of the ray into the box, or FLT_MAX when it misses or only enters beyond tLimit
+float intersectAABBDistance(Ray r, vec3 boxMin, vec3 boxMax, float tLimit) {
+  vec3 tMin = (boxMin - r.origin) / r.direction;
+  vec3 tMax = (boxMax - r.origin) / r.direction;
+  vec3 t1 = min(tMin, tMax);
+  vec3 t2 = max(tMin, tMax);
+  float tNear = max(max(t1.x, t1.y), t1.z);
+  float tFar = min(min(t2.x, t2.y), t2.z);
+
+  return (tNear < tFar && tFar > 0.0f && tNear < tLimit) ? tNear : FLT_MAX;
+}
+
+// ------------- Wide Bvh -------------
+
+vec3 wideBvhStep(uint exponents) {
+  return vec3(
+    ldexp(1.0f, int(exponents & 0xFFu) - 127),
+    ldexp(1.0f, int((exponents >> 8u) & 0xFFu) - 127),
+    ldexp(1.0f, int((exponents >> 16u) & 0xFFu) - 127)
+  );
+}
+
+vec3 wideBvhChildBound(uvec3 quantized, uint childIndex, vec3 origin, vec3 step) {
+  return origin + vec3((quantized >> (8u * childIndex)) & 0xFFu) * step;
+}
+
 HitRecord hitPrimitiveBvh(Ray r, float tMin, float tMax, uint firstBvhIndex, uint firstPrimitiveIndex, uint transformIndex) {
   HitRecord hit;
   hit.isHit = false;
   hit.t = tMax;
 
-  uint stack[30];
+  uint stack[BVH_STACK_SIZE];
   stack[0] = 1u;
 
   int stackIndex = 1;  
@@ -174,52 +227,66 @@ HitRecord hitPrimitiveBvh(Ray r, float tMin, float tMax, uint firstBvhIndex, uin
   r.origin = (transformations[transformIndex].pointInverseMatrix * vec4(r.origin, 1.0f)).xyz;
   r.direction = mat3(transformations[transformIndex].dirInverseMatrix) * r.direction;
 
-  while(stackIndex > 0 && stackIndex <= 30) {
+  while(stackIndex > 0) {
     stackIndex--;
-    uint currentNode = stack[stackIndex];
-    if (currentNode == 0u) {
-      continue;
-    }
+    WideBvhNode node = primitiveBvhNodes[stack[stackIndex] - 1u + firstBvhIndex];
+    vec3 step = wideBvhStep(node.exponents);
 
-    if (!intersectAABB(r, primitiveBvhNodes[currentNode - 1u + firstBvhIndex].minimum, primitiveBvhNodes[currentNode - 1u + firstBvhIndex].maximum)) {
-      continue;
-    }
+    uint innerNodes[4];
+    float innerDistances[4];
+    uint innerCount = 0u;
 
-    uint primIndex = primitiveBvhNodes[currentNode - 1u + firstBvhIndex].leftObjIndex;
-    if (primIndex >= 1u) {
-      HitRecord tempHit = hitTriangle(primitives[primIndex - 1u + firstPrimitiveIndex].indices, r, tMin, hit.t, transformIndex);
+    for (uint i = 0u; i < node.childCount; i++) {
+      vec3 childMin = wideBvhChildBound(node.quantizedMinimum, i, node.origin, step);
+      vec3 childMax = wideBvhChildBound(node.quantizedMaximum, i, node.origin, step);
 
-      if (tempHit.isHit) {
-        hit = tempHit;
-        hit.hitIndex = primIndex - 1u + firstPrimitiveIndex;
-        // hit.uv = getTotalTextureCoordinate(primitives[hit.hitIndex].indices, hit.uv);
+      float distance = intersectAABBDistance(r, childMin, childMax, hit.t);
+      if (distance == FLT_MAX) {
+        continue;
       }
-    }
 
-    primIndex = primitiveBvhNodes[currentNode - 1u + firstBvhIndex].rightObjIndex;    
-    if (primIndex >= 1u) {
-      HitRecord tempHit = hitTriangle(primitives[primIndex - 1u + firstPrimitiveIndex].indices, r, tMin, hit.t, transformIndex);
+      uint child = node.children[i];
+      if ((child & WIDE_BVH_LEAF) != 0u) {
+        uint firstPrimIndex = (child & ~WIDE_BVH_LEAF) + firstPrimitiveIndex;
+        uint primCount = (node.leafCounts >> (8u * i)) & 0xFFu;
 
-      if (tempHit.isHit) {
-        hit = tempHit;
-        hit.hitIndex = primIndex - 1u + firstPrimitiveIndex;
-        // hit.uv = getTotalTextureCoordinate(primitives[hit.hitIndex].indices, hit.uv);
+        for (uint primIndex = firstPrimIndex; primIndex < firstPrimIndex + primCount; primIndex++) {
+          HitRecord tempHit = hitTriangle(triangles[primIndex], r, tMin, hit.t);
+
+          if (tempHit.isHit) {
+            hit = tempHit;
+            hit.hitIndex = primIndex;
+            // hit.uv = getTotalTextureCoordinate(primitives[hit.hitIndex].indices, hit.uv);
+          }
+        }
+
+        continue;
       }
-    }
 
-    uint bvhNode = primitiveBvhNodes[currentNode - 1u + firstBvhIndex].leftNode;
-    if (bvhNode >= 1u) {
-      stack[stackIndex] = bvhNode;
-      stackIndex++;
+      // keep the inner children sorted from far to near
+      uint j = innerCount;
+      for (; j > 0u && innerDistances[j - 1u] < distance; j--) {
+        innerNodes[j] = innerNodes[j - 1u];
+        innerDistances[j] = innerDistances[j - 1u];
+      }
+
+      innerNodes[j] = child;
+      innerDistances[j] = distance;
+      innerCount++;
     }
 
-    bvhNode = primitiveBvhNodes[currentNode - 1u + firstBvhIndex].rightNode;
-    if (bvhNode >= 1u) {
-      stack[stackIndex] = bvhNode;
+    // the nearest child is pushed last, so it is visited first
+    for (uint i = 0u; i < innerCount && stackIndex < BVH_STACK_SIZE; i++) {
+      stack[stackIndex] = innerNodes[i];
       stackIndex++;
     }
   }
 
+  if (hit.isHit) {
+    hit.point = (transformations[transformIndex].pointMatrix * vec4(rayAt(r, hit.t), 1.0f)).xyz;
+    hit.normal = normalize(mat3(transformations[transformIndex].normalMatrix) * hit.normal);
+  }
+
   return hit;
 }
 
@@ -228,48 +295,59 @@ HitRecord hitObjectBvh(Ray r, float tMin, float tMax) {
   hit.isHit = false;
   hit.t = tMax;
 
-  uint stack[30];
+  uint stack[BVH_STACK_SIZE];
   stack[0] = 1u;
 
   int stackIndex = 1;
-  while(stackIndex > 0 && stackIndex <= 30) {
+  while(stackIndex > 0) {
     stackIndex--;
-    uint currentNode = stack[stackIndex];
-    if (currentNode == 0u) {
-      continue;
-    }
+    WideBvhNode node = objectBvhNodes[stack[stackIndex] - 1u];
+    vec3 step = wideBvhStep(node.exponents);
 
-    if (!intersectAABB(r, objectBvhNodes[currentNode - 1u].minimum, objectBvhNodes[currentNode - 1u].maximum)) {
-      continue;
-    }
+    uint innerNodes[4];
+    float innerDistances[4];
+    uint innerCount = 0u;
 
-    uint objIndex = objectBvhNodes[currentNode - 1u].leftObjIndex;
-    if (objIndex >= 1u) {
-      HitRecord tempHit = hitPrimitiveBvh(r, tMin, hit.t, objects[objIndex - 1u].firstBvhIndex, objects[objIndex - 1u].firstPrimitiveIndex, objects[objIndex - 1u].transformIndex);
+    for (uint i = 0u; i < node.childCount; i++) {
+      vec3 childMin = wideBvhChildBound(node.quantizedMinimum, i, node.origin, step);
+      vec3 childMax = wideBvhChildBound(node.quantizedMaximum, i, node.origin, step);
 
-      if (tempHit.isHit) {
-        hit = tempHit;
+      float distance = intersectAABBDistance(r, childMin, childMax, hit.t);
+      if (distance == FLT_MAX) {
+        continue;
       }
-    }
 
-    objIndex = objectBvhNodes[currentNode - 1u].rightObjIndex;
-    if (objIndex >= 1u) {
-      HitRecord tempHit = hitPrimitiveBvh(r, tMin, hit.t, objects[objIndex - 1u].firstBvhIndex, objects[objIndex - 1u].firstPrimitiveIndex, objects[objIndex - 1u].transformIndex);
+      uint child = node.children[i];
+      if ((child & WIDE_BVH_LEAF) != 0u) {
+        uint firstObjIndex = child & ~WIDE_BVH_LEAF;
+        uint objCount = (node.leafCounts >> (8u * i)) & 0xFFu;
 
-      if (tempHit.isHit) {
-        hit = tempHit;
+        for (uint objIndex = firstObjIndex; objIndex < firstObjIndex + objCount; objIndex++) {
+          HitRecord tempHit = hitPrimitiveBvh(r, tMin, hit.t, objects[objIndex].firstBvhIndex, objects[objIndex].firstPrimitiveIndex, objects[objIndex].transformIndex);
+
+          if (tempHit.isHit) {
+            hit = tempHit;
+          }
+        }
+
+        continue;
       }
-    }
 
-    uint bvhNode = objectBvhNodes[currentNode - 1u].leftNode;
-    if (bvhNode >= 1u) {
-      stack[stackIndex] = bvhNode;
-      stackIndex++;
+      // keep the inner children sorted from far to near
+      uint j = innerCount;
+      for (; j > 0u && innerDistances[j - 1u] < distance; j--) {
+        innerNodes[j] = innerNodes[j - 1u];
+        innerDistances[j] = innerDistances[j - 1u];
+      }
+
+      innerNodes[j] = child;
+      innerDistances[j] = distance;
+      innerCount++;
     }
 
-    bvhNode = objectBvhNodes[currentNode - 1u].rightNode;
-    if (bvhNode >= 1u) {
-      stack[stackIndex] = bvhNode;
+    // the nearest child is pushed last, so it is visited first
+    for (uint i = 0u; i < innerCount && stackIndex < BVH_STACK_SIZE; i++) {
+      stack[stackIndex] = innerNodes[i];
       stackIndex++;
     }
   }
@@ -277,6 +355,98 @@ HitRecord hitObjectBvh(Ray r, float tMin, float tMax) {
   return hit;
 }
 
+// ------------- Occlusion BVH -------------
+
+// Any hit traversal for shadow rays: children are not sorted, the interval never shrinks, 
+// and the first triangle found inside it ends the search without building a hit record
+bool occludePrimitiveBvh(Ray r, float tMin, float tMax, uint firstBvhIndex, uint firstPrimitiveIndex, uint transformIndex) {
+  uint stack[BVH_STACK_SIZE];
+  stack[0] = 1u;
+
+  int stackIndex = 1;
+
+  r.origin = (transformations[transformIndex].pointInverseMatrix * vec4(r.origin, 1.0f)).xyz;
+  r.direction = mat3(transformations[transformIndex].dirInverseMatrix) * r.direction;
+
+  while(stackIndex > 0) {
+    stackIndex--;
+    WideBvhNode node = primitiveBvhNodes[stack[stackIndex] - 1u + firstBvhIndex];
+    vec3 step = wideBvhStep(node.exponents);
+
+    for (uint i = 0u; i < node.childCount; i++) {
+      vec3 childMin = wideBvhChildBound(node.quantizedMinimum, i, node.origin, step);
+      vec3 childMax = wideBvhChildBound(node.quantizedMaximum, i, node.origin, step);
+
+      if (intersectAABBDistance(r, childMin, childMax, tMax) == FLT_MAX) {
+        continue;
+      }
+
+      uint child = node.children[i];
+      if ((child & WIDE_BVH_LEAF) != 0u) {
+        uint firstPrimIndex = (child & ~WIDE_BVH_LEAF) + firstPrimitiveIndex;
+        uint primCount = (node.leafCounts >> (8u * i)) & 0xFFu;
+
+        for (uint primIndex = firstPrimIndex; primIndex < firstPrimIndex + primCount; primIndex++) {
+          if (occludeTriangle(triangles[primIndex], r, tMin, tMax)) {
+            return true;
+          }
+        }
+
+        continue;
+      }
+
+      if (stackIndex < BVH_STACK_SIZE) {
+        stack[stackIndex] = child;
+        stackIndex++;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool isOccluded(Ray r, float tMin, float tMax) {
+  uint stack[BVH_STACK_SIZE];
+  stack[0] = 1u;
+
+  int stackIndex = 1;
+  while(stackIndex > 0) {
+    stackIndex--;
+    WideBvhNode node = objectBvhNodes[stack[stackIndex] - 1u];
+    vec3 step = wideBvhStep(node.exponents);
+
+    for (uint i = 0u; i < node.childCount; i++) {
+      vec3 childMin = wideBvhChildBound(node.quantizedMinimum, i, node.origin, step);
+      vec3 childMax = wideBvhChildBound(node.quantizedMaximum, i, node.origin, step);
+
+      if (intersectAABBDistance(r, childMin, childMax, tMax) == FLT_MAX) {
+        continue;
+      }
+
+      uint child = node.children[i];
+      if ((child & WIDE_BVH_LEAF) != 0u) {
+        uint firstObjIndex = child & ~WIDE_BVH_LEAF;
+        uint objCount = (node.leafCounts >> (8u * i)) & 0xFFu;
+
+        for (uint objIndex = firstObjIndex; objIndex < firstObjIndex + objCount; objIndex++) {
+          if (occludePrimitiveBvh(r, tMin, tMax, objects[objIndex].firstBvhIndex, objects[objIndex].firstPrimitiveIndex, objects[objIndex].transformIndex)) {
+            return true;
+          }
+        }
+
+        continue;
+      }
+
+      if (stackIndex < BVH_STACK_SIZE) {
+        stack[stackIndex] = child;
+        stackIndex++;
+      }
+    }
+  }
+
+  return false;
+}
+
 // ------------- Light BVH -------------
 
 HitRecord hitLightBvh(Ray r, float tMin, float tMax) {
@@ -284,11 +454,11 @@ HitRecord hitLightBvh(Ray r, float tMin, float tMax) {
   hit.isHit = false;
   hit.t = tMax;
 
-  uint stack[30];
+  uint stack[BVH_STACK_SIZE];
   stack[0] = 1u;
 
   int stackIndex = 1;
-  while(stackIndex > 0 && stackIndex <= 30) {
+  while(stackIndex > 0 && stackIndex <= BVH_STACK_SIZE) {
     stackIndex--;
     uint currentNode = stack[stackIndex];
     if (currentNode == 0u) {
@@ -0,0 +1,45 @@
+// ------------- Trace Pattern -------------
+
+#define TRACE_MODE_FULL 0u
+#define TRACE_MODE_CHECKERBOARD 1u
+#define TRACE_MODE_HALF 2u
+
+// Pixels per traced pixel along each axis
+uvec2 traceScale() {
+  if (ubo.traceMode == TRACE_MODE_CHECKERBOARD) {
+    return uvec2(2u, 1u);
+  }
+
+  if (ubo.traceMode == TRACE_MODE_HALF) {
+    return uvec2(2u, 2u);
+  }
+
+  return uvec2(1u);
+}
+
+// The pattern moves on with every sample, so each pixel is traced in every second (checkerboard) 
+// or fourth (half resolution) sample and reconstructed from its neighbours in between
+bool isPixelTraced(uvec2 imgPosition) {
+  if (ubo.traceMode == TRACE_MODE_CHECKERBOARD) {
+    return ((imgPosition.x + imgPosition.y + ubo.randomSeed) & 1u) == 0u;
+  }
+
+  if (ubo.traceMode == TRACE_MODE_HALF) {
+    return (imgPosition & 1u) == uvec2(ubo.randomSeed & 1u, (ubo.randomSeed >> 1u) & 1u);
+  }
+
+  return true;
+}
+
+// The traced pixel of the traceScale sized cell starting at cellOrigin, whose coordinates are a multiple of traceScale
+uvec2 tracedPixel(uvec2 cellOrigin) {
+  if (ubo.traceMode == TRACE_MODE_CHECKERBOARD) {
+    return cellOrigin + uvec2((cellOrigin.y + ubo.randomSeed) & 1u, 0u);
+  }
+
+  if (ubo.traceMode == TRACE_MODE_HALF) {
+    return cellOrigin + uvec2(ubo.randomSeed & 1u, (ubo.randomSeed >> 1u) & 1u);
+  }
+
+  return cellOrigin;
+}
@@ -0,0 +1,139 @@
+// ------------- Wavefront Layout -------------
+
+// Path state of one pixel, indexed by the pixel
+struct WavefrontPath {
+  vec3 radiance;
+  float indirectPdf;
+
+  vec3 throughput;
+  float pendingIndirectPdf;
+
+  // Written by the shade kernels, resolved by the connect kernel once the visibility of the light sample is known
+  vec3 pendingIndirect;
+  float pendingDirectPdf;
+
+  vec3 pendingDirect;
+
+  vec3 rayOrigin;
+  vec3 rayDirection;
+  vec3 shadowOrigin;
+  vec3 shadowDirection;
+};
+
+// Surface to be shaded, GGX hits fill the queue from the front and Lambert hits from the back
+struct WavefrontHit {
+  vec3 point;
+  uint pixelIndex;
+
+  vec3 normal;
+  float roughness;
+
+  vec3 rayDirection;
+  float fresnelReflect;
+
+  vec3 baseColor;
+};
+
+layout(set = 1, binding = 0) buffer WavefrontPathSsbo {
+  WavefrontPath paths[];
+};
+
+layout(set = 1, binding = 1) buffer WavefrontHitSsbo {
+  WavefrontHit hits[];
+};
+
+layout(set = 1, binding = 2) buffer WavefrontExtendSsbo {
+  uint extendQueues[];
+};
+
+layout(set = 1, binding = 3) buffer WavefrontShadowSsbo {
+  uint shadowQueue[];
+};
+
+// The dispatch arguments of every stage are computed on the GPU from the counters of its input queue
+layout(set = 1, binding = 4) buffer WavefrontCounterSsbo {
+  uint extendCounts[2];
+  uint ggxCount;
+  uint lambertCount;
+  uint shadowCount;
+
+  uvec4 extendArgs;
+  uvec4 ggxArgs;
+  uvec4 lambertArgs;
+  uvec4 connectArgs;
+};
+
+// Optional ray sorting: a key per queued ray and a counting sort over its bins
+#define WAVEFRONT_SORT_BIN_COUNT 4096u
+
+layout(set = 1, binding = 5) buffer WavefrontSortKeySsbo {
+  uint sortKeys[];
+};
+
+layout(set = 1, binding = 6) buffer WavefrontSortBinSsbo {
+  uint unsortedRuns;
+  uint sortedRuns;
+  uint sortedRayCount;
+
+  uint binCounts[WAVEFRONT_SORT_BIN_COUNT];
+  uint binOffsets[WAVEFRONT_SORT_BIN_COUNT];
+};
+
+layout(push_constant) uniform WavefrontPushConstant {
+  uint bounce;
+  uint stage;
+  uint isSorted;
+} push;
+
+#define WAVEFRONT_GROUP_SIZE 64u
+
+#define WAVEFRONT_STAGE_EXTEND 0u
+#define WAVEFRONT_STAGE_SHADE 1u
+#define WAVEFRONT_STAGE_CONNECT 2u
+
+uint pixelCount = imgSize.x * imgSize.y;
+uint pixelIndex = 0u;
+
+#define RANDOM_PIXEL_INDEX pixelIndex
+
+void pushHit(WavefrontHit hit, bool isGgx) {
+  if (isGgx) {
+    hits[atomicAdd(ggxCount, 1u)] = hit;
+  } else {
+    hits[pixelCount - 1u - atomicAdd(lambertCount, 1u)] = hit;
+  }
+}
+
+// Bounce 0 starts from the G-buffer instead of a ray, odd and even bounces take turns on the two extend queues
+void pushExtend(uint bounce, uint index) {
+  uint queue = bounce & 1u;
+  extendQueues[queue * pixelCount + atomicAdd(extendCounts[queue], 1u)] = index;
+}
+
+// Rays of the current bounce in the order they are traced, sorted ones live behind both extend queues
+uint extendRay(uint index) {
+  if (push.isSorted != 0u) {
+    return extendQueues[2u * pixelCount + index];
+  }
+
+  return extendQueues[(push.bounce & 1u) * pixelCount + index];
+}
+
+void pushShadow(uint index) {
+  shadowQueue[atomicAdd(shadowCount, 1u)] = index;
+}
+
+// Keeps both samples of a shaded hit until the connect kernel knows whether the light sample is visible
+void storeShade(ShadeRecord indirectShadeResult, ShadeRecord directShadeResult, Ray shadowRay) {
+  paths[pixelIndex].pendingIndirect = indirectShadeResult.radiance;
+  paths[pixelIndex].pendingIndirectPdf = indirectShadeResult.pdf;
+  paths[pixelIndex].pendingDirect = directShadeResult.radiance;
+  paths[pixelIndex].pendingDirectPdf = directShadeResult.pdf;
+
+  paths[pixelIndex].rayOrigin = indirectShadeResult.nextRay.origin;
+  paths[pixelIndex].rayDirection = indirectShadeResult.nextRay.direction;
+  paths[pixelIndex].shadowOrigin = shadowRay.origin;
+  paths[pixelIndex].shadowDirection = shadowRay.direction;
+
+  pushShadow(pixelIndex);
+}
@@ -1,12 +1,13 @@
 #version 460
 
 #include "core/struct.glsl"
+#include "core/octahedral.glsl"
 
-layout(location = 0) in vec4 position;
-layout(location = 1) in vec4 textCoord;
-layout(location = 2) in vec4 normal;
-layout(location = 3) in uint materialIndex;
-layout(location = 4) in uint transformIndex;
+// Position stream and the packed attribute stream, see VertexAttribute
+layout(location = 0) in vec3 position;
+layout(location = 1) in uint textCoord;
+layout(location = 2) in uint normal;
+layout(location = 3) in uint indices;
 
 layout(location = 0) out vec3 positionFrag;
 layout(location = 1) out vec3 textCoordFrag;
@@ -28,11 +29,16 @@ layout(set = 0, binding = 2) buffer readonly TransformationSsbo {
 };
 
 void main() {
-	gl_Position = ubo.projection * ubo.view * transformations[transformIndex].pointMatrix * position;
+	uint materialIndex = indices & 0xFFFFu;
+	uint transformIndex = indices >> 16;
 
-	positionFrag = position.xyz;
-	textCoordFrag = textCoord.xyz;
-	normalFrag = normalize(mat3(transformations[transformIndex].normalMatrix) * normal.xyz);
+	vec4 viewPosition = ubo.view * transformations[transformIndex].pointMatrix * vec4(position, 1.0f);
+	gl_Position = ubo.projection * viewPosition;
+
+	// The view is rigid, so the length of the view space position is the distance from the camera
+	positionFrag = viewPosition.xyz;
+	textCoordFrag = vec3(unpackHalf2x16(textCoord), 0.0f);
+	normalFrag = normalize(mat3(transformations[transformIndex].normalMatrix) * octahedralDecode(unpackSnorm2x16(normal)));
 	albedoColorFrag = materials[materialIndex].baseColor;
 	materialFrag = vec3(materials[materialIndex].metallicness, materials[materialIndex].roughness, materials[materialIndex].fresnelReflect);
 }
\ No newline at end of file
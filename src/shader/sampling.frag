@@ -8,16 +8,154 @@ layout(location = 0) out vec4 outColor;
 layout(set = 0, binding = 0, rgba32f) uniform readonly image2D inputImage;
 layout(set = 0, binding = 1, rgba32f) uniform image2D accumulateImage;
 
-layout(push_constant) uniform Push {
+layout(set = 0, binding = 2) uniform readonly RayTraceUbo {
+  vec3 origin;
+  vec3 background;
+  uint numLights;
   uint randomSeed;
-} push;
+  uint minBounce;
+  uint maxBounce;
+  uint seedOffset;
+  uint minSamples;
+  float errorThreshold;
+  uint firstTile;
+  uint tileCount;
+  uint traceMode;
+  mat4 inverseViewProjection;
+  mat4 previousViewProjection;
+  vec3 previousOrigin;
+  uint maxHistory;
+  uint isCameraMoved;
+  uint isVisibilityBuffer;
+  uint isStatisticsStale;
+} ubo;
 
+struct PixelStatistics {
+  uint sampleCount;
+  float mean;
+  float m2;
+};
+
+layout(set = 0, binding = 3) buffer PixelStatisticsSsbo {
+  PixelStatistics pixelStatistics[];
+};
+
+layout(set = 0, binding = 4) buffer readonly TileMaskSsbo {
+  uint tileMasks[];
+};
+
+// Temporal accumulation: copies of the accumulation and its statistics as the previous frame left them
+layout(set = 0, binding = 5, rgba32f) uniform readonly image2D historyImage;
+
+layout(set = 0, binding = 6) buffer readonly HistoryStatisticsSsbo {
+  PixelStatistics historyStatistics[];
+};
+
+#include "core/trace_pattern.glsl"
+
+#define ADAPTIVE_TILE_SIZE 8u
+
+// How far the hit distance of a reprojected pixel may be off (relative to it) before its history counts as disoccluded
+#define TEMPORAL_DISTANCE_TOLERANCE 0.02f
+
+// Finds the surface of this pixel in the previous frame and takes over the accumulation it had there. 
+// The alpha of both the input and the accumulation is the primary hit distance from the camera they were traced with, 
+// so a history pixel that lay on another surface (or off screen) is rejected. The history length is capped at maxHistory.
+bool reprojectHistory(uvec2 imgPosition, uvec2 imgSize, float hitDistance, out vec4 historyColor, out PixelStatistics statistics) {
+  historyColor = vec4(0.0f);
+  statistics = PixelStatistics(0u, 0.0f, 0.0f);
+
+  vec2 ndc = (vec2(imgPosition) + 0.5f) / vec2(imgSize) * 2.0f - 1.0f;
+  vec4 nearPoint = ubo.inverseViewProjection * vec4(ndc, 0.0f, 1.0f);
+  vec3 position = ubo.origin + normalize(nearPoint.xyz / nearPoint.w - ubo.origin) * hitDistance;
+
+  vec4 previousClip = ubo.previousViewProjection * vec4(position, 1.0f);
+  if (previousClip.w <= 0.0f) {
+    return false;
+  }
+
+  vec2 previousPosition = (previousClip.xy / previousClip.w * 0.5f + 0.5f) * vec2(imgSize);
+  if (any(lessThan(previousPosition, vec2(0.0f))) || any(greaterThanEqual(previousPosition, vec2(imgSize)))) {
+    return false;
+  }
+
+  ivec2 historyPosition = ivec2(previousPosition);
+  vec4 history = imageLoad(historyImage, historyPosition);
+
+  float previousDistance = distance(position, ubo.previousOrigin);
+  if (abs(history.a - previousDistance) > TEMPORAL_DISTANCE_TOLERANCE * previousDistance) {
+    return false;
+  }
+
+  historyColor = history;
+  statistics = historyStatistics[imgSize.x * uint(historyPosition.y) + uint(historyPosition.x)];
+
+  if (statistics.sampleCount > ubo.maxHistory) {
+    statistics.m2 *= float(ubo.maxHistory) / float(statistics.sampleCount);
+    statistics.sampleCount = ubo.maxHistory;
+  }
+
+  return true;
+}
+
+// Every pixel keeps its own sample count, since converged tiles stop being traced. 
+// The luminance of each sample also goes into a running mean and variance (Welford) for the next tile pass.
 void main() {
-  vec4 accColor = imageLoad(accumulateImage, ivec2(gl_FragCoord.xy));
-  vec4 inputColor = imageLoad(inputImage, ivec2(gl_FragCoord.xy));
+  uvec2 imgPosition = uvec2(gl_FragCoord.xy);
+  uvec2 imgSize = uvec2(imageSize(accumulateImage));
+  uint pixelIndex = imgSize.x * imgPosition.y + imgPosition.x;
+
+  // Radiance, and the primary hit distance of this frame in alpha
+  vec4 inputColor = imageLoad(inputImage, ivec2(imgPosition));
+  inputColor.rgb /= 255.0f;
+
+  vec4 accColor;
+  PixelStatistics statistics;
+
+  // After a camera move every pixel takes over its reprojected history, whether it is traced this frame or not
+  bool isReprojected = ubo.randomSeed != 0u && ubo.isCameraMoved == 1u;
+
+  if (isReprojected) {
+    reprojectHistory(imgPosition, imgSize, inputColor.a, accColor, statistics);
+  } else {
+    accColor = imageLoad(accumulateImage, ivec2(imgPosition));
+    statistics = ubo.randomSeed == 0u ? PixelStatistics(0u, 0.0f, 0.0f) : pixelStatistics[pixelIndex];
+  }
+
+  // Not traced this frame, the input still holds an older sample
+  uvec2 tileSize = ADAPTIVE_TILE_SIZE * traceScale();
+  uvec2 tile = imgPosition / tileSize;
+  bool isTileActive = tileMasks[tile.y * ((imgSize.x + tileSize.x - 1u) / tileSize.x) + tile.x] != 0u;
+
+  // Reconstructed from traced neighbours: shown until the pixel has a sample of its own, but never counted as one
+  if (!isTileActive || !isPixelTraced(imgPosition)) {
+    if (isTileActive && statistics.sampleCount == 0u) {
+      accColor = inputColor;
+    }
+
+    if (isReprojected || (isTileActive && statistics.sampleCount == 0u)) {
+      accColor.a = inputColor.a;
+
+      imageStore(accumulateImage, ivec2(imgPosition), accColor);
+      pixelStatistics[pixelIndex] = statistics;
+    }
+
+    outColor = vec4(accColor.rgb, 1.0f);
+    return;
+  }
+
+  float sampleCount = float(statistics.sampleCount);
+  vec4 totalColor = vec4((inputColor.rgb + accColor.rgb * sampleCount) / (sampleCount + 1.0f), inputColor.a);
+
+  float luminance = dot(inputColor.rgb, vec3(0.2126f, 0.7152f, 0.0722f));
+  statistics.sampleCount++;
+
+  float delta = luminance - statistics.mean;
+  statistics.mean += delta / float(statistics.sampleCount);
+  statistics.m2 += delta * (luminance - statistics.mean);
 
-  vec4 totalColor = (inputColor / 255.0f + accColor * push.randomSeed) / (push.randomSeed + 1.0f);
+  pixelStatistics[pixelIndex] = statistics;
 
-  imageStore(accumulateImage, ivec2(gl_FragCoord.xy), totalColor);
-  outColor = totalColor; //imageLoad(inputImage, ivec2(gl_FragCoord.xy));
+  imageStore(accumulateImage, ivec2(imgPosition), totalColor);
+  outColor = vec4(totalColor.rgb, 1.0f);
 }
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 460
+
+layout(location = 0) in vec3 positionFrag;
+
+// Primitive index plus one, zero is left by the clear where nothing was drawn, and the primary hit distance.
+// The index buffer follows the primitive buffer, so gl_PrimitiveID is the primitive index.
+layout(location = 0) out uvec2 visibilityResource;
+
+void main() {
+	visibilityResource = uvec2(uint(gl_PrimitiveID) + 1u, floatBitsToUint(length(positionFrag)));
+}
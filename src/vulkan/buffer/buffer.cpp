@@ -232,6 +232,13 @@ namespace nugiEngine {
     bufferInfo.usage = bufferUsage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    auto queueFamilies = this->engineDevice.getBufferQueueFamilies();
+    if (queueFamilies.size() > 1) {
+      bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+      bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+    }
+
     VmaAllocationCreateInfo allocInfo{};
     allocInfo.usage = memoryUsage;
     allocInfo.flags = memoryPropertyFlags;
@@ -300,6 +307,44 @@ namespace nugiEngine {
       commandBuffer->submitCommand(this->engineDevice.getTransferQueue(0));
     }
   }
+
+  void EngineBuffer::copyImageToBuffer(VkImage image, uint32_t width, uint32_t height, uint32_t layerCount, std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+    bool isCommandBufferCreatedHere = false;
+    
+    if (commandBuffer == nullptr) {
+      commandBuffer = std::make_shared<EngineCommandBuffer>(this->engineDevice);
+      commandBuffer->beginSingleTimeCommand();
+
+      isCommandBufferCreatedHere = true;  
+    }
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = layerCount;
+
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {width, height, 1};
+
+    vkCmdCopyImageToBuffer(
+      commandBuffer->getCommandBuffer(),
+      image,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      this->buffer,
+      1,
+      &region
+    );
+
+    if (isCommandBufferCreatedHere) {
+      commandBuffer->endCommand();
+      commandBuffer->submitCommand(this->engineDevice.getTransferQueue(0));
+    }
+  }
   
  
 }  // namespace lve
\ No newline at end of file
@@ -6,20 +6,24 @@ namespace nugiEngine {
 	EngineCommandBuffer::~EngineCommandBuffer() {
 		vkFreeCommandBuffers(
       this->appDevice.getLogicalDevice(), 
-      this->appDevice.getCommandPool(), 
+      this->commandPool, 
       1, 
       &this->commandBuffer
     );
 	}
 
   std::vector<std::shared_ptr<EngineCommandBuffer>> EngineCommandBuffer::createCommandBuffers(EngineDevice &appDevice, uint32_t size) {
+		return EngineCommandBuffer::createCommandBuffers(appDevice, size, appDevice.getCommandPool());
+	}
+
+  std::vector<std::shared_ptr<EngineCommandBuffer>> EngineCommandBuffer::createCommandBuffers(EngineDevice &appDevice, uint32_t size, VkCommandPool commandPool) {
 		std::vector<VkCommandBuffer> commandBuffers{size};
 		std::vector<std::shared_ptr<EngineCommandBuffer>> appCommandBuffers;
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = appDevice.getCommandPool();
+		allocInfo.commandPool = commandPool;
 		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
 
 		if (vkAllocateCommandBuffers(appDevice.getLogicalDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
@@ -28,7 +32,7 @@ namespace nugiEngine {
 
 		for (size_t i = 0; i < size; i++) {
 			appCommandBuffers.push_back(
-				std::make_shared<EngineCommandBuffer>(appDevice, commandBuffers[i])
+				std::make_shared<EngineCommandBuffer>(appDevice, commandBuffers[i], commandPool)
 			);
 		}
 
@@ -36,16 +40,26 @@ namespace nugiEngine {
 	}
 
 	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device, VkCommandBuffer commandBuffer) 
-		: appDevice{device}, commandBuffer {commandBuffer} 
+		: EngineCommandBuffer(device, commandBuffer, device.getCommandPool()) 
 	{
 
 	}
 
-	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device) : appDevice{device} {
+	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device, VkCommandBuffer commandBuffer, VkCommandPool commandPool) 
+		: appDevice{device}, commandPool{commandPool}, commandBuffer {commandBuffer} 
+	{
+
+	}
+
+	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device) : EngineCommandBuffer(device, device.getCommandPool()) {
+
+	}
+
+	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device, VkCommandPool commandPool) : appDevice{device}, commandPool{commandPool} {
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = this->appDevice.getCommandPool();
+		allocInfo.commandPool = this->commandPool;
 		allocInfo.commandBufferCount = 1;
 
 		if (vkAllocateCommandBuffers(appDevice.getLogicalDevice(), &allocInfo, &this->commandBuffer) != VK_SUCCESS) {
@@ -108,7 +122,8 @@ namespace nugiEngine {
 			std::cerr << "Failed to submitting command buffer" << '\n';
 		}
 
-		if (vkQueueWaitIdle(queue) != VK_SUCCESS) {
+		// A fenced submit is tracked by its caller, everything else is a one time command that must be done on return
+		if (fence == VK_NULL_HANDLE && vkQueueWaitIdle(queue) != VK_SUCCESS) {
 			std::cerr << "Failed to waiting queue" << '\n';
 		}
 	}
@@ -148,7 +163,7 @@ namespace nugiEngine {
 			std::cerr << "Failed to submitting command buffer" << '\n';
 		}
 
-		if (vkQueueWaitIdle(queue) != VK_SUCCESS) {
+		if (fence == VK_NULL_HANDLE && vkQueueWaitIdle(queue) != VK_SUCCESS) {
 			std::cerr << "Failed to waiting queue" << '\n';
 		}
 		
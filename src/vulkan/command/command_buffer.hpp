@@ -10,7 +10,9 @@ namespace nugiEngine
   class EngineCommandBuffer {
     public:
       EngineCommandBuffer(EngineDevice& device, VkCommandBuffer commandBuffer);
+      EngineCommandBuffer(EngineDevice& device, VkCommandBuffer commandBuffer, VkCommandPool commandPool);
       EngineCommandBuffer(EngineDevice& device);
+      EngineCommandBuffer(EngineDevice& device, VkCommandPool commandPool);
 
       ~EngineCommandBuffer();
 
@@ -18,10 +20,12 @@ namespace nugiEngine
       EngineCommandBuffer& operator=(const EngineCommandBuffer&) = delete;
 
       static std::vector<std::shared_ptr<EngineCommandBuffer>> createCommandBuffers(EngineDevice &appDevice, uint32_t size);
+      static std::vector<std::shared_ptr<EngineCommandBuffer>> createCommandBuffers(EngineDevice &appDevice, uint32_t size, VkCommandPool commandPool);
 
       void beginSingleTimeCommand();
       void beginReccuringCommand();
       void endCommand();
+      // Without a fence the call waits until the queue is idle
       void submitCommand(VkQueue queue, std::vector<VkSemaphore> waitSemaphores = {}, 
         std::vector<VkPipelineStageFlags> waitStages = {}, std::vector<VkSemaphore> signalSemaphores = {}, 
         VkFence fence = VK_NULL_HANDLE);
@@ -34,6 +38,7 @@ namespace nugiEngine
 
     private:
       EngineDevice& appDevice;
+      VkCommandPool commandPool;
       VkCommandBuffer commandBuffer;
   };
   
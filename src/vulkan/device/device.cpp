@@ -4,6 +4,7 @@
 #include "vk_mem_alloc.h"
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -52,10 +53,18 @@ namespace nugiEngine {
   }
 
   // class member functions
-  EngineDevice::EngineDevice(EngineWindow &window) : window{window} {
+  EngineDevice::EngineDevice(EngineWindow *window) : window{window} {
+    if (this->isHeadless()) {
+      this->deviceExtensions.clear();
+    }
+
     this->createInstance();
     this->setupDebugMessenger();
-    this->createSurface();
+
+    if (!this->isHeadless()) {
+      this->createSurface();
+    }
+
     this->pickPhysicalDevice();
     this->msaaSamples = this->getMaxUsableFlagsCount();
     this->createLogicalDevice();
@@ -66,13 +75,25 @@ namespace nugiEngine {
   EngineDevice::~EngineDevice() {
     vmaDestroyAllocator(this->allocator);
     vkDestroyCommandPool(this->device, this->commandPool, nullptr);
+
+    if (this->streamingCommandPool != this->commandPool) {
+      vkDestroyCommandPool(this->device, this->streamingCommandPool, nullptr);
+    }
+
+    if (this->asyncComputeCommandPool != this->commandPool) {
+      vkDestroyCommandPool(this->device, this->asyncComputeCommandPool, nullptr);
+    }
+
     vkDestroyDevice(this->device, nullptr);
 
     if (enableValidationLayers) {
       DestroyDebugUtilsMessengerEXT(this->instance, this->debugMessenger, nullptr);
     }
 
-    vkDestroySurfaceKHR(this->instance, this->surface, nullptr);
+    if (this->surface != VK_NULL_HANDLE) {
+      vkDestroySurfaceKHR(this->instance, this->surface, nullptr);
+    }
+
     vkDestroyInstance(this->instance, nullptr);
   }
 
@@ -154,6 +175,20 @@ namespace nugiEngine {
       this->familyIndices.transferFamily
     };
 
+    if (this->familyIndices.dedicatedTransferFamilyHasValue) {
+      uniqueQueueFamilies.insert(this->familyIndices.dedicatedTransferFamily);
+    }
+
+    if (this->familyIndices.dedicatedComputeFamilyHasValue) {
+      uniqueQueueFamilies.insert(this->familyIndices.dedicatedComputeFamily);
+    }
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &queueFamilyCount, queueFamilies.data());
+
     std::vector<float> queuePriority;
 
     for (int i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
@@ -168,7 +203,7 @@ namespace nugiEngine {
       VkDeviceQueueCreateInfo queueCreateInfo = {};
       queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
       queueCreateInfo.queueFamilyIndex = queueFamily;
-      queueCreateInfo.queueCount = static_cast<uint32_t>(queuePriority.size());
+      queueCreateInfo.queueCount = std::min(static_cast<uint32_t>(queuePriority.size()), queueFamilies[queueFamily].queueCount);
       queueCreateInfo.pQueuePriorities = queuePriority.data();
       queueCreateInfos.push_back(queueCreateInfo);
     }
@@ -178,8 +213,13 @@ namespace nugiEngine {
     deviceFeatures.sampleRateShading = VK_TRUE;
     deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
 
+    VkPhysicalDeviceVulkan12Features deviceVulkan12Features = {};
+    deviceVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    deviceVulkan12Features.timelineSemaphore = VK_TRUE;
+
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &deviceVulkan12Features;
 
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -206,12 +246,36 @@ namespace nugiEngine {
     this->computeQueue.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
     this->transferQueue.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
 
-    for (int i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
-      vkGetDeviceQueue(this->device, this->familyIndices.graphicsFamily, i, &this->graphicsQueue[i]);
-      vkGetDeviceQueue(this->device, this->familyIndices.presentFamily, i, &this->presentQueue[i]);
-      vkGetDeviceQueue(this->device, this->familyIndices.computeFamily, i, &this->computeQueue[i]);
-      vkGetDeviceQueue(this->device, this->familyIndices.transferFamily, i, &this->transferQueue[i]);
+    // Families with fewer queues than frames in flight (e.g. software drivers expose only one) hand out the same queue again
+    auto queueIndex = [&queueFamilies] (uint32_t family, uint32_t i) { 
+      return std::min(i, queueFamilies[family].queueCount - 1); 
+    };
+
+    for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+      vkGetDeviceQueue(this->device, this->familyIndices.graphicsFamily, queueIndex(this->familyIndices.graphicsFamily, i), &this->graphicsQueue[i]);
+      vkGetDeviceQueue(this->device, this->familyIndices.presentFamily, queueIndex(this->familyIndices.presentFamily, i), &this->presentQueue[i]);
+      vkGetDeviceQueue(this->device, this->familyIndices.computeFamily, queueIndex(this->familyIndices.computeFamily, i), &this->computeQueue[i]);
+      vkGetDeviceQueue(this->device, this->familyIndices.transferFamily, queueIndex(this->familyIndices.transferFamily, i), &this->transferQueue[i]);
+    }
+
+    if (this->familyIndices.dedicatedTransferFamilyHasValue) {
+      this->streamingFamily = this->familyIndices.dedicatedTransferFamily;
+      vkGetDeviceQueue(this->device, this->streamingFamily, 0, &this->streamingQueue);
+    } else {
+      this->streamingFamily = this->familyIndices.graphicsFamily;
+      this->streamingQueue = this->graphicsQueue[0];
     }
+
+    if (this->familyIndices.dedicatedComputeFamilyHasValue) {
+      this->asyncComputeFamily = this->familyIndices.dedicatedComputeFamily;
+      vkGetDeviceQueue(this->device, this->asyncComputeFamily, 0, &this->asyncComputeQueue);
+    } else {
+      this->asyncComputeFamily = this->familyIndices.graphicsFamily;
+      this->asyncComputeQueue = this->graphicsQueue[0];
+    }
+
+    std::set<uint32_t> bufferFamilies = { this->familyIndices.graphicsFamily, this->streamingFamily, this->asyncComputeFamily };
+    this->bufferQueueFamilies.assign(bufferFamilies.begin(), bufferFamilies.end());
   }
 
   void EngineDevice::createMemoryAllocator() {
@@ -239,10 +303,29 @@ namespace nugiEngine {
     if (vkCreateCommandPool(this->device, &poolInfo, nullptr, &this->commandPool) != VK_SUCCESS) {
       throw std::runtime_error("failed to create command pool!");
     }
+
+    this->streamingCommandPool = this->commandPool;
+    this->asyncComputeCommandPool = this->commandPool;
+
+    if (this->streamingFamily != queueFamilyIndices.graphicsFamily) {
+      poolInfo.queueFamilyIndex = this->streamingFamily;
+
+      if (vkCreateCommandPool(this->device, &poolInfo, nullptr, &this->streamingCommandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create streaming command pool!");
+      }
+    }
+
+    if (this->asyncComputeFamily != queueFamilyIndices.graphicsFamily) {
+      poolInfo.queueFamilyIndex = this->asyncComputeFamily;
+
+      if (vkCreateCommandPool(this->device, &poolInfo, nullptr, &this->asyncComputeCommandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create async compute command pool!");
+      }
+    }
   }
 
   void EngineDevice::createSurface() { 
-    this->window.createWindowSurface(this->instance, &this->surface); 
+    this->window->createWindowSurface(this->instance, &this->surface); 
   }
 
   bool EngineDevice::isDeviceSuitable(VkPhysicalDevice device) {
@@ -250,8 +333,8 @@ namespace nugiEngine {
 
     bool extensionsSupported = this->checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
+    bool swapChainAdequate = this->isHeadless();
+    if (extensionsSupported && !this->isHeadless()) {
       SwapChainSupportDetails swapChainSupport = this->querySwapChainSupport(device);
       swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
@@ -311,11 +394,15 @@ namespace nugiEngine {
   }
 
   std::vector<const char *> EngineDevice::getRequiredExtensions() {
-    uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char *> extensions;
 
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    if (!this->isHeadless()) {
+      uint32_t glfwExtensionCount = 0;
+      const char **glfwExtensions;
+      glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+      extensions.insert(extensions.end(), glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers) {
       extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -394,8 +481,12 @@ namespace nugiEngine {
         indices.transferFamilyHasValue = true;
       }
 
-      VkBool32 presentSupport = false;
-      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, this->surface, &presentSupport);
+      // A headless device never presents, any graphics family will do
+      VkBool32 presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+      if (this->surface != VK_NULL_HANDLE) {
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, this->surface, &presentSupport);
+      }
+
       if (queueFamily.queueCount > 0 && presentSupport) {
         indices.presentFamily = i;
         indices.presentFamilyHasValue = true;
@@ -408,6 +499,26 @@ namespace nugiEngine {
       i++;
     }
 
+    for (uint32_t j = 0; j < queueFamilyCount; j++) {
+      VkQueueFlags queueFlags = queueFamilies[j].queueFlags;
+
+      if (queueFamilies[j].queueCount > 0 && (queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+        indices.dedicatedTransferFamily = j;
+        indices.dedicatedTransferFamilyHasValue = true;
+        break;
+      }
+    }
+
+    for (uint32_t j = 0; j < queueFamilyCount; j++) {
+      VkQueueFlags queueFlags = queueFamilies[j].queueFlags;
+
+      if (queueFamilies[j].queueCount > 0 && (queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+        indices.dedicatedComputeFamily = j;
+        indices.dedicatedComputeFamilyHasValue = true;
+        break;
+      }
+    }
+
     return indices;
   }
 
@@ -19,11 +19,15 @@ namespace nugiEngine {
     uint32_t presentFamily;
     uint32_t computeFamily;
     uint32_t transferFamily;
+    uint32_t dedicatedTransferFamily; // transfer only family, usually backed by the copy engine
+    uint32_t dedicatedComputeFamily; // compute without graphics, runs beside the graphics queue
 
     bool graphicsFamilyHasValue = false;
     bool presentFamilyHasValue = false;
     bool computeFamilyHasValue = false;
     bool transferFamilyHasValue = false;
+    bool dedicatedTransferFamilyHasValue = false;
+    bool dedicatedComputeFamilyHasValue = false;
 
     bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue && computeFamilyHasValue && transferFamilyHasValue; }
   };
@@ -36,9 +40,10 @@ namespace nugiEngine {
       const bool enableValidationLayers = true;
     #endif
 
-      static constexpr int MAX_FRAMES_IN_FLIGHT = 1;
+      static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
-      EngineDevice(EngineWindow &window);
+      // Without a window the device is headless: no surface, no swapchain extension and no present queue requirement
+      EngineDevice(EngineWindow *window);
       ~EngineDevice();
       
       VkDevice getLogicalDevice() const { return this->device; }
@@ -47,12 +52,27 @@ namespace nugiEngine {
       VmaAllocator getMemoryAllocator() const { return this->allocator; }
       VkCommandPool getCommandPool() const { return this->commandPool; }
       VkSurfaceKHR getSurface() const { return this->surface; }
+      bool isHeadless() const { return this->window == nullptr; }
 
       VkQueue getGraphicsQueue(uint32_t index) const { return this->graphicsQueue[index]; }
       VkQueue getPresentQueue(uint32_t index) const { return this->presentQueue[index]; }
       VkQueue getComputeQueue(uint32_t index) const { return this->computeQueue[index]; }
       VkQueue getTransferQueue(uint32_t index) const { return this->transferQueue[index]; }
 
+      // Streaming uploads go to the dedicated transfer family when there is one, otherwise to the graphics family
+      VkQueue getStreamingQueue() const { return this->streamingQueue; }
+      VkCommandPool getStreamingCommandPool() const { return this->streamingCommandPool; }
+      uint32_t getStreamingFamily() const { return this->streamingFamily; }
+
+      // Async compute goes to the dedicated compute family when there is one, otherwise to the graphics family
+      VkQueue getAsyncComputeQueue() const { return this->asyncComputeQueue; }
+      VkCommandPool getAsyncComputeCommandPool() const { return this->asyncComputeCommandPool; }
+      uint32_t getAsyncComputeFamily() const { return this->asyncComputeFamily; }
+
+      // Every family above that touches buffers. With more than one, buffers are shared concurrently instead of 
+      // being handed over, only images keep exclusive ownership.
+      std::vector<uint32_t> getBufferQueueFamilies() const { return this->bufferQueueFamilies; }
+
       QueueFamilyIndices getFamilyIndices() const { return this->familyIndices; }
       
       VkPhysicalDeviceProperties getProperties() const { return this->properties; }
@@ -94,17 +114,24 @@ namespace nugiEngine {
       VkPhysicalDeviceProperties properties;
 
       // window system
-      EngineWindow &window;
-      VkSurfaceKHR surface;
+      EngineWindow *window;
+      VkSurfaceKHR surface = VK_NULL_HANDLE;
 
       // memory allocator
       VmaAllocator allocator;
 
       // command pool
       VkCommandPool commandPool;
+      VkCommandPool streamingCommandPool;
+      VkCommandPool asyncComputeCommandPool;
 
       // queue
       std::vector<VkQueue> graphicsQueue, presentQueue, computeQueue, transferQueue;
+      VkQueue streamingQueue;
+      uint32_t streamingFamily;
+      VkQueue asyncComputeQueue;
+      uint32_t asyncComputeFamily;
+      std::vector<uint32_t> bufferQueueFamilies;
 
       // Queue Family Index
       QueueFamilyIndices familyIndices;
@@ -113,7 +140,7 @@ namespace nugiEngine {
       VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
       const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-      const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+      std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
   };
 
 }  // namespace lve
\ No newline at end of file
@@ -112,4 +112,8 @@ namespace nugiEngine {
 		vkCmdDispatch(commandBuffer, xSize, ySize, zSize);
 	}
 
+	void EngineComputePipeline::dispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) {
+		vkCmdDispatchIndirect(commandBuffer, buffer, offset);
+	}
+
 } // namespace nugiEngine
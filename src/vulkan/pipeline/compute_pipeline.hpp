@@ -41,6 +41,7 @@ namespace nugiEngine {
 
 			void bind(VkCommandBuffer commandBuffer);
 			void dispatch(VkCommandBuffer commandBuffer, uint32_t xSize, uint32_t ySize, uint32_t zSize);
+			void dispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset);
 
 		private:
 			EngineDevice& engineDevice;
@@ -0,0 +1,74 @@
+#include "timestamp_query.hpp"
+
+#include <stdexcept>
+
+namespace nugiEngine {
+  EngineTimestampQuery::EngineTimestampQuery(EngineDevice &device, uint32_t frameCount, uint32_t queueFamily) 
+    : appDevice{device}, isWritten(frameCount, false)
+  {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+    uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+    this->timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1ull);
+    this->timestampPeriod = device.getProperties().limits.timestampPeriod;
+
+    if (!this->isSupported()) {
+      return;
+    }
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = 2 * frameCount;
+
+    if (vkCreateQueryPool(device.getLogicalDevice(), &poolInfo, nullptr, &this->queryPool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create timestamp query pool!");
+    }
+  }
+
+  EngineTimestampQuery::~EngineTimestampQuery() {
+    if (this->queryPool != VK_NULL_HANDLE) {
+      vkDestroyQueryPool(this->appDevice.getLogicalDevice(), this->queryPool, nullptr);
+    }
+  }
+
+  void EngineTimestampQuery::begin(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
+    if (!this->isSupported()) {
+      return;
+    }
+
+    vkCmdResetQueryPool(commandBuffer->getCommandBuffer(), this->queryPool, 2 * frameIndex, 2);
+    vkCmdWriteTimestamp(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->queryPool, 2 * frameIndex);
+  }
+
+  void EngineTimestampQuery::end(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
+    if (!this->isSupported()) {
+      return;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer->getCommandBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->queryPool, 2 * frameIndex + 1);
+  }
+
+  bool EngineTimestampQuery::getDuration(uint32_t frameIndex, float &milliseconds) {
+    if (!this->isSupported() || !this->isWritten[frameIndex]) {
+      return false;
+    }
+
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(this->appDevice.getLogicalDevice(), this->queryPool, 2 * frameIndex, 2, 
+      sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+    if (result != VK_SUCCESS) {
+      return false;
+    }
+
+    uint64_t ticks = (timestamps[1] - timestamps[0]) & this->timestampMask;
+    milliseconds = static_cast<float>(static_cast<double>(ticks) * this->timestampPeriod / 1000000.0);
+
+    return true;
+  }
+} // namespace nugiEngine
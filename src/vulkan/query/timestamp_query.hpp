@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../device/device.hpp"
+#include "../command/command_buffer.hpp"
+
+#include <vector>
+#include <memory>
+
+namespace nugiEngine {
+  // A begin and end timestamp per frame slot, recorded on one queue family. 
+  // The result of a slot is read back once its frame fence has been waited for.
+  class EngineTimestampQuery {
+    public:
+      EngineTimestampQuery(EngineDevice &device, uint32_t frameCount, uint32_t queueFamily);
+      ~EngineTimestampQuery();
+
+      EngineTimestampQuery(const EngineTimestampQuery&) = delete;
+      EngineTimestampQuery& operator = (const EngineTimestampQuery&) = delete;
+
+      // Some families (e.g. dedicated transfer or compute ones) have no timestamps at all
+      bool isSupported() const { return this->timestampMask != 0; }
+
+      // Resets the pair of the slot and writes its first timestamp, both must be in the same command buffer
+      void begin(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+      void end(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+
+      // Marks the slot as submitted, so that its result may be read after the next wait on its fence
+      void submitted(uint32_t frameIndex) { this->isWritten[frameIndex] = true; }
+
+      // Milliseconds between both timestamps of the slot, false if there is no result yet
+      bool getDuration(uint32_t frameIndex, float &milliseconds);
+
+    private:
+      EngineDevice &appDevice;
+      VkQueryPool queryPool = VK_NULL_HANDLE;
+
+      std::vector<bool> isWritten;
+      uint64_t timestampMask = 0;
+      float timestampPeriod = 1.0f;
+  };
+} // namespace nugiEngine
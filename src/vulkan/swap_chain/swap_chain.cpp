@@ -23,6 +23,11 @@ namespace nugiEngine {
       this->oldSwapChain = nullptr;
   }
 
+  EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent, uint32_t imageCount) 
+    : device{deviceRef}, windowExtent{extent} {
+      this->createOffscreenImages(imageCount);
+  }
+
   EngineSwapChain::~EngineSwapChain() {
     if (swapChain != nullptr) {
       vkDestroySwapchainKHR(this->device.getLogicalDevice(), this->swapChain, nullptr);
@@ -39,6 +44,13 @@ namespace nugiEngine {
       std::numeric_limits<uint64_t>::max()
     );
 
+    if (this->isOffscreen()) {
+      *imageIndex = this->nextOffscreenImage;
+      this->nextOffscreenImage = (this->nextOffscreenImage + 1) % static_cast<uint32_t>(this->swapChainImages.size());
+
+      return VK_SUCCESS;
+    }
+
     VkResult result = vkAcquireNextImageKHR(
       this->device.getLogicalDevice(),
       this->swapChain,
@@ -52,6 +64,10 @@ namespace nugiEngine {
   }
 
   VkResult EngineSwapChain::presentRenders(VkQueue queue, uint32_t *imageIndex, std::vector<VkSemaphore> waitSemaphores) {
+    if (this->isOffscreen()) {
+      return VK_SUCCESS;
+    }
+
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -137,6 +153,24 @@ namespace nugiEngine {
     }
   }
 
+  void EngineSwapChain::createOffscreenImages(uint32_t imageCount) {
+    this->swapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    this->swapChainExtent = this->windowExtent;
+
+    this->swapChainImages.clear();
+    for (uint32_t i = 0; i < imageCount; i++) {
+      auto offscreenImage = std::make_shared<EngineImage>(
+        this->device, this->swapChainExtent.width, this->swapChainExtent.height, 
+        1, VK_SAMPLE_COUNT_1_BIT, this->swapChainImageFormat, 
+        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 
+        VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
+        VK_IMAGE_ASPECT_COLOR_BIT
+      );
+
+      this->swapChainImages.push_back(offscreenImage);
+    }
+  }
+
   VkSurfaceFormatKHR EngineSwapChain::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats) {
     for (const auto &availableFormat : availableFormats) {
       if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
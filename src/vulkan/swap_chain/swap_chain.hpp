@@ -19,6 +19,9 @@ namespace nugiEngine {
     EngineSwapChain(EngineDevice &deviceRef, VkExtent2D windowExtent);
     EngineSwapChain(EngineDevice &deviceref, VkExtent2D windowExtent, std::shared_ptr<EngineSwapChain> previous);
 
+    // Offscreen chain for headless devices: plain images that are never presented and can be copied from
+    EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent, uint32_t imageCount);
+
     ~EngineSwapChain();
 
     EngineSwapChain(const EngineSwapChain &) = delete;
@@ -42,16 +45,24 @@ namespace nugiEngine {
       return swapChain.swapChainImageFormat == this->swapChainImageFormat;
     }
 
+    bool isOffscreen() const { return this->swapChain == VK_NULL_HANDLE; }
+
+    // The layout the images are left in at the end of a frame
+    VkImageLayout getPresentLayout() const { 
+      return this->isOffscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    }
+
   private:
     void init();
     void createSwapChain();
+    void createOffscreenImages(uint32_t imageCount);
 
     // Helper functions
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes);
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
 
-    VkSwapchainKHR swapChain;
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
     std::shared_ptr<EngineSwapChain> oldSwapChain;
 
     VkFormat swapChainImageFormat;
@@ -63,5 +74,6 @@ namespace nugiEngine {
     VkExtent2D windowExtent;
 
     size_t currentFrame = 0;
+    uint32_t nextOffscreenImage = 0;
   };
 }
@@ -11,8 +11,8 @@
 #include "../command/command_buffer.hpp"
 
 namespace nugiEngine {
-  EngineTexture::EngineTexture(EngineDevice &appDevice, const char* textureFileName) : appDevice{appDevice} {
-    this->createTextureImage(textureFileName);
+  EngineTexture::EngineTexture(EngineDevice &appDevice, const char* textureFileName, std::shared_ptr<EngineBufferUploader> uploader) : appDevice{appDevice} {
+    this->createTextureImage(textureFileName, uploader);
     this->createTextureSampler();
   }
 
@@ -20,7 +20,7 @@ namespace nugiEngine {
     vkDestroySampler(this->appDevice.getLogicalDevice(), this->sampler, nullptr);
   }
 
-  void EngineTexture::createTextureImage(const char* textureFileName) {
+  void EngineTexture::createTextureImage(const char* textureFileName, std::shared_ptr<EngineBufferUploader> uploader) {
     int texWidth, texHeight, texChannels;
     stbi_uc* pixels = stbi_load(textureFileName, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
     VkDeviceSize imageSize = texWidth * texHeight * 4;
@@ -31,35 +31,18 @@ namespace nugiEngine {
 
     this->mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
-    unsigned long pixelSize = 4;
-    uint32_t pixelCount = texWidth * texHeight;
-
-    EngineBuffer stagingBuffer {
-			this->appDevice,
-			pixelSize,
-			pixelCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VMA_MEMORY_USAGE_AUTO,
-			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-		};
-
-    stagingBuffer.map();
-    stagingBuffer.writeToBuffer(pixels);
-    stagingBuffer.unmap();
-
-    stbi_image_free(pixels);
-
     this->image = std::make_unique<EngineImage>(this->appDevice, texWidth, texHeight, this->mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, 
       VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
       VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, 
       VK_IMAGE_ASPECT_COLOR_BIT);
 
-    this->image->transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
-      0, VK_ACCESS_TRANSFER_WRITE_BIT);
-      
-    stagingBuffer.copyBufferToImage(this->image->getImage(), static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-    this->image->generateMipMap();
+    if (uploader == nullptr) {
+      uploader = std::make_shared<EngineBufferUploader>(this->appDevice, imageSize);
+    }
+
+    // The uploader copies the pixels into its staging memory and builds the mip chain once the copy has landed
+    uploader->uploadImage(*this->image, pixels, imageSize, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+    stbi_image_free(pixels);
     // this->image->transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
   }
 
@@ -8,6 +8,7 @@
 #include "../buffer/buffer.hpp"
 #include "../command/command_buffer.hpp"
 #include "../image/image.hpp"
+#include "../uploader/buffer_uploader.hpp"
 
 #include <memory>
 
@@ -16,7 +17,7 @@ namespace nugiEngine
   class EngineTexture
   {
     public:
-      EngineTexture(EngineDevice &appDevice, const char* textureFileName);
+      EngineTexture(EngineDevice &appDevice, const char* textureFileName, std::shared_ptr<EngineBufferUploader> uploader = nullptr);
       ~EngineTexture();
 
       VkDescriptorImageInfo getDescriptorInfo();
@@ -28,7 +29,7 @@ namespace nugiEngine
       VkSampler sampler;
       uint32_t mipLevels;
 
-      void createTextureImage(const char* textureFileName);
+      void createTextureImage(const char* textureFileName, std::shared_ptr<EngineBufferUploader> uploader);
       void createTextureSampler();
   };
   
@@ -0,0 +1,327 @@
+#include "buffer_uploader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace nugiEngine {
+  EngineBufferUploader::EngineBufferUploader(EngineDevice &device, VkDeviceSize stagingSize) : engineDevice{device}, stagingSize{stagingSize} {
+    this->createSyncObjects();
+  }
+
+  EngineBufferUploader::~EngineBufferUploader() {
+    this->flush();
+
+    vkDestroySemaphore(this->engineDevice.getLogicalDevice(), this->transferSemaphore, nullptr);
+    vkDestroySemaphore(this->engineDevice.getLogicalDevice(), this->completeSemaphore, nullptr);
+  }
+
+  void EngineBufferUploader::createSyncObjects() {
+    VkSemaphoreTypeCreateInfo semaphoreTypeInfo{};
+    semaphoreTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &semaphoreTypeInfo;
+
+    if (vkCreateSemaphore(this->engineDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->transferSemaphore) != VK_SUCCESS ||
+        vkCreateSemaphore(this->engineDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->completeSemaphore) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create upload timeline semaphores!");
+    }
+  }
+
+  void EngineBufferUploader::upload(EngineBuffer &dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset) {
+    std::lock_guard<std::mutex> lock(this->batchMutex);
+    VkDeviceSize uploadedSize = 0;
+
+    // Uploads bigger than the ring go through in ring-sized pieces
+    while (uploadedSize < size) {
+      VkDeviceSize copySize = std::min(size - uploadedSize, this->stagingSize);
+      UploadBatch &batch = this->reserveBatch(copySize);
+
+      batch.stagingBuffer->writeToBuffer((void *) (static_cast<const char *>(data) + uploadedSize), copySize, batch.stagingOffset);
+      batch.bufferCopies.emplace_back(BufferCopy{ dstBuffer.getBuffer(), VkBufferCopy{ batch.stagingOffset, dstOffset + uploadedSize, copySize } });
+
+      // keep every region aligned for the next copy
+      batch.stagingOffset = std::min(batch.stagingBuffer->getBufferSize(), (batch.stagingOffset + copySize + 15) & ~VkDeviceSize(15));
+      uploadedSize += copySize;
+    }
+  }
+
+  void EngineBufferUploader::uploadImage(EngineImage &dstImage, const void *data, VkDeviceSize size, uint32_t width, uint32_t height) {
+    std::lock_guard<std::mutex> lock(this->batchMutex);
+    UploadBatch &batch = this->reserveBatch(size);
+
+    batch.stagingBuffer->writeToBuffer((void *) data, size, batch.stagingOffset);
+    batch.imageCopies.emplace_back(ImageCopy{ &dstImage, batch.stagingOffset, width, height });
+
+    batch.stagingOffset = std::min(batch.stagingBuffer->getBufferSize(), (batch.stagingOffset + size + 15) & ~VkDeviceSize(15));
+  }
+
+  std::shared_future<void> EngineBufferUploader::submit(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(this->batchMutex);
+
+    // An empty batch only carries the promise, it completes together with the batches before it
+    if (this->currentBatch == nullptr) {
+      this->currentBatch = std::make_unique<UploadBatch>();
+    }
+
+    auto promise = std::make_shared<std::promise<void>>();
+    this->currentBatch->promises.emplace_back(promise);
+
+    if (callback) {
+      this->currentBatch->callbacks.emplace_back(callback);
+    }
+
+    this->closeBatch();
+    return promise->get_future().share();
+  }
+
+  void EngineBufferUploader::update() {
+    std::deque<std::unique_ptr<UploadBatch>> batches;
+
+    {
+      std::lock_guard<std::mutex> lock(this->batchMutex);
+      batches.swap(this->closedBatches);
+    }
+
+    for (auto &&batch : batches) {
+      this->recordBatch(*batch);
+      this->inFlightBatches.emplace_back(std::move(batch));
+    }
+
+    this->retireBatches();
+  }
+
+  void EngineBufferUploader::flush() {
+    {
+      std::lock_guard<std::mutex> lock(this->batchMutex);
+      this->closeBatch();
+    }
+
+    this->update();
+
+    if (!this->inFlightBatches.empty()) {
+      VkSemaphoreWaitInfo waitInfo{};
+      waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+      waitInfo.semaphoreCount = 1;
+      waitInfo.pSemaphores = &this->completeSemaphore;
+      waitInfo.pValues = &this->completeValue;
+
+      vkWaitSemaphores(this->engineDevice.getLogicalDevice(), &waitInfo, UINT64_MAX);
+    }
+
+    this->retireBatches();
+  }
+
+  // Called with batchMutex held. A batch that cannot take the upload anymore is closed and a new one started.
+  EngineBufferUploader::UploadBatch &EngineBufferUploader::reserveBatch(VkDeviceSize size) {
+    if (this->currentBatch != nullptr && this->currentBatch->stagingOffset + size > this->currentBatch->stagingBuffer->getBufferSize()) {
+      this->closeBatch();
+    }
+
+    if (this->currentBatch != nullptr) {
+      return *this->currentBatch;
+    }
+
+    this->currentBatch = std::make_unique<UploadBatch>();
+
+    if (size <= this->stagingSize && !this->freeStagingBuffers.empty()) {
+      this->currentBatch->stagingBuffer = std::move(this->freeStagingBuffers.back());
+      this->freeStagingBuffers.pop_back();
+
+      return *this->currentBatch;
+    }
+
+    this->currentBatch->stagingBuffer = std::make_unique<EngineBuffer>(
+      this->engineDevice,
+      std::max(size, this->stagingSize),
+      1,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VMA_MEMORY_USAGE_AUTO,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+    );
+
+    this->currentBatch->stagingBuffer->map();
+    return *this->currentBatch;
+  }
+
+  // Called with batchMutex held
+  void EngineBufferUploader::closeBatch() {
+    if (this->currentBatch == nullptr) {
+      return;
+    }
+
+    this->closedBatches.emplace_back(std::move(this->currentBatch));
+  }
+
+  void EngineBufferUploader::recordBatch(UploadBatch &batch) {
+    if (batch.bufferCopies.empty() && batch.imageCopies.empty()) {
+      batch.completeValue = this->completeValue;
+      return;
+    }
+
+    uint32_t streamingFamily = this->engineDevice.getStreamingFamily();
+    uint32_t graphicsFamily = this->engineDevice.getFamilyIndices().graphicsFamily;
+    bool isOwnershipTransferred = streamingFamily != graphicsFamily;
+
+    // A streaming family of its own may be transfer only and support none of the reads that follow. The buffer copies are then 
+    // only made available here, the timeline semaphore the graphics queue waits on makes them visible there.
+    VkAccessFlags readAccess = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    VkPipelineStageFlags readStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    if (isOwnershipTransferred) {
+      readAccess = 0;
+      readStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+
+    batch.stagingBuffer->flush();
+
+    batch.transferCommandBuffer = std::make_shared<EngineCommandBuffer>(this->engineDevice, this->engineDevice.getStreamingCommandPool());
+    batch.transferCommandBuffer->beginSingleTimeCommand();
+
+    VkCommandBuffer commandBuffer = batch.transferCommandBuffer->getCommandBuffer();
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+    for (auto &&copy : batch.bufferCopies) {
+      vkCmdCopyBuffer(commandBuffer, batch.stagingBuffer->getBuffer(), copy.dstBuffer, 1, &copy.region);
+
+      // Buffers are concurrent whenever more than one family is in use, so they never change owner
+      VkBufferMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = readAccess;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.buffer = copy.dstBuffer;
+      barrier.offset = copy.region.dstOffset;
+      barrier.size = copy.region.size;
+
+      bufferBarriers.emplace_back(barrier);
+    }
+
+    for (auto &&copy : batch.imageCopies) {
+      copy.dstImage->transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, batch.transferCommandBuffer);
+
+      VkBufferImageCopy region{};
+      region.bufferOffset = copy.srcOffset;
+      region.imageSubresource.aspectMask = copy.dstImage->getAspectFlag();
+      region.imageSubresource.mipLevel = 0;
+      region.imageSubresource.baseArrayLayer = 0;
+      region.imageSubresource.layerCount = 1;
+      region.imageExtent = { copy.width, copy.height, 1 };
+
+      vkCmdCopyBufferToImage(commandBuffer, batch.stagingBuffer->getBuffer(), copy.dstImage->getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    // Release: make the copies available and, across families, hand the images over to the graphics queue
+    if (!bufferBarriers.empty()) {
+      vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, readStage,
+        0, 0, nullptr, static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(), 0, nullptr);
+    }
+
+    for (auto &&copy : batch.imageCopies) {
+      if (isOwnershipTransferred) {
+        copy.dstImage->transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+          streamingFamily, graphicsFamily, batch.transferCommandBuffer);
+      } else {
+        copy.dstImage->generateMipMap(batch.transferCommandBuffer);
+      }
+    }
+
+    batch.transferCommandBuffer->endCommand();
+
+    if (!isOwnershipTransferred) {
+      this->submitBatch(this->engineDevice.getStreamingQueue(), batch.transferCommandBuffer, VK_NULL_HANDLE, 0,
+        this->completeSemaphore, ++this->completeValue);
+
+      batch.completeValue = this->completeValue;
+      return;
+    }
+
+    this->submitBatch(this->engineDevice.getStreamingQueue(), batch.transferCommandBuffer, VK_NULL_HANDLE, 0,
+      this->transferSemaphore, ++this->transferValue);
+
+    // Acquire: the matching image barriers on the graphics queue, which also builds the mip chains since blits need a graphics queue.
+    // The semaphore wait alone makes the buffer copies visible there.
+    batch.acquireCommandBuffer = std::make_shared<EngineCommandBuffer>(this->engineDevice);
+    batch.acquireCommandBuffer->beginSingleTimeCommand();
+
+    for (auto &&copy : batch.imageCopies) {
+      copy.dstImage->transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+        streamingFamily, graphicsFamily, batch.acquireCommandBuffer);
+
+      copy.dstImage->generateMipMap(batch.acquireCommandBuffer);
+    }
+
+    batch.acquireCommandBuffer->endCommand();
+
+    this->submitBatch(this->engineDevice.getGraphicsQueue(0), batch.acquireCommandBuffer, this->transferSemaphore, this->transferValue,
+      this->completeSemaphore, ++this->completeValue);
+
+    batch.completeValue = this->completeValue;
+  }
+
+  void EngineBufferUploader::submitBatch(VkQueue queue, std::shared_ptr<EngineCommandBuffer> commandBuffer, VkSemaphore waitSemaphore, uint64_t waitValue,
+    VkSemaphore signalSemaphore, uint64_t signalValue)
+  {
+    VkCommandBuffer submittedCommandBuffer = commandBuffer->getCommandBuffer();
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    uint32_t waitCount = waitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = waitCount;
+    timelineInfo.pWaitSemaphoreValues = &waitValue;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = waitCount;
+    submitInfo.pWaitSemaphores = &waitSemaphore;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &submittedCommandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &signalSemaphore;
+
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+      throw std::runtime_error("failed to submit upload command buffer!");
+    }
+
+    this->submitCount++;
+  }
+
+  void EngineBufferUploader::retireBatches() {
+    uint64_t finishedValue = 0;
+    vkGetSemaphoreCounterValue(this->engineDevice.getLogicalDevice(), this->completeSemaphore, &finishedValue);
+
+    while (!this->inFlightBatches.empty() && this->inFlightBatches.front()->completeValue <= finishedValue) {
+      auto batch = std::move(this->inFlightBatches.front());
+      this->inFlightBatches.pop_front();
+
+      for (auto &&callback : batch->callbacks) {
+        callback();
+      }
+
+      for (auto &&promise : batch->promises) {
+        promise->set_value();
+      }
+
+      // Oversized staging buffers of big images are dropped, ring sized ones are reused by later batches
+      if (batch->stagingBuffer != nullptr && batch->stagingBuffer->getBufferSize() == this->stagingSize) {
+        std::lock_guard<std::mutex> lock(this->batchMutex);
+        this->freeStagingBuffers.emplace_back(std::move(batch->stagingBuffer));
+      }
+    }
+  }
+} // namespace nugiEngine
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../device/device.hpp"
+#include "../buffer/buffer.hpp"
+#include "../image/image.hpp"
+#include "../command/command_buffer.hpp"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+#include <memory>
+
+namespace nugiEngine {
+  // Collects buffer and image uploads into staging rings and hands them to the GPU in batches.
+  //
+  // upload() and uploadImage() only copy into host visible staging memory, so any thread may call them
+  // (e.g. a scene loader running beside the render loop). Recording and submitting happens in update() and
+  // flush(), which must be called from the thread that owns the graphics queue. Batches run on the streaming
+  // queue of the device; when that is a dedicated transfer family, every image is released to the graphics
+  // family and acquired there again (buffers are shared concurrently). Completion is tracked with timeline semaphores.
+  class EngineBufferUploader {
+    public:
+      static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32 * 1024 * 1024;
+
+      EngineBufferUploader(EngineDevice &device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+      ~EngineBufferUploader();
+
+      EngineBufferUploader(const EngineBufferUploader&) = delete;
+      EngineBufferUploader& operator = (const EngineBufferUploader&) = delete;
+
+      // The data is copied into the staging ring right away, so it does not need to outlive the call.
+      // The destination must stay alive until the batch holding the upload has completed.
+      void upload(EngineBuffer &dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+      // Fills every mip level of an RGBA8 image, which ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+      void uploadImage(EngineImage &dstImage, const void *data, VkDeviceSize size, uint32_t width, uint32_t height);
+
+      // Closes the current batch. The future is ready and the callback has run (on the thread calling update)
+      // once the GPU finished this batch and every batch closed before it.
+      std::shared_future<void> submit(std::function<void()> callback = nullptr);
+
+      // Records and submits the closed batches, then retires the ones the GPU has finished
+      void update();
+
+      // Submits everything uploaded so far and waits for it
+      void flush();
+
+      uint32_t getSubmitCount() const { return this->submitCount; }
+
+    private:
+      struct BufferCopy {
+        VkBuffer dstBuffer;
+        VkBufferCopy region;
+      };
+
+      struct ImageCopy {
+        EngineImage *dstImage;
+        VkDeviceSize srcOffset;
+        uint32_t width, height;
+      };
+
+      struct UploadBatch {
+        std::unique_ptr<EngineBuffer> stagingBuffer;
+        VkDeviceSize stagingOffset = 0;
+
+        std::vector<BufferCopy> bufferCopies;
+        std::vector<ImageCopy> imageCopies;
+
+        std::shared_ptr<EngineCommandBuffer> transferCommandBuffer;
+        std::shared_ptr<EngineCommandBuffer> acquireCommandBuffer;
+
+        std::vector<std::function<void()>> callbacks;
+        std::vector<std::shared_ptr<std::promise<void>>> promises;
+
+        uint64_t completeValue = 0;
+      };
+
+      EngineDevice &engineDevice;
+      VkDeviceSize stagingSize;
+
+      std::mutex batchMutex;
+      std::unique_ptr<UploadBatch> currentBatch;
+      std::deque<std::unique_ptr<UploadBatch>> closedBatches;
+      std::vector<std::unique_ptr<EngineBuffer>> freeStagingBuffers;
+
+      std::deque<std::unique_ptr<UploadBatch>> inFlightBatches;
+
+      // Each semaphore is only signaled from one queue, so its values always increase in submission order
+      VkSemaphore transferSemaphore, completeSemaphore;
+      uint64_t transferValue = 0, completeValue = 0;
+
+      uint32_t submitCount = 0;
+
+      void createSyncObjects();
+
+      UploadBatch &reserveBatch(VkDeviceSize size);
+      void closeBatch();
+
+      void recordBatch(UploadBatch &batch);
+      void submitBatch(VkQueue queue, std::shared_ptr<EngineCommandBuffer> commandBuffer, VkSemaphore waitSemaphore, uint64_t waitValue,
+        VkSemaphore signalSemaphore, uint64_t signalValue);
+      void retireBatches();
+  };
+} // namespace nugiEngine